@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench.h
+/// @brief Helpers for the microbenchmarks
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/// @brief current time in seconds (CLOCK_MONOTONIC)
+static inline double bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// @brief print the result of a benchmark as one JSON object per line. The version under test is
+///        taken from the environment variable BENCH_VERSION.
+/// @param name benchmark name
+/// @param threads number of threads
+/// @param ops number of operations
+/// @param bytes number of bytes processed (0 if not applicable)
+/// @param seconds elapsed time in seconds
+static inline void bench_report(const char *name, int threads, unsigned long ops,
+                                unsigned long bytes, double seconds)
+{
+  const char *version = getenv("BENCH_VERSION");
+
+  printf("{\"version\":\"%s\",\"bench\":\"%s\",\"threads\":%d,\"ops\":%lu,\"seconds\":%.6f,"
+         "\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f",
+         version ? version : "unknown", name, threads, ops, seconds,
+         seconds * 1e9 / ops, ops / seconds);
+  if (bytes > 0) printf(",\"mb_per_sec\":%.2f", bytes / seconds / 1e6);
+  printf("}\n");
+  fflush(stdout);
+}
+
+#endif // __BENCH_H__
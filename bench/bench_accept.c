@@ -0,0 +1,283 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_accept.c
+/// @brief Connection storm: accepted connections per second of the server
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "net.h"
+#include "stats.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define THREADS 16                                        ///< default connecting threads
+#define SECONDS 2.0                                       ///< default duration of a storm
+#define OLD_BACKLOG 32                                    ///< backlog before it was configurable
+#define LATENCY_MAX (1 << 20)                             ///< connect latencies kept per thread
+#define SERVER "./mcdonalds"                              ///< server under test
+#define PORT_STORM 7796                                   ///< TCP port of the server under test
+#define STATS_STORM "/bench_accept.stats"                 ///< statistics of the server
+
+/// @}
+
+/// @brief a connecting thread
+typedef struct {
+  pthread_t tid;                                            ///< thread
+  double until;                                             ///< end of the storm
+  unsigned long connects;                                   ///< connections established
+  unsigned long failed;                                     ///< connections refused or failed
+  double *latency;                                          ///< connect latencies (us)
+  unsigned long n;                                          ///< latencies kept
+} Storm;
+
+/// @brief read a counter of the TCP extensions from /proc/net/netstat
+/// @param name name of the counter
+/// @retval value
+/// @retval 0 if unknown
+static unsigned long tcp_ext(const char *name)
+{
+  char names[4096], values[4096], *np, *vp, *ns, *vs;
+  unsigned long v = 0;
+  FILE *f;
+
+  if ((f = fopen("/proc/net/netstat", "r")) == NULL) return 0;
+  // Lines come in pairs: the names of the counters, then their values
+  while (fgets(names, sizeof(names), f) && fgets(values, sizeof(values), f)) {
+    if (strncmp(names, "TcpExt:", 7) != 0) continue;
+    np = strtok_r(names, " \n", &ns);
+    vp = strtok_r(values, " \n", &vs);
+    while ((np = strtok_r(NULL, " \n", &ns)) && (vp = strtok_r(NULL, " \n", &vs))) {
+      if (strcmp(np, name) == 0) {
+        v = strtoul(vp, NULL, 10);
+        break;
+      }
+    }
+    break;
+  }
+  fclose(f);
+  return v;
+}
+
+/// @brief get the number of customers the server admitted
+/// @param customers number of customers. Out parameter.
+/// @retval 0 on success
+/// @retval -1 if the server does not publish statistics within 5 seconds
+static int server_customers(unsigned long *customers)
+{
+  const StatsShm *shm;
+  StatsSnapshot s;
+  uint64_t ino;
+  int i;
+
+  for (i = 0; i < 50; i++) {
+    if ((shm = stats_attach(STATS_STORM, &ino)) != NULL) break;
+    usleep(100000);
+  }
+  if (shm == NULL) return -1;
+  stats_read(shm, &s);
+  stats_detach(shm);
+  *customers = s.customers;
+  return 0;
+}
+
+/// @brief connecting thread: connect and hang up with a reset, as fast as possible
+/// @param arg Storm
+static void* storm_task(void *arg)
+{
+  Storm *st = (Storm *)arg;
+  struct linger reset = { 1, 0 };
+  struct sockaddr_in sa;
+  double start;
+  int fd;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(PORT_STORM);
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  while (bench_now() < st->until) {
+    if ((fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) break;
+    // A reset leaves no TIME-WAIT behind, so the storm does not run out of ports
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+    start = bench_now();
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0) {
+      if (st->n < LATENCY_MAX) st->latency[st->n++] = (bench_now() - start) * 1e6;
+      st->connects++;
+    } else {
+      st->failed++;
+    }
+    close(fd);
+  }
+
+  return NULL;
+}
+
+/// @brief compare two doubles for qsort()
+static int compare_double(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+/// @brief run a connection storm against a server with a given backlog and report the result
+/// @param backlog backlog of the server
+/// @param threads connecting threads
+/// @param seconds duration of the storm
+/// @retval 0 on success
+/// @retval -1 on error
+static int storm(int backlog, int threads, double seconds)
+{
+  const char *version = getenv("BENCH_VERSION");
+  unsigned long before, after, connects = 0, failed = 0, n = 0, overflows;
+  char arg[16], port[8];
+  double start, elapsed, *all;
+  Storm *st;
+  pid_t pid;
+  int i, null;
+
+  snprintf(arg, sizeof(arg), "%d", backlog);
+  snprintf(port, sizeof(port), "%d", PORT_STORM);
+  if ((pid = fork()) == 0) {
+    null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    execl(SERVER, SERVER, "-p", port, "-u", "", "-H", "/tmp/bench_accept.sock",
+          "-S", STATS_STORM, "-b", arg, "-L", "error", (char *)NULL);
+    _exit(127);
+  }
+  if ((pid < 0) || (server_customers(&before) < 0)) {
+    fprintf(stderr, "bench_accept: %s did not start\n", SERVER);
+    if (pid > 0) kill(pid, SIGKILL);
+    return -1;
+  }
+
+  st = (Storm *)calloc(threads, sizeof(Storm));
+  overflows = tcp_ext("ListenOverflows");
+  start = bench_now();
+  for (i = 0; i < threads; i++) {
+    st[i].until = start + seconds;
+    st[i].latency = (double *)malloc(LATENCY_MAX * sizeof(double));
+    pthread_create(&st[i].tid, NULL, storm_task, &st[i]);
+  }
+  for (i = 0; i < threads; i++) {
+    pthread_join(st[i].tid, NULL);
+    connects += st[i].connects;
+    failed += st[i].failed;
+    n += st[i].n;
+  }
+  elapsed = bench_now() - start;
+  overflows = tcp_ext("ListenOverflows") - overflows;
+
+  // The server admits what is left in its backlog within a few publishing intervals
+  usleep(5 * STATS_PUBLISH_MS * 1000);
+  server_customers(&after);
+  kill(pid, SIGINT);
+  waitpid(pid, NULL, 0);
+
+  all = (double *)malloc((n ? n : 1) * sizeof(double));
+  for (i = 0, n = 0; i < threads; i++) {
+    memcpy(all + n, st[i].latency, st[i].n * sizeof(double));
+    n += st[i].n;
+    free(st[i].latency);
+  }
+  qsort(all, n, sizeof(double), compare_double);
+
+  printf("{\"version\":\"%s\",\"bench\":\"accept_storm\",\"backlog\":%d,\"threads\":%d,"
+         "\"seconds\":%.3f,\"connects\":%lu,\"failed\":%lu,\"accepted\":%lu,"
+         "\"accepted_per_sec\":%.0f,\"connect_p50_us\":%.0f,\"connect_p99_us\":%.0f,"
+         "\"connect_max_us\":%.0f,\"listen_overflows\":%lu}\n",
+         version ? version : "unknown", backlog, threads, elapsed, connects, failed,
+         after - before, (after - before) / elapsed, n ? all[n / 2] : 0.0,
+         n ? all[n * 99 / 100] : 0.0, n ? all[n - 1] : 0.0, overflows);
+  fflush(stdout);
+
+  free(all);
+  free(st);
+  return 0;
+}
+
+/// @brief print usage
+/// @param prog program name
+static void usage(const char *prog)
+{
+  printf("usage %s [-t <threads>] [-s <seconds>] [-b <backlog>]\n", prog);
+  printf("  -t <threads> connecting threads (default: %d)\n", THREADS);
+  printf("  -s <seconds> duration of every storm (default: %g)\n", SECONDS);
+  printf("  -b <backlog> backlog of the server (default: %d, the old fixed backlog, and %d)\n",
+         OLD_BACKLOG, LISTEN_BACKLOG);
+}
+
+/// @brief program entry point. Starts the server, lets threads connect and hang up as fast as
+///        they can, and reports the connections the server accepted per second, the connect
+///        latencies of the clients (a dropped SYN costs a second) and the overflows of the
+///        listen queue counted by the kernel.
+int main(int argc, char *argv[])
+{
+  int threads = THREADS, backlog = 0, opt;
+  double seconds = SECONDS;
+
+  while ((opt = getopt(argc, argv, "t:s:b:")) != -1) {
+    switch (opt) {
+      case 't': threads = atoi(optarg); break;
+      case 's': seconds = atof(optarg); break;
+      case 'b': backlog = atoi(optarg); break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if ((threads <= 0) || (seconds <= 0) || (backlog < 0)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (backlog > 0) return (storm(backlog, threads, seconds) < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+  if ((storm(OLD_BACKLOG, threads, seconds) < 0) || (storm(LISTEN_BACKLOG, threads, seconds) < 0)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
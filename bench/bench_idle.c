@@ -0,0 +1,218 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_idle.c
+/// @brief Memory of idle customers: holds many idle connections against a server and checks its RSS
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "stats.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define CUSTOMERS 100000                                  ///< default idle customers
+#define BUDGET 512                                        ///< default RSS budget per customer (bytes)
+#define FD_RESERVE 64                                     ///< descriptors kept for other uses
+#define SERVER "./mcdonalds"                              ///< server under test
+#define PORT_IDLE "7795"                                  ///< TCP port of the server under test
+#define UNIX_IDLE "/tmp/bench_idle.uds"                   ///< Unix domain socket of the server
+#define STATS_IDLE "/bench_idle.stats"                    ///< statistics of the server
+
+/// @}
+
+/// @brief resident set size of a process
+/// @param pid process ID
+/// @retval RSS in KB
+/// @retval 0 if unknown
+static unsigned long rss_kb(pid_t pid)
+{
+  char path[64], line[256];
+  unsigned long kb = 0;
+  FILE *f;
+
+  snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+  if ((f = fopen(path, "r")) == NULL) return 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "VmRSS: %lu kB", &kb) == 1) break;
+  }
+  fclose(f);
+  return kb;
+}
+
+/// @brief wait until the server reports @a n customers in the lobby
+/// @param n number of customers
+/// @param s last snapshot. Out parameter.
+/// @retval 0 on success
+/// @retval -1 on timeout
+static int wait_waiting(unsigned long n, StatsSnapshot *s)
+{
+  const StatsShm *shm = NULL;
+  uint64_t ino;
+  int i;
+
+  for (i = 0; i < 600; i++) {
+    if ((shm == NULL) && ((shm = stats_attach(STATS_IDLE, &ino)) == NULL)) {
+      usleep(100000);
+      continue;
+    }
+    stats_read(shm, s);
+    if (s->waiting >= n) break;
+    usleep(100000);
+  }
+  if (shm) stats_detach(shm);
+  return (i < 600) ? 0 : -1;
+}
+
+/// @brief connect to the Unix domain socket of the server
+/// @retval socket
+/// @retval -1 on error
+static int connect_unix(void)
+{
+  struct sockaddr_un sa;
+  int fd;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strncpy(sa.sun_path, UNIX_IDLE, sizeof(sa.sun_path) - 1);
+  if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0) return -1;
+  if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/// @brief print usage
+/// @param prog program name
+static void usage(const char *prog)
+{
+  printf("usage %s [-n <customers>] [-b <bytes>]\n", prog);
+  printf("  -n <customers> idle customers to hold (default: %d; limited by the descriptors the\n"
+         "                 process may open)\n", CUSTOMERS);
+  printf("  -b <bytes>     RSS budget of the server per idle customer (default: %d)\n", BUDGET);
+}
+
+/// @brief program entry point. Starts the server, connects idle customers that never order,
+///        and compares the server's RSS with all of them waiting to its RSS before. Exits with
+///        failure if the server needs more than the budget per customer.
+int main(int argc, char *argv[])
+{
+  const char *version = getenv("BENCH_VERSION");
+  unsigned long n = CUSTOMERS, budget = BUDGET, before, after, i, per;
+  struct rlimit nofile;
+  StatsSnapshot s;
+  double start, seconds;
+  pid_t pid;
+  int *fds, opt, null;
+
+  while ((opt = getopt(argc, argv, "n:b:")) != -1) {
+    switch (opt) {
+      case 'n': n = strtoul(optarg, NULL, 10); break;
+      case 'b': budget = strtoul(optarg, NULL, 10); break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+
+  // Every customer takes a descriptor here and one in the server
+  if (getrlimit(RLIMIT_NOFILE, &nofile) == 0) {
+    nofile.rlim_cur = nofile.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &nofile);
+    if (n > nofile.rlim_cur - FD_RESERVE) {
+      fprintf(stderr, "bench_idle: %lu customers exceed the descriptor limit, holding %lu\n", n,
+              (unsigned long)(nofile.rlim_cur - FD_RESERVE));
+      n = nofile.rlim_cur - FD_RESERVE;
+    }
+  }
+  if ((n == 0) || ((fds = (int *)malloc(n * sizeof(int))) == NULL)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // The server keeps idle customers forever (-r 0)
+  if ((pid = fork()) == 0) {
+    null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+    execl(SERVER, SERVER, "-p", PORT_IDLE, "-u", UNIX_IDLE, "-H", "/tmp/bench_idle.sock",
+          "-S", STATS_IDLE, "-r", "0", "-L", "error", (char *)NULL);
+    _exit(127);
+  }
+  if ((pid < 0) || (wait_waiting(0, &s) < 0)) {
+    fprintf(stderr, "bench_idle: %s did not start\n", SERVER);
+    if (pid > 0) kill(pid, SIGKILL);
+    return EXIT_FAILURE;
+  }
+  usleep(200000);
+  before = rss_kb(pid);
+
+  start = bench_now();
+  for (i = 0; i < n; i++) {
+    if ((fds[i] = connect_unix()) < 0) {
+      perror("connect");
+      break;
+    }
+  }
+  n = i;
+  if (wait_waiting(n, &s) < 0) fprintf(stderr, "bench_idle: not all customers are waiting\n");
+  seconds = bench_now() - start;
+  after = rss_kb(pid);
+
+  per = (after > before) ? (after - before) * 1024 / (n ? n : 1) : 0;
+  bench_report("idle_admit", 1, n, 0, seconds);
+  printf("{\"version\":\"%s\",\"bench\":\"idle_rss\",\"customers\":%lu,\"waiting\":%lu,"
+         "\"rss_kb_before\":%lu,\"rss_kb_after\":%lu,\"bytes_per_customer\":%lu,"
+         "\"budget\":%lu,\"pass\":%s}\n",
+         version ? version : "unknown", n, (unsigned long)s.waiting, before, after, per, budget,
+         (per <= budget) && (s.waiting == n) ? "true" : "false");
+  fflush(stdout);
+
+  for (i = 0; i < n; i++) close(fds[i]);
+  free(fds);
+  kill(pid, SIGINT);
+  waitpid(pid, NULL, 0);
+
+  return (per <= budget) && (s.waiting == n) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
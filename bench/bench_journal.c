@@ -0,0 +1,131 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_journal.c
+/// @brief Benchmarks of the journal: append throughput and group commit
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define APPENDS 1000000                                   ///< records of the append benchmark
+#define COMMITS 2000                                      ///< synced records per thread
+
+/// @}
+
+/// @brief append APPENDS records without waiting for them to become durable
+static void bench_append(void)
+{
+  double start;
+  uint64_t lsn = 0;
+  unsigned long i;
+
+  start = bench_now();
+  for (i = 0; i < APPENDS; i++) lsn = journal_append(JOURNAL_BURGER, i, i % BURGER_TYPE_MAX, 1);
+  bench_report("journal/append", 1, APPENDS, APPENDS * sizeof(JournalRecord), bench_now() - start);
+
+  journal_sync(lsn);
+}
+
+/// @brief committing thread: append a record and wait until it is durable, COMMITS times
+static void* committer(void *data)
+{
+  unsigned long id = (unsigned long)data;
+
+  for (unsigned long i = 0; i < COMMITS; i++) {
+    journal_sync(journal_append(JOURNAL_ORDER, id, i % BURGER_TYPE_MAX, 1));
+  }
+
+  return NULL;
+}
+
+/// @brief @a threads threads append records and wait for each to become durable; group commit
+///        syncs the records of all threads with one fsync
+static void bench_commit(int threads)
+{
+  pthread_t tid[threads];
+  JournalStats before, after;
+  unsigned long ops = (unsigned long)threads * COMMITS, commits;
+  char name[64];
+  double start;
+  int i;
+
+  journal_stats(&before);
+  start = bench_now();
+  for (i = 0; i < threads; i++) pthread_create(&tid[i], NULL, committer, (void *)(unsigned long)i);
+  for (i = 0; i < threads; i++) pthread_join(tid[i], NULL);
+  snprintf(name, sizeof(name), "journal/append+sync/%d", threads);
+  bench_report(name, threads, ops, ops * sizeof(JournalRecord), bench_now() - start);
+  journal_stats(&after);
+
+  commits = after.commits - before.commits;
+  fprintf(stderr, "%s: %.1f record(s)/commit, fsync avg %.3f ms, max %.3f ms\n", name,
+          commits ? (double)ops / commits : 0.0,
+          commits ? (after.sync_ns - before.sync_ns) / 1e6 / commits : 0.0,
+          after.sync_max_ns / 1e6);
+}
+
+/// @brief program entry point. The journal is written to $BENCH_JOURNAL_DIR (default: a new
+///        directory in /tmp).
+int main(int argc, char *argv[])
+{
+  char tmp[] = "/tmp/bench_journal.XXXXXX";
+  char *dir = getenv("BENCH_JOURNAL_DIR");
+
+  if ((dir == NULL) && ((dir = mkdtemp(tmp)) == NULL)) {
+    perror("mkdtemp");
+    return EXIT_FAILURE;
+  }
+  if (journal_open(dir, NULL, NULL) < 0) {
+    perror("journal");
+    return EXIT_FAILURE;
+  }
+
+  bench_append();
+  bench_commit(1);
+  bench_commit(8);
+  bench_commit(32);
+
+  journal_close();
+  if (dir == tmp) rmdir(dir);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_log.c
+/// @brief Microbenchmarks of the asynchronous logger
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define EVENTS 10000000                                   ///< events per disabled/full benchmark
+#define BURST (LOG_RING_SIZE / 2)                         ///< events logged between drains
+#define ROUNDS 100                                        ///< bursts per enabled benchmark
+#define LINES 200000                                      ///< lines per stdio benchmark
+
+/// @}
+
+/// @brief log events of a level below the log level: the cost at production verbosity
+static void bench_disabled(void)
+{
+  double start;
+
+  log_set_level(LOG_INFO);
+  start = bench_now();
+  for (unsigned long i = 0; i < EVENTS; i++) {
+    log_debug("[Thread %lu] generating %s burger for customer %u", i, "bigmac", (unsigned int)i);
+  }
+  bench_report("log_disabled", 1, EVENTS, 0, bench_now() - start);
+}
+
+/// @brief log enabled events in bursts that fit into the ring; the drainer catches up in between
+static void bench_enabled(void)
+{
+  struct timespec pause = { 0, 2 * LOG_FLUSH_MS * 1000000L };
+  double start, elapsed = 0;
+
+  log_set_level(LOG_DEBUG);
+  for (int r = 0; r < ROUNDS; r++) {
+    start = bench_now();
+    for (unsigned long i = 0; i < BURST; i++) {
+      log_debug("[Thread %lu] generating %s burger for customer %u", i, "bigmac", (unsigned int)i);
+    }
+    elapsed += bench_now() - start;
+    nanosleep(&pause, NULL);
+  }
+  bench_report("log_enabled", 1, (unsigned long)ROUNDS * BURST, 0, elapsed);
+}
+
+/// @brief log enabled events much faster than the drainer runs: most records are dropped
+static void bench_full(void)
+{
+  double start;
+
+  log_set_level(LOG_DEBUG);
+  start = bench_now();
+  for (unsigned long i = 0; i < EVENTS; i++) {
+    log_debug("[Thread %lu] generating %s burger for customer %u", i, "bigmac", (unsigned int)i);
+  }
+  bench_report("log_ring_full", 1, EVENTS, 0, bench_now() - start);
+}
+
+/// @brief reference: line-buffered fprintf, as printf to a terminal
+static void bench_stdio(FILE *f)
+{
+  double start;
+
+  start = bench_now();
+  for (unsigned long i = 0; i < LINES; i++) {
+    fprintf(f, "[Thread %lu] generating %s burger for customer %u\n", i, "bigmac", (unsigned int)i);
+  }
+  bench_report("stdio_line_buffered", 1, LINES, 0, bench_now() - start);
+}
+
+int main(void)
+{
+  int fd = open("/dev/null", O_WRONLY);
+  FILE *f = fdopen(dup(fd), "w");
+
+  setvbuf(f, NULL, _IOLBF, BUFSIZ);
+  log_init(fd);
+
+  bench_disabled();
+  bench_enabled();
+  bench_full();
+  bench_stdio(f);
+
+  log_close();
+  fclose(f);
+  close(fd);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_net.c
+/// @brief Microbenchmarks of the network helper functions
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab io_uring backend, accept churn
+/// 2026/10/19 ARC lab round-trip latency over TCP and Unix domain sockets
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+
+#include "net.h"
+#include "burger.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define LINES 200000                                      ///< lines sent per line benchmark
+#define BLOCKS 20000                                      ///< blocks sent per data benchmark
+#define CONNECTS 2000                                     ///< connections per accept benchmark
+#define ROUNDTRIPS 20000                                  ///< messages per latency benchmark
+#define MESSAGE 64                                        ///< size of a latency message
+#define LINE "bigmac cheese chicken bulgogi bigmac cheese chicken bulgogi bigmac cheese\n"
+
+/// @}
+
+static const char *suffix = "";                           ///< "" for posix, "/io_uring"
+
+/// @brief arguments of the sending thread
+typedef struct {
+  int sock;                                                 ///< socket to send to
+  unsigned long count;                                      ///< number of lines/blocks to send
+  size_t size;                                              ///< block size (0: send lines)
+} SendArg;
+
+/// @brief sending thread: put_line() or put_data() @a count times
+static void* sender(void *data)
+{
+  SendArg *arg = (SendArg *)data;
+  char *block = NULL;
+
+  if (arg->size > 0) block = (char *)calloc(1, arg->size);
+
+  for (unsigned long i = 0; i < arg->count; i++) {
+    if (arg->size > 0) put_data(arg->sock, block, arg->size);
+    else put_line(arg->sock, LINE, sizeof(LINE));
+  }
+
+  free(block);
+  return NULL;
+}
+
+/// @brief put_line() on one end of a connected socket pair, get_line() on the other
+static void bench_lines(void)
+{
+  int sv[2];
+  pthread_t tid;
+  SendArg arg;
+  size_t buflen = BUF_SIZE;
+  char *buf = (char *)malloc(buflen);
+  unsigned long bytes = 0, i;
+  char name[64];
+  double t;
+
+  socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+  arg.sock = sv[0];
+  arg.count = LINES;
+  arg.size = 0;
+
+  t = bench_now();
+  pthread_create(&tid, NULL, sender, &arg);
+  for (i = 0; i < LINES; i++) {
+    int r = get_line(sv[1], &buf, &buflen);
+    if (r <= 0) break;
+    bytes += r;
+  }
+  pthread_join(tid, NULL);
+  t = bench_now() - t;
+
+  snprintf(name, sizeof(name), "net/put_line+get_line%s", suffix);
+  bench_report(name, 2, i, bytes, t);
+
+  close(sv[0]);
+  close(sv[1]);
+  free(buf);
+}
+
+/// @brief put_data() and get_data() of @a size byte blocks over a connected socket pair
+static void bench_data(size_t size)
+{
+  int sv[2];
+  pthread_t tid;
+  SendArg arg;
+  char *buf = net_alloc_buffer(size);
+  unsigned long bytes = 0, i;
+  char name[64];
+  double t;
+
+  socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+  arg.sock = sv[0];
+  arg.count = BLOCKS;
+  arg.size = size;
+
+  t = bench_now();
+  pthread_create(&tid, NULL, sender, &arg);
+  for (i = 0; i < BLOCKS; i++) {
+    int r = get_data(sv[1], buf, size);
+    if (r <= 0) break;
+    bytes += r;
+  }
+  pthread_join(tid, NULL);
+  t = bench_now() - t;
+
+  snprintf(name, sizeof(name), "net/put_data+get_data/%zu%s", size, suffix);
+  bench_report(name, 2, i, bytes, t);
+
+  close(sv[0]);
+  close(sv[1]);
+  net_free_buffer(buf);
+}
+
+/// @brief connecting thread: connect to the port in @a data and hang up CONNECTS times
+static void* connector(void *data)
+{
+  struct sockaddr_in sa = *(struct sockaddr_in *)data;
+
+  for (int i = 0; i < CONNECTS; i++) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) perror("connect");
+    close(fd);
+  }
+
+  return NULL;
+}
+
+/// @brief connection churn: accept_some() connections from a connecting thread and close them
+static void bench_accept(void)
+{
+  struct sockaddr_in sa = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+  socklen_t len = sizeof(sa);
+  int listenfd, fds[ACCEPT_BATCH], n;
+  unsigned long accepted = 0, wakeups = 0;
+  unsigned int events;
+  Acceptor *acceptor;
+  pthread_t tid;
+  char name[64];
+  double t;
+
+  listenfd = socket(AF_INET, SOCK_STREAM, 0);
+  if ((bind(listenfd, (struct sockaddr *)&sa, sizeof(sa)) < 0) || (listen(listenfd, 128) < 0)) {
+    perror("listen");
+    close(listenfd);
+    return;
+  }
+  getsockname(listenfd, (struct sockaddr *)&sa, &len);
+  acceptor = new_acceptor(&listenfd, 1, NULL, 0);
+
+  t = bench_now();
+  pthread_create(&tid, NULL, connector, &sa);
+  while (accepted < CONNECTS) {
+    n = accept_some(acceptor, fds, ACCEPT_BATCH, &events);
+    if (n < 0) break;
+    for (int i = 0; i < n; i++) close(fds[i]);
+    accepted += n;
+    wakeups++;
+  }
+  pthread_join(tid, NULL);
+  t = bench_now() - t;
+
+  snprintf(name, sizeof(name), "net/accept%s", suffix);
+  bench_report(name, 2, accepted, 0, t);
+  fprintf(stderr, "%s: %.2f connection(s) per wakeup\n", name,
+          wakeups ? (double)accepted / wakeups : 0.0);
+
+  free_acceptor(acceptor);
+  close(listenfd);
+}
+
+/// @brief echo thread: returns every MESSAGE-byte message on the socket in @a data
+static void* echo(void *data)
+{
+  int sock = *(int *)data;
+  char buf[MESSAGE];
+
+  while (get_data(sock, buf, MESSAGE) == MESSAGE) {
+    if (put_data(sock, buf, MESSAGE) != MESSAGE) break;
+  }
+
+  return NULL;
+}
+
+/// @brief round-trip latency of MESSAGE-byte messages to an echo thread over a connection of the
+///        given family (AF_INET: loopback TCP, AF_UNIX: Unix domain socket)
+static void bench_roundtrip(int family)
+{
+  struct addrinfo *ai;
+  struct sockaddr_storage sa;
+  socklen_t len = sizeof(sa);
+  char path[64], buf[MESSAGE], name[64];
+  int listenfd, fd, peer, i;
+  pthread_t tid;
+  double t;
+
+  snprintf(path, sizeof(path), "/tmp/bench_net.%d", (int)getpid());
+  ai = getsocklist(family == AF_UNIX ? path : "127.0.0.1", 0, family, SOCK_STREAM, 1, NULL);
+  if (ai == NULL) return;
+
+  // Listen on an ephemeral port or a temporary path, and connect to it
+  listenfd = socket(ai->ai_family, SOCK_STREAM, 0);
+  if ((bind(listenfd, ai->ai_addr, ai->ai_addrlen) < 0) || (listen(listenfd, 1) < 0)) {
+    perror("listen");
+    close(listenfd);
+    freesocklist(ai);
+    return;
+  }
+  getsockname(listenfd, (struct sockaddr *)&sa, &len);
+  fd = socket(ai->ai_family, SOCK_STREAM, 0);
+  if (connect(fd, (struct sockaddr *)&sa, len) < 0) perror("connect");
+  peer = accept(listenfd, NULL, NULL);
+  memset(buf, 'x', sizeof(buf));
+
+  pthread_create(&tid, NULL, echo, &peer);
+  t = bench_now();
+  for (i = 0; i < ROUNDTRIPS; i++) {
+    if ((put_data(fd, buf, MESSAGE) != MESSAGE) || (get_data(fd, buf, MESSAGE) != MESSAGE)) break;
+  }
+  t = bench_now() - t;
+  shutdown(fd, SHUT_RDWR);
+  pthread_join(tid, NULL);
+
+  snprintf(name, sizeof(name), "net/roundtrip/%s%s", family == AF_UNIX ? "unix" : "tcp", suffix);
+  bench_report(name, 2, i, (unsigned long)i * 2 * MESSAGE, t);
+
+  close(peer);
+  close(fd);
+  close(listenfd);
+  if (family == AF_UNIX) unlink(path);
+  freesocklist(ai);
+}
+
+/// @brief run all benchmarks with the current backend
+static void bench_all(void)
+{
+  bench_lines();
+  bench_data(CHUNK_SIZE);
+  bench_data(BUF_SIZE);
+  bench_accept();
+  bench_roundtrip(AF_INET);
+  bench_roundtrip(AF_UNIX);
+}
+
+/// @brief program entry point
+int main(int argc, char *argv[])
+{
+  bench_all();
+
+  // The same with io_uring, if available
+  if (net_init(NET_URING) == NET_URING) {
+    suffix = "/io_uring";
+    bench_all();
+  }
+
+  return 0;
+}
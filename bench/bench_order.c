@@ -0,0 +1,301 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_order.c
+/// @brief Microbenchmarks of the order queue, the request parser and make_burger
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab earliest-deadline-first queue
+/// 2026/10/19 ARC lab parser with a large menu
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "menu.h"
+#include "order.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define QUEUE_ORDERS 4000000                              ///< orders per queue benchmark
+#define PARSE_BYTES (16 << 20)                            ///< size of parsed request
+#define BURGERS 4000000                                   ///< burgers added to a request
+#define EDF_REQUESTS 64                                   ///< requests with distinct deadlines
+
+/// @}
+
+/// @brief arguments of a queue producer or consumer thread
+typedef struct {
+  OrderList *list;                                          ///< shared order list
+  unsigned long count;                                      ///< orders to issue / orders taken
+} QueueArg;
+
+/// @brief fill @a types with a repeating sequence of all burger types
+static void fill_types(enum burger_type *types, unsigned int n)
+{
+  for (unsigned int i = 0; i < n; i++) types[i] = i % BURGER_TYPE_MAX;
+}
+
+/// @brief issue_orders() followed by get_order() from a single thread
+static void bench_queue_single(unsigned int chunk)
+{
+  OrderList list;
+  enum burger_type types[ORDER_CHUNK];
+  Request *req = new_request(0, -1);
+  unsigned long n = 0;
+  char name[64];
+  double t;
+
+  init_orders(&list);
+  fill_types(types, chunk);
+
+  t = bench_now();
+  while (n < QUEUE_ORDERS) {
+    issue_orders(&list, req, types, chunk);
+    for (unsigned int i = 0; i < chunk; i++) free(get_order(&list));
+    n += chunk;
+  }
+  t = bench_now() - t;
+
+  snprintf(name, sizeof(name), "queue/single/chunk%u", chunk);
+  bench_report(name, 1, n, 0, t);
+  free_request(req);
+}
+
+/// @brief issue_orders() of orders with deadlines and get_order() from a single thread, with
+///        @a depth orders of random deadlines kept in the queue
+static void bench_queue_edf(unsigned int depth)
+{
+  OrderList list;
+  enum burger_type type = BURGER_BIGMAC;
+  Request *req[EDF_REQUESTS];
+  unsigned long n = 0;
+  unsigned int i, r = 1;
+  char name[64];
+  double t;
+
+  init_orders(&list);
+  for (i = 0; i < EDF_REQUESTS; i++) {
+    req[i] = new_request(i, -1);
+    r = r * 1103515245 + 12345;
+    req[i]->deadline_ns = 1 + r % 1000000000;
+  }
+  for (i = 0; i < depth; i++) issue_orders(&list, req[i % EDF_REQUESTS], &type, 1);
+
+  t = bench_now();
+  while (n < QUEUE_ORDERS) {
+    r = r * 1103515245 + 12345;
+    issue_orders(&list, req[(r >> 16) % EDF_REQUESTS], &type, 1);
+    free(get_order(&list));
+    n++;
+  }
+  t = bench_now() - t;
+
+  while (order_left(&list) > 0) free(get_order(&list));
+  snprintf(name, sizeof(name), "queue/edf/depth%u", depth);
+  bench_report(name, 1, n, 0, t);
+  for (i = 0; i < EDF_REQUESTS; i++) free_request(req[i]);
+}
+
+/// @brief producer: issue count orders in chunks of ORDER_CHUNK
+static void* producer(void *data)
+{
+  QueueArg *arg = (QueueArg *)data;
+  enum burger_type types[ORDER_CHUNK];
+  Request *req = new_request(0, -1);
+
+  fill_types(types, ORDER_CHUNK);
+  for (unsigned long n = 0; n < arg->count; n += ORDER_CHUNK) {
+    issue_orders(arg->list, req, types, ORDER_CHUNK);
+  }
+
+  // the consumers may still hold Nodes of the request; it is released after they are done
+  return req;
+}
+
+/// @brief consumer: take orders with wait_order() like a kitchen thread until the list closes
+static void* consumer(void *data)
+{
+  QueueArg *arg = (QueueArg *)data;
+  Node *order;
+
+  while ((order = wait_order(arg->list)) != NULL) {
+    free(order);
+    arg->count++;
+  }
+  return NULL;
+}
+
+/// @brief several serving threads issue orders while several kitchen threads take them
+static void bench_queue_mt(int producers, int consumers)
+{
+  OrderList list;
+  pthread_t ptid[producers], ctid[consumers];
+  QueueArg parg[producers], carg[consumers];
+  Request *reqs[producers];
+  unsigned long n = 0;
+  char name[64];
+  double t;
+  int i;
+
+  init_orders(&list);
+
+  t = bench_now();
+  for (i = 0; i < consumers; i++) {
+    carg[i].list = &list;
+    carg[i].count = 0;
+    pthread_create(&ctid[i], NULL, consumer, &carg[i]);
+  }
+  for (i = 0; i < producers; i++) {
+    parg[i].list = &list;
+    parg[i].count = QUEUE_ORDERS / producers;
+    pthread_create(&ptid[i], NULL, producer, &parg[i]);
+  }
+  for (i = 0; i < producers; i++) pthread_join(ptid[i], (void **)&reqs[i]);
+  close_orders(&list);
+  for (i = 0; i < consumers; i++) {
+    pthread_join(ctid[i], NULL);
+    n += carg[i].count;
+  }
+  t = bench_now() - t;
+
+  for (i = 0; i < producers; i++) free_request(reqs[i]);
+
+  snprintf(name, sizeof(name), "queue/mt/%dp%dc", producers, consumers);
+  bench_report(name, producers + consumers, n, 0, t);
+}
+
+/// @brief parse a large request in CHUNK_SIZE pieces, as serve_client() receives it
+/// @param name name of the benchmark
+static void bench_parse(const char *name)
+{
+  char *buf = (char *)malloc(PARSE_BYTES + 64);
+  size_t len = 0, off, pos;
+  unsigned long burgers = 0;
+  Request *req = new_request(0, -1);
+  Parser parser;
+  enum parse_result res = PARSE_MORE;
+  double t;
+  int i = 0;
+
+  len = snprintf(buf, PARSE_BYTES, "stream=0");
+  while (len < PARSE_BYTES - 16) {
+    len += sprintf(buf + len, " %s", menu->item[i++ % menu->items].name);
+  }
+  buf[len++] = '\n';
+
+  init_parser(&parser, req);
+
+  t = bench_now();
+  for (off = 0; (off < len) && (res != PARSE_DONE); off += CHUNK_SIZE) {
+    size_t n = (len - off < CHUNK_SIZE) ? len - off : CHUNK_SIZE;
+    pos = 0;
+    do {
+      res = parse_request(&parser, buf + off, n, &pos);
+      burgers += parser.count;
+      parser.count = 0;
+    } while (res == PARSE_CHUNK);
+    if (res == PARSE_ERROR) {
+      printf("parse error\n");
+      break;
+    }
+  }
+  t = bench_now() - t;
+
+  bench_report(name, 1, burgers, len, t);
+  free_request(req);
+  free(buf);
+}
+
+/// @brief parse a large request with a menu of @a items burgers; looking up a burger should
+///        cost the same as with the built-in menu
+/// @param items number of burgers on the menu
+static void bench_parse_menu(unsigned int items)
+{
+  char path[64], name[64];
+  unsigned int i;
+  FILE *f;
+
+  snprintf(path, sizeof(path), "/tmp/bench_menu.%d", (int)getpid());
+  if ((f = fopen(path, "w")) == NULL) return;
+  for (i = 0; i < items; i++) fprintf(f, "burger%u 1000\n", i);
+  fclose(f);
+
+  if (menu_load(path) == 0) {
+    snprintf(name, sizeof(name), "parse/request_menu%u", items);
+    bench_parse(name);
+  }
+  unlink(path);
+  menu_load(NULL);
+}
+
+/// @brief build the order string of a large request with add_burger(), the string building
+///        part of make_burger()
+/// @param stream build the "ready: <burger>" lines of a streamed request instead
+static void bench_make_burger(bool stream)
+{
+  Request *req = new_request(0, -1);
+  double t;
+
+  req->stream = stream;
+
+  t = bench_now();
+  for (unsigned long i = 0; i < BURGERS; i++) {
+    add_burger(req, i % BURGER_TYPE_MAX);
+  }
+  t = bench_now() - t;
+
+  bench_report(stream ? "make_burger/stream" : "make_burger/order_str", 1, BURGERS,
+               stream ? req->ready_len : req->order_len, t);
+  free_request(req);
+}
+
+/// @brief program entry point
+int main(int argc, char *argv[])
+{
+  if (menu_load(NULL) < 0) return EXIT_FAILURE;
+
+  bench_queue_single(1);
+  bench_queue_single(ORDER_CHUNK);
+  bench_queue_edf(1024);
+  bench_queue_edf(65536);
+  bench_queue_mt(1, 1);
+  bench_queue_mt(4, 4);
+  bench_queue_mt(10, 30);
+  bench_parse("parse/request");
+  bench_parse_menu(MENU_MAX);
+  bench_make_burger(false);
+  bench_make_burger(true);
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  bench_timer.c
+/// @brief Microbenchmarks of the timer wheel
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "timer.h"
+#include "bench.h"
+
+/// @name Parameters
+/// @{
+
+#define EXPIRE_TIMERS 10000                               ///< timers of the expiry benchmark
+#define EXPIRE_MS 100                                     ///< timeout of the expiry benchmark
+
+/// @}
+
+static volatile unsigned long fired = 0;                    ///< number of expired timers
+
+/// @brief expiry function: count expired timers
+static void count_expiry(Timer *t)
+{
+  __atomic_add_fetch(&fired, 1, __ATOMIC_RELAXED);
+}
+
+/// @brief arm, re-arm and cancel @a n timers with timeouts spread over 1 to 300 seconds, the
+///        pattern of read/write deadlines with @a n connections
+/// @param n number of timers
+static void bench_ops(unsigned long n)
+{
+  Timer *timers = (Timer *)calloc(n, sizeof(Timer));
+  char name[64];
+  double start;
+  unsigned long i;
+
+  for (i = 0; i < n; i++) timer_setup(&timers[i], count_expiry, NULL);
+
+  start = bench_now();
+  for (i = 0; i < n; i++) timer_arm(&timers[i], 1000 + (i * 7919) % 299000);
+  snprintf(name, sizeof(name), "timer_arm_%lu", n);
+  bench_report(name, 1, n, 0, bench_now() - start);
+
+  start = bench_now();
+  for (i = 0; i < n; i++) timer_arm(&timers[i], 1000 + (i * 104729) % 299000);
+  snprintf(name, sizeof(name), "timer_rearm_%lu", n);
+  bench_report(name, 1, n, 0, bench_now() - start);
+
+  start = bench_now();
+  for (i = 0; i < n; i++) timer_cancel(&timers[i]);
+  snprintf(name, sizeof(name), "timer_cancel_%lu", n);
+  bench_report(name, 1, n, 0, bench_now() - start);
+
+  free(timers);
+}
+
+/// @brief let EXPIRE_TIMERS timers expire at once; reports the time from the deadline until the
+///        last expiry function ran
+static void bench_expire(void)
+{
+  Timer *timers = (Timer *)calloc(EXPIRE_TIMERS, sizeof(Timer));
+  double start, deadline;
+  unsigned long i;
+
+  fired = 0;
+  for (i = 0; i < EXPIRE_TIMERS; i++) timer_setup(&timers[i], count_expiry, NULL);
+
+  start = bench_now();
+  for (i = 0; i < EXPIRE_TIMERS; i++) timer_arm(&timers[i], EXPIRE_MS);
+  deadline = start + EXPIRE_MS / 1000.0;
+
+  while (__atomic_load_n(&fired, __ATOMIC_RELAXED) < EXPIRE_TIMERS) usleep(100);
+  bench_report("timer_expire", 1, EXPIRE_TIMERS, 0, bench_now() - deadline);
+
+  free(timers);
+}
+
+int main(void)
+{
+  timer_init();
+
+  bench_ops(1000);
+  bench_ops(50000);
+  bench_expire();
+
+  timer_close();
+
+  return EXIT_SUCCESS;
+}
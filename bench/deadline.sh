@@ -0,0 +1,110 @@
+#!/bin/bash
+#--------------------------------------------------------------------------------------------------
+# Network Lab                             Spring 2024                           System Programming
+#
+# deadline.sh - admission of requests with a deadline
+#
+# usage: deadline.sh <server binary> <label>
+#
+# Starts the server with 4 kitchens and sends requests with a deadline of 20 s. With the built-in
+# menu (1 s per burger), the first ORDER_CHUNK (64) burgers could be ready in time, all 128 could
+# not. The large request must be rejected as a whole, without a single burger made; the small one
+# must be served. Prints one JSON object per request and fails if a request is not handled as
+# expected. Run from the top directory.
+#
+
+SERVER=$1
+LABEL=$2
+VERSION=${BENCH_VERSION:-unknown}
+PORT=7777
+LOG=$(mktemp)
+
+if [ -z "$SERVER" ] || [ -z "$LABEL" ]; then
+  echo "usage: $0 <server binary> <label>" >&2
+  exit 1
+fi
+
+if [ ! -x "$SERVER" ]; then
+  echo "$SERVER: not found" >&2
+  exit 1
+fi
+
+# wait until the port is (not) accepting connections
+wait_port() {
+  for i in $(seq 50); do
+    if (exec 3<>/dev/tcp/127.0.0.1/$PORT) 2>/dev/null; then up=1; else up=0; fi
+    [ $up -eq $1 ] && return 0
+    sleep 0.1
+  done
+  return 1
+}
+
+stop_server() {
+  kill -INT $1 2>/dev/null
+  sleep 0.2
+  kill -INT $1 2>/dev/null
+  for i in $(seq 50); do
+    kill -0 $1 2>/dev/null || return 0
+    sleep 0.1
+  done
+  kill -KILL $1 2>/dev/null
+  wait $1 2>/dev/null
+}
+
+# send a request and print the reply
+order() {
+  exec 3<>/dev/tcp/127.0.0.1/$PORT || return 1
+  read -r welcome <&3
+  echo "$1" >&3
+  read -r reply <&3
+  exec 3<&-
+  echo "$reply"
+}
+
+
+if ! wait_port 0; then
+  echo "port $PORT is in use" >&2
+  exit 1
+fi
+
+$SERVER -k 4 > $LOG 2>&1 &
+pid=$!
+if ! wait_port 1; then
+  echo "$SERVER did not start" >&2
+  stop_server $pid
+  rm -f $LOG
+  exit 1
+fi
+sleep 0.2
+
+fail=0
+for scenario in "128:rejected" "4:served"; do
+  burgers=${scenario%%:*}
+  expect=${scenario##*:}
+
+  request="deadline=20"
+  for i in $(seq $burgers); do request="$request bigmac"; done
+  reply=$(order "$request")
+  case "$reply" in
+    Sorry*) got=rejected ;;
+    Your*) got=served ;;
+    *) got=failed ;;
+  esac
+  [ "$got" = "$expect" ] || fail=1
+
+  printf "{\"version\":\"%s\",\"bench\":\"deadline/%s/%d\",\"server\":\"%s\",\"burgers\":%d," \
+         "$VERSION" "$LABEL" $burgers "$LABEL" $burgers
+  printf "\"expected\":\"%s\",\"result\":\"%s\"}\n" "$expect" "$got"
+done
+
+stop_server $pid
+
+# The rejected request must not have cost the kitchen anything
+made=$(awk '/^Number of .* made:/ { n += $NF } END { print n + 0 }' $LOG)
+printf "{\"version\":\"%s\",\"bench\":\"deadline/%s/made\",\"server\":\"%s\",\"burgers_made\":%d," \
+       "$VERSION" "$LABEL" "$LABEL" $made
+printf "\"expected\":4}\n"
+[ $made -eq 4 ] || fail=1
+rm -f $LOG
+
+exit $fail
@@ -0,0 +1,109 @@
+#!/bin/bash
+#--------------------------------------------------------------------------------------------------
+# Network Lab                             Spring 2024                           System Programming
+#
+# load.sh - end-to-end load scenarios against a McDonald's server
+#
+# usage: load.sh <server binary> <label>
+#
+# Starts the server, runs ./client for every scenario in BENCH_SCENARIOS ("<clients>:<burgers>",
+# separated by blanks) and prints one JSON object per scenario. Run from the top directory.
+#
+# The reference server does not set SO_REUSEADDR and cannot bind while connections of a previous
+# run linger in TIME-WAIT. If a server does not come up, we wait for the port to become free and
+# try again.
+#
+
+SERVER=$1
+LABEL=$2
+SCENARIOS=${BENCH_SCENARIOS:-"1:1 10:3"}
+VERSION=${BENCH_VERSION:-unknown}
+PORT=7777
+
+if [ -z "$SERVER" ] || [ -z "$LABEL" ]; then
+  echo "usage: $0 <server binary> <label>" >&2
+  exit 1
+fi
+
+if [ ! -x "$SERVER" ]; then
+  echo "$SERVER: not found" >&2
+  exit 1
+fi
+
+# wait until the port is (not) accepting connections
+wait_port() {
+  for i in $(seq 50); do
+    if (exec 3<>/dev/tcp/127.0.0.1/$PORT) 2>/dev/null; then up=1; else up=0; fi
+    [ $up -eq $1 ] && return 0
+    sleep 0.1
+  done
+  return 1
+}
+
+# wait until no socket uses the port anymore (TIME-WAIT lasts 60 seconds)
+wait_free() {
+  command -v ss > /dev/null || return 0
+  for i in $(seq 700); do
+    [ -z "$(ss -Htan | awk -v p=":$PORT" '$4 ~ p"$" || $5 ~ p"$"')" ] && return 0
+    sleep 0.1
+  done
+  return 1
+}
+
+stop_server() {
+  kill -INT $1 2>/dev/null
+  for i in $(seq 50); do
+    kill -0 $1 2>/dev/null || return 0
+    sleep 0.1
+  done
+  kill -KILL $1 2>/dev/null
+  wait $1 2>/dev/null
+}
+
+if ! wait_port 0; then
+  echo "port $PORT is in use" >&2
+  exit 1
+fi
+
+$SERVER > /dev/null 2>&1 &
+pid=$!
+if ! wait_port 1; then
+  stop_server $pid
+  wait_free
+  $SERVER > /dev/null 2>&1 &
+  pid=$!
+  if ! wait_port 1; then
+    echo "$SERVER did not start" >&2
+    stop_server $pid
+    exit 1
+  fi
+fi
+# the probe connection of wait_port() counts as a customer; let the server get rid of it
+sleep 0.2
+
+for scenario in $SCENARIOS; do
+  clients=${scenario%%:*}
+  burgers=${scenario##*:}
+
+  start=$(date +%s.%N)
+  out=$(./client $clients $burgers)
+  end=$(date +%s.%N)
+
+  echo "$out" | awk -v version="$VERSION" -v label="$LABEL" -v clients=$clients \
+                    -v burgers=$burgers -v start=$start -v end=$end '
+    /^Requests served:/       { split($3, r, "/"); served = r[1] }
+    /^Time to first burger:/  { first_avg = $6; first_max = $9 }
+    /^Time to last burger:/   { last_avg = $6; last_max = $9 }
+    END {
+      wall = end - start
+      printf("{\"version\":\"%s\",\"bench\":\"load/%s/%dx%d\",\"server\":\"%s\",", version, label,
+             clients, burgers, label)
+      printf("\"clients\":%d,\"burgers\":%d,\"served\":%d,\"seconds\":%.3f,", clients, burgers,
+             served, wall)
+      printf("\"burgers_per_sec\":%.2f,\"first_avg\":%s,\"first_max\":%s,", served * burgers / wall,
+             first_avg + 0, first_max + 0)
+      printf("\"last_avg\":%s,\"last_max\":%s}\n", last_avg + 0, last_max + 0)
+    }'
+done
+
+stop_server $pid
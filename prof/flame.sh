@@ -0,0 +1,59 @@
+#!/bin/bash
+#--------------------------------------------------------------------------------------------------
+# Network Lab                             Spring 2024                           System Programming
+#
+# flame.sh - per-stage CPU profiles of a running McDonald's server
+#
+# usage: flame.sh [<seconds>] [<output prefix>]
+#
+# Samples the on-CPU call stacks of mcdonalds with perf for <seconds> (default: 10), folds them
+# and splits the folded stacks by thread name: mcd-serve, mcd-kitchen, mcd-prep, mcd-grill,
+# mcd-assemble, mcd-dispatch, mcd-lobby and the other threads of the server. Writes
+# <prefix>.<thread>.folded (default prefix: prof) and, if flamegraph.pl of Brendan Gregg's
+# FlameGraph tools is in PATH, <prefix>.<thread>.svg and <prefix>.svg with all threads.
+#
+# Build the server with `make profile' first: perf walks the stacks over the frame pointers.
+#
+
+SECONDS_=${1:-10}
+PREFIX=${2:-prof}
+PID=$(pgrep -x -n mcdonalds)
+
+if [ -z "$PID" ]; then
+  echo "mcdonalds is not running" >&2
+  exit 1
+fi
+
+if ! command -v perf >/dev/null; then
+  echo "perf: not found" >&2
+  exit 1
+fi
+
+perf record -F 999 --call-graph fp -p "$PID" -o "$PREFIX.data" -- sleep "$SECONDS_" || exit 1
+
+# fold the samples into "<thread>;<root>;...;<leaf> <count>", one line per distinct stack
+perf script -i "$PREFIX.data" -F comm,ip,sym 2>/dev/null | awk '
+  function flush() {
+    if (comm != "") folded[comm (stack == "" ? "" : ";" stack)]++
+    comm = ""; stack = ""
+  }
+  /^[^ \t]/            { flush(); comm = $1; next }
+  /^[ \t]+[0-9a-f]+ /  { stack = (stack == "" ? $2 : $2 ";" stack); next }
+  /^[ \t]*$/           { flush() }
+  END                  { flush(); for (s in folded) print s, folded[s] }
+' | sort > "$PREFIX.folded"
+
+# split by thread and print the share of the samples of every thread
+total=$(awk '{ n += $NF } END { print n + 0 }' "$PREFIX.folded")
+for thread in $(cut -d';' -f1 "$PREFIX.folded" | cut -d' ' -f1 | sort -u); do
+  grep "^$thread[; ]" "$PREFIX.folded" > "$PREFIX.$thread.folded"
+  awk -v t="$thread" -v total="$total" '{ n += $NF }
+    END { printf("%-14s %8d samples %6.1f%%\n", t, n, total ? 100 * n / total : 0) }' \
+    "$PREFIX.$thread.folded"
+  if command -v flamegraph.pl >/dev/null; then
+    flamegraph.pl --title "mcdonalds: $thread" "$PREFIX.$thread.folded" > "$PREFIX.$thread.svg"
+  fi
+done
+if command -v flamegraph.pl >/dev/null; then
+  flamegraph.pl --title "mcdonalds" "$PREFIX.folded" > "$PREFIX.svg"
+fi
@@ -6,6 +6,7 @@
 /// @author Bernhard Egger <bernhard@csap.snu.ac.kr>
 /// @section changelog Change Log
 /// 2021/11/24 Bernhard Egger created
+/// 2026/10/19 ARC lab built-in menu
 ///
 /// @section license_section License
 /// Copyright (c) 2021-2023, Computer Systems and Platforms Laboratory, SNU
@@ -33,10 +34,12 @@
 
 #include "burger.h"
 
-char *burger_names[] = {
-  "bigmac",
-  "cheese",
-  "chicken",
-  "bulgogi"
-};
+// Every burger takes 1 s; the pipelined kitchen gives each its own station, and the stages
+// weigh differently per burger
+const char menu_builtin[] =
+  "# name   cook_ms station prep:grill:assemble\n"
+  "bigmac   1000    bigmac  30:40:30\n"
+  "cheese   1000    cheese  20:60:20\n"
+  "chicken  1000    chicken 15:70:15\n"
+  "bulgogi  1000    bulgogi 25:50:25\n";
 
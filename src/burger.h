@@ -7,6 +7,15 @@
 /// @section changelog Change Log
 /// 2021/11/24 Bernhard Egger created
 /// 2024/05/31 ARC lab add constant definitions
+/// 2026/10/19 ARC lab streamed requests of arbitrary size
+/// 2026/10/19 ARC lab deadlines of requests
+/// 2026/10/19 ARC lab per-node kitchen pools
+/// 2026/10/19 ARC lab batched accept
+/// 2026/10/19 ARC lab Unix domain socket of the server
+/// 2026/10/19 ARC lab cook time for deadline estimates
+/// 2026/10/19 ARC lab elastic kitchen pool
+/// 2026/10/19 ARC lab smaller stacks of serving threads
+/// 2026/10/19 ARC lab menu loaded at startup
 ///
 /// @section license_section License
 /// Copyright (c) 2021-2023, Computer Systems and Platforms Laboratory, SNU
@@ -33,12 +42,18 @@
 /// DAMAGE.
 //--------------------------------------------------------------------------------------------------
 
+#ifndef __BURGER_H__
+#define __BURGER_H__
+
 /// @name Macro definitions
 /// @{
 
 #define PORT 7777                                         ///< default port number
 #define BUF_SIZE 65536                                    ///< default send & recv buffer size
+#define CHUNK_SIZE 4096                                   ///< streamed request receive buffer size
 #define IP "127.0.0.1"                                    ///< default loopback ip
+#define HANDOFF_PATH "/tmp/mcdonalds.sock"                ///< socket for zero-downtime restart
+#define UNIX_PATH "/tmp/mcdonalds.uds"                    ///< default Unix domain socket
 
 /// @}
 
@@ -46,13 +61,30 @@
 /// @{
 
 #define CUSTOMER_MAX 10                                   ///< maximum number of clients
+#define SERVE_STACK (256 * 1024)                          ///< stack size of a serving thread
+#define ACCEPT_BATCH 64                                   ///< max. customers admitted per wakeup
 #define NUM_KITCHEN 30                                    ///< number of kitchen thread(s)
-#define MAX_BURGERS 10                                   ///< max number of burgers per order
+#define KITCHEN_MAX 256                                   ///< max. kitchens of an elastic pool
+#define MAX_BURGERS 10                                    ///< default number of burgers per order
 #define BURGER_NUM_RAND 0                                 ///< randomly select the number of burgers
+#define ORDER_CHUNK 64                                    ///< orders handed to the kitchen at once
+#define REQUEST_WINDOW 1024                               ///< max. uncooked orders per request
+#define TOKEN_MAX 32                                      ///< max. length of a burger name
+#define MENU_MAX 256                                      ///< max. burgers on a menu
+#define MENU_STATIONS 16                                  ///< max. stations of a menu
+#define COALESCE_MS 5                                     ///< max. delay to batch streamed burgers
+#define READ_TIMEOUT_MS 10000                             ///< default max. wait for request data
+#define WRITE_TIMEOUT_MS 10000                            ///< default max. wait to send a response
+#define REQUEST_TIMEOUT_MS 300000                         ///< default max. duration of a request
+#define STEAL_MS 50                                       ///< idle pool kitchens check other pools
+#define SCALE_MS 200                                      ///< interval of the kitchen scaler
+#define SCALE_DRAIN_MS 2000                               ///< time to work off a backlog
+#define SCALE_COOLDOWN_MS 5000                            ///< min. time between scaling down
 
 /// @}
 
-/// @brief served burger types
+/// @brief served burger types: the index of a burger on the menu (see menu.h). The constants
+///        name the burgers of the built-in menu.
 enum burger_type {
   BURGER_BIGMAC,
   BURGER_CHEESE,
@@ -61,5 +93,6 @@ enum burger_type {
   BURGER_TYPE_MAX
 };
 
-extern char *burger_names[];                              ///< burger names as strings
+extern const char menu_builtin[];                         ///< built-in menu, in menu file format
 
+#endif // __BURGER_H__
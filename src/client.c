@@ -11,6 +11,15 @@
 /// 2020/11/18 Hyunik Kim created
 /// 2021/11/23 Jaume Mateu Cuadrat cleanup, add milestones
 /// 2024/05/31 ARC lab add multiple orders per request
+/// 2026/10/19 ARC lab stream requests of arbitrary size
+/// 2026/10/19 ARC lab streamed responses, time to first and last burger
+/// 2026/10/19 ARC lab connect through a Unix domain socket
+/// 2026/10/19 ARC lab connect to another port
+/// 2026/10/19 ARC lab order from a menu file
+/// 2026/10/19 ARC lab replay a trace recorded by the server
+/// 2026/10/19 ARC lab order without waiting for the welcome, over TCP Fast Open
+/// 2026/10/19 ARC lab retry lost requests with an idempotency key
+/// 2026/10/19 ARC lab replay with a bounded pool of workers
 ///
 /// @section license_section License
 /// Copyright (c) 2020-2023, Computer Systems and Platforms Laboratory, SNU
@@ -41,17 +50,154 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include <pthread.h>
 #include <errno.h>
 #include <time.h>
 
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 
 #include "net.h"
 #include "burger.h"
+#include "menu.h"
+#include "trace.h"
+
+/// @brief buffered writer to stream a request of arbitrary size to the server
+typedef struct __writer {
+  int sock;                                                 ///< socket to write to
+  char buf[CHUNK_SIZE];                                     ///< data not yet sent
+  size_t len;                                               ///< number of bytes in buf
+  int error;                                                ///< <0 after a failed send
+} Writer;
+
+#define REPLAY_STACK (128 * 1024)                         ///< stack size of a replaying thread
+#define REPLAY_WORKERS 256                                ///< default number of replaying threads
+#define REPLAY_LATE_MS 10                                 ///< start delay of a late request
+
+/// @brief a request of a replayed trace and its result
+typedef struct __replayed {
+  const Trace *trace;                                       ///< trace of the request
+  const TraceRecord *rec;                                   ///< recorded request
+  double latency;                                           ///< request sent until response (s)
+  double lag;                                               ///< start after the recorded arrival (s)
+  bool sent;                                                ///< connected and sent the request
+  bool answered;                                            ///< got the final response line
+  bool served;                                              ///< the response was the burgers
+} Replayed;
+
+/// @brief requests of a replay, shared by its workers
+typedef struct __schedule {
+  Replayed *reps;                                           ///< requests in arrival order
+  size_t n;                                                 ///< number of requests
+  size_t next;                                              ///< next request to take
+  struct timespec start;                                    ///< start of the replay
+} Schedule;
+
+/// @brief timing of a single request, measured from the start of sending the request
+typedef struct __timing {
+  double first;                                             ///< time to first burger in seconds
+  double last;                                              ///< time to last burger in seconds
+  bool done;                                                ///< request was served
+} Timing;
+
+unsigned int num_burgers = MAX_BURGERS;                     ///< number of burgers per request
+bool stream = false;                                        ///< request streamed responses
+bool fast_open = false;                                     ///< order before the welcome, TFO
+char *unix_path = NULL;                                     ///< Unix domain socket (NULL: TCP)
+unsigned short port = PORT;                                 ///< TCP port of the server
+char *menu_path = NULL;                                     ///< menu file (NULL: built-in menu)
+char *replay_path = NULL;                                   ///< trace to replay (NULL: none)
+double replay_speed = 1;                                    ///< replay speed-up (0: no gaps)
+unsigned int replay_workers = REPLAY_WORKERS;               ///< threads replaying requests
+unsigned int retries = 0;                                   ///< retries of a lost request
+double timeout = 0;                                         ///< max. wait for a response (0: none)
+unsigned int next_key = 0;                                  ///< requests given a key so far
+
+/// @brief seconds elapsed since @a start
+/// @param start start time (CLOCK_MONOTONIC)
+/// @retval elapsed time in seconds
+double elapsed(struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/// @brief send buffered data of writer to the server
+/// @param w writer
+/// @retval 0 on success, <0 on error
+int flush_writer(Writer *w)
+{
+  if ((w->error == 0) && (w->len > 0)) {
+    if (put_data(w->sock, w->buf, w->len) <= 0) w->error = -1;
+    w->len = 0;
+  }
+  return w->error;
+}
+
+/// @brief append a string to the request. Full chunks are sent right away, so the server can
+///        start cooking while the rest of the request is still being generated.
+/// @param w writer
+/// @param str string to append
+/// @retval 0 on success, <0 on error
+int write_str(Writer *w, const char *str)
+{
+  size_t len = strlen(str);
+
+  while ((len > 0) && (w->error == 0)) {
+    size_t n = sizeof(w->buf) - w->len;
+    if (n > len) n = len;
+
+    memcpy(w->buf + w->len, str, n);
+    w->len += n;
+    str += n;
+    len -= n;
+
+    if (w->len == sizeof(w->buf)) flush_writer(w);
+  }
+  return w->error;
+}
+
+/// @brief send a request: its options and burgers. Full chunks are sent while the request is
+///        written, so the server can start cooking before the rest arrives.
+/// @param sock socket
+/// @param key idempotency key ("": none)
+/// @param choices burger types
+/// @param count number of burgers
+/// @retval 0 on success, <0 on error
+int send_request(int sock, const char *key, const int *choices, unsigned int count)
+{
+  Writer *w = (Writer *)malloc(sizeof(Writer));
+  int ret;
+
+  w->sock = sock;
+  w->len = 0;
+  w->error = 0;
+
+  if (stream) write_str(w, "stream=1 ");
+  if (key[0]) {
+    write_str(w, "key=");
+    write_str(w, key);
+    write_str(w, " ");
+  }
+  for (unsigned int i=0; i<count; i++){
+    if (i > 0) write_str(w, " ");
+    write_str(w, menu->item[choices[i]].name);
+  }
+  write_str(w, "\n");
+
+  // Send the rest of the request to the server
+  ret = flush_writer(w);
+  free(w);
+  return ret;
+}
 
 /// @brief client error function
 /// @param socketfd file drescriptor of the socket
@@ -60,16 +206,24 @@ void error_client(int socketfd) {
   	pthread_exit(NULL);
 }
 
+int connect_server(void);
+
 /// @brief client task for connection thread
+/// @param data pointer to Timing of this thread
 void *thread_task(void *data)
 {
   struct addrinfo *ai, *ai_it;
-  size_t read, sent, buflen;
+  ssize_t read, sent;
+  size_t buflen;
   int serverfd = -1;
   char *buffer;
   pthread_t tid;
   int *choices;
-  unsigned int burger_count;
+  unsigned int burger_count, ready_count = 0, attempt;
+  Timing *timing = (Timing *)data;
+  struct timespec start;
+  struct timeval tv;
+  char key[TOKEN_MAX + 1] = "";
 
   tid = pthread_self();
 
@@ -85,7 +239,8 @@ void *thread_task(void *data)
   // TODO
   int res;
 
-  ai = getsocklist(IP, PORT, AF_INET, SOCK_STREAM, 0, &res);
+  if (unix_path) ai = getsocklist(unix_path, 0, AF_UNIX, SOCK_STREAM, 0, &res);
+  else ai = getsocklist(IP, port, AF_INET, SOCK_STREAM, 0, &res);
 
   if (res != 0) fprintf(stderr, "client socket failed\n");
 
@@ -95,88 +250,405 @@ void *thread_task(void *data)
     //dump_sockaddr(ai_it->ai_addr);
     serverfd = socket(ai_it->ai_family, ai_it->ai_socktype, ai_it->ai_protocol);
     if (serverfd != -1) {
+      // The request then rides in the SYN, if the server has handed out a Fast Open cookie
+      if (fast_open && (ai_it->ai_family != AF_UNIX)) {
+        int one = 1;
+        setsockopt(serverfd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one, sizeof(one));
+      }
       if (connect(serverfd, ai_it->ai_addr, ai_it->ai_addrlen) == 0) break;
       close(serverfd);
     }
     ai_it = ai_it->ai_next;
   }
 
-  // Read welcome message from the server
-  read = get_line(serverfd, &buffer, &buflen);
-  if (read <= 0) {
-    printf("Cannot read data from server\n");
-    error_client(serverfd);
-  }
+  // Read welcome message from the server, or after ordering with -f
+  if (!fast_open) {
+    read = get_line(serverfd, &buffer, &buflen);
+    if (read <= 0) {
+      printf("Cannot read data from server\n");
+      error_client(serverfd);
+    }
 
-  printf("[Thread %lu] From server: %s", tid, buffer);
+    printf("[Thread %lu] From server: %s", tid, buffer);
+  }
 
   // Choose the number of orders for request
   if(BURGER_NUM_RAND)
-    burger_count = rand() % MAX_BURGERS + 1;
+    burger_count = rand() % num_burgers + 1;
   else
-    burger_count = MAX_BURGERS;
+    burger_count = num_burgers;
 
   printf("[Thread %lu] Ordering %u burgers\n", tid, burger_count);
 
-  // Randomly choose burger type for each order
+  // Randomly choose burger type for each order and stream the request to the server. With
+  // retries, the request gets a key that is unique to this client process.
+  clock_gettime(CLOCK_MONOTONIC, &start);
   choices = (int *)malloc(sizeof(int) * burger_count);
-  for (int i=0; i<burger_count; i++){
-    int choice = rand() % BURGER_TYPE_MAX;
-
-    // concat burger to buffer string
-    char *temp_buffer;
-    if (i == 0){
-      int res = asprintf(&temp_buffer, "%s", burger_names[choice]);
-      if (res<0) perror("asprintf");
-    }
-    else{
-      int res = asprintf(&temp_buffer, "%s %s", buffer, burger_names[choice]);
-      if (res<0) perror("asprintf");
-    }
-    
-    strncpy(buffer, temp_buffer, BUF_SIZE);
-    free(temp_buffer);
-
-    choices[i] = choice;
+  for (int i=0; i<burger_count; i++) choices[i] = rand() % menu->items;
+  if (retries > 0) {
+    snprintf(key, sizeof(key), "%x-%x-%u", (unsigned int)getpid(), (unsigned int)time(NULL),
+             __atomic_fetch_add(&next_key, 1, __ATOMIC_RELAXED));
   }
 
-  printf("[Thread %lu] To server: Can I have %s burger(s)?\n", tid, buffer);
-  
-  int str_len = strnlen(buffer, BUF_SIZE);
-  buffer[str_len] = '\n';
-
-  // Send request to the server
-  sent = put_line(serverfd, buffer, strlen(buffer));
+  sent = send_request(serverfd, key, choices, burger_count);
   if (sent < 0) {
     printf("Error: cannot send data to server\n");
     error_client(serverfd);
   }
 
-  // Get final message from the server
-  memset(buffer, 0, BUF_SIZE);
-  read = get_line(serverfd, &buffer, &buflen);
-  if (read <= 0) {
-    printf("Cannot read data from server\n");
-    error_client(serverfd);
+  // Only spell out small requests
+  flockfile(stdout);
+  if (burger_count <= MAX_BURGERS) {
+    printf("[Thread %lu] To server: Can I have", tid);
+    for (int i=0; i<burger_count; i++) printf(" %s", menu->item[choices[i]].name);
+    printf(" burger(s)?\n");
+  } else {
+    printf("[Thread %lu] To server: Can I have %u burger(s)?\n", tid, burger_count);
+  }
+  funlockfile(stdout);
+
+  if (fast_open) {
+    read = get_line(serverfd, &buffer, &buflen);
+    if (read <= 0) {
+      printf("Cannot read data from server\n");
+      error_client(serverfd);
+    }
+
+    printf("[Thread %lu] From server: %s", tid, buffer);
   }
 
+  // Get burgers and final message from the server
+  // Streamed responses send a "ready: <burger>" line per burger before the final message.
+  // With retries, a request whose connection is lost or whose response takes longer than the
+  // timeout is sent again with the same key; the server hands over the burgers it made for
+  // the first one. Every retry waits twice as long.
+  for (attempt = 0; ; attempt++) {
+    if (timeout > 0) {
+      tv.tv_sec = (time_t)(timeout * (1 << attempt));
+      tv.tv_usec = (suseconds_t)((timeout * (1 << attempt) - tv.tv_sec) * 1e6);
+      setsockopt(serverfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    do {
+      memset(buffer, 0, BUF_SIZE);
+      read = get_line(serverfd, &buffer, &buflen);
+      if (read <= 0) break;
+
+      if (strncmp(buffer, "ready: ", 7) != 0) break;
+
+      if (ready_count++ == 0) timing->first = elapsed(&start);
+      if (burger_count <= MAX_BURGERS) printf("[Thread %lu] From server: %s", tid, buffer);
+    } while (1);
+    if (read > 0) break;
+
+    if (attempt == retries) {
+      printf("Cannot read data from server\n");
+      error_client(serverfd);
+    }
+    printf("[Thread %lu] No response, ordering again with key %s\n", tid, key);
+    close(serverfd);
+    ready_count = 0;
+    serverfd = connect_server();
+    if ((serverfd >= 0) && (get_line(serverfd, &buffer, &buflen) > 0)) {
+      send_request(serverfd, key, choices, burger_count);
+    }
+  }
+
+  timing->last = elapsed(&start);
+  if (ready_count == 0) timing->first = timing->last;
+  timing->done = true;
+
   printf("[Thread %lu] From server: %s", tid, buffer);
+  printf("[Thread %lu] First burger after %.3f s, last burger after %.3f s\n",
+         tid, timing->first, timing->last);
 
   free(choices);
 
   close(serverfd);
-  freeaddrinfo(ai);
+  freesocklist(ai);
   pthread_exit(NULL);
 }
 
+/// @brief connect to the server
+/// @retval socket
+/// @retval -1 on error
+int connect_server(void)
+{
+  struct addrinfo *ai, *ai_it;
+  int fd = -1, res;
+
+  if (unix_path) ai = getsocklist(unix_path, 0, AF_UNIX, SOCK_STREAM, 0, &res);
+  else ai = getsocklist(IP, port, AF_INET, SOCK_STREAM, 0, &res);
+
+  for (ai_it = ai; ai_it != NULL; ai_it = ai_it->ai_next) {
+    fd = socket(ai_it->ai_family, ai_it->ai_socktype, ai_it->ai_protocol);
+    if (fd == -1) continue;
+    if (connect(fd, ai_it->ai_addr, ai_it->ai_addrlen) == 0) break;
+    close(fd);
+    fd = -1;
+  }
+  freesocklist(ai);
+  return fd;
+}
+
+/// @brief send a recorded request as it was sent, and wait for the response. Requests of
+///        customers who hung up are sent and abandoned; invalid requests get an invalid option
+///        at the end, so the server refuses them again.
+/// @param r request
+void replay_request(Replayed *r)
+{
+  const TraceRecord *rec = r->rec;
+  const TraceMix *mix = trace_mix(rec);
+  const char *name;
+  struct timespec start;
+  size_t buflen = 256;
+  char *buffer = (char *)malloc(buflen), option[64];
+  Writer *w;
+  int fd;
+
+  if ((fd = connect_server()) < 0) goto out;
+  if (get_line(fd, &buffer, &buflen) <= 0) goto out;
+
+  w = (Writer *)malloc(sizeof(Writer));
+  w->sock = fd;
+  w->len = 0;
+  w->error = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (rec->flags & TRACE_STREAM) write_str(w, "stream=1 ");
+  if (rec->deadline_ms) {
+    snprintf(option, sizeof(option), "deadline=%.3f ", rec->deadline_ms / 1000.0);
+    write_str(w, option);
+  }
+  for (unsigned int i = 0; i < rec->ntypes; i++) {
+    name = r->trace->names + mix[i].type * TRACE_NAME_SIZE;
+    for (unsigned int j = 0; j < mix[i].count; j++) {
+      write_str(w, name);
+      write_str(w, " ");
+    }
+  }
+  if (rec->outcome == TRACE_INVALID) write_str(w, "invalid=1");
+  write_str(w, "\n");
+  r->sent = (flush_writer(w) == 0);
+  free(w);
+
+  // Read the response; a streamed one sends a line per burger first
+  if (r->sent && (rec->outcome != TRACE_LEFT)) {
+    while (get_line(fd, &buffer, &buflen) > 0) {
+      if (strncmp(buffer, "ready: ", 7) == 0) continue;
+      r->answered = true;
+      r->served = (strncmp(buffer, "Sorry", 5) != 0);
+      break;
+    }
+    r->latency = elapsed(&start);
+  }
+
+out:
+  if (fd >= 0) close(fd);
+  free(buffer);
+}
+
+/// @brief replay task: take the next request in arrival order, wait for its recorded arrival and
+///        replay it, until every request is taken. A request starts late if all workers are busy.
+/// @param data Schedule
+void *replay_task(void *data)
+{
+  Schedule *s = (Schedule *)data;
+  struct timespec at;
+  uint64_t ns;
+  size_t i;
+
+  while ((i = __atomic_fetch_add(&s->next, 1, __ATOMIC_RELAXED)) < s->n) {
+    // Keep the recorded gaps between arrivals, compressed by the speed-up
+    if (replay_speed > 0) {
+      ns = (uint64_t)((s->reps[i].rec->arrival_us - s->reps[0].rec->arrival_us) * 1000 /
+                      replay_speed);
+      at.tv_sec = s->start.tv_sec + (s->start.tv_nsec + ns) / 1000000000ULL;
+      at.tv_nsec = (s->start.tv_nsec + ns) % 1000000000ULL;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, NULL) == EINTR);
+      s->reps[i].lag = elapsed(&at);
+    }
+    replay_request(&s->reps[i]);
+  }
+
+  return NULL;
+}
+
+/// @brief compare two doubles, for qsort()
+int compare_double(const void *a, const void *b)
+{
+  double da = *(const double *)a, db = *(const double *)b;
+
+  return (da > db) - (da < db);
+}
+
+/// @brief print a row of the replay report
+/// @param what name of the row
+/// @param recorded recorded value
+/// @param replayed replayed value
+void print_row(const char *what, double recorded, double replayed)
+{
+  printf("%-24s %12.3f %12.3f", what, recorded, replayed);
+  if (recorded > 0) printf(" %+8.1f%%", 100.0 * (replayed - recorded) / recorded);
+  printf("\n");
+}
+
+/// @brief replay the trace replay_path against the server with the recorded gaps between
+///        arrivals, divided by replay_speed, on up to replay_workers threads, and compare the
+///        result with the recorded run
+/// @retval 0 on success
+/// @retval -1 if the trace cannot be loaded
+int replay(void)
+{
+  Trace t;
+  Replayed *reps;
+  Schedule sched;
+  pthread_t *tids;
+  pthread_attr_t attr;
+  double *rec_lat, *rep_lat, rec_end = 0, rep_end, offset;
+  size_t i, n, rec_served = 0, rep_served = 0, rec_rejected = 0, rep_rejected = 0;
+  size_t rec_burgers = 0, rep_burgers = 0, late = 0, j, workers, started = 0;
+
+  if (trace_load(replay_path, &t) < 0) {
+    perror(replay_path);
+    return -1;
+  }
+  n = t.count;
+  reps = (Replayed *)calloc(n + 1, sizeof(Replayed));
+  workers = (replay_workers < n) ? replay_workers : n;
+  tids = (pthread_t *)calloc(workers + 1, sizeof(pthread_t));
+  rec_lat = (double *)calloc(n + 1, sizeof(double));
+  rep_lat = (double *)calloc(n + 1, sizeof(double));
+
+  printf("Replaying %zu request(s) of %s ", n, replay_path);
+  if (replay_speed > 0) printf("at %gx\n", replay_speed);
+  else printf("as fast as possible\n");
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, REPLAY_STACK);
+
+  for (i = 0; i < n; i++) {
+    reps[i].trace = &t;
+    reps[i].rec = t.records[i];
+  }
+  sched.reps = reps;
+  sched.n = n;
+  sched.next = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &sched.start);
+  for (i = 0; i < workers; i++) {
+    if (pthread_create(&tids[started], &attr, replay_task, &sched) == 0) started++;
+  }
+  if ((started == 0) && (n > 0)) replay_task(&sched);
+  for (i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  rep_end = elapsed(&sched.start);
+  pthread_attr_destroy(&attr);
+
+  // Served requests of both runs; throughput over the span from the first arrival to the last
+  // response
+  for (i = 0; i < n; i++) {
+    const TraceRecord *rec = reps[i].rec;
+
+    for (j = 0; j < rec->ntypes; j++) {
+      if (rec->outcome == TRACE_SERVED) rec_burgers += trace_mix(rec)[j].count;
+      if (reps[i].served) rep_burgers += trace_mix(rec)[j].count;
+    }
+    offset = (rec->arrival_us - t.records[0]->arrival_us) / 1e6;
+    if (offset + rec->latency_us / 1e6 > rec_end) rec_end = offset + rec->latency_us / 1e6;
+    if (rec->outcome == TRACE_SERVED) rec_lat[rec_served++] = rec->latency_us / 1e6;
+    if (rec->outcome == TRACE_REJECTED) rec_rejected++;
+    if (reps[i].served) rep_lat[rep_served++] = reps[i].latency;
+    else if (reps[i].answered) rep_rejected++;
+    if (reps[i].lag * 1000 > REPLAY_LATE_MS) late++;
+  }
+  qsort(rec_lat, rec_served, sizeof(double), compare_double);
+  qsort(rep_lat, rep_served, sizeof(double), compare_double);
+
+  printf("\n====== Replay ======\n");
+  if (started < workers) printf("%zu of %zu worker(s) could not be started\n", workers - started,
+                                workers);
+  if (late > 0) {
+    printf("%zu request(s) started more than %d ms late; all %zu worker(s) were busy (see -w)\n",
+           late, REPLAY_LATE_MS, started);
+  }
+  printf("%-24s %12s %12s %9s\n", "", "recorded", "replayed", "change");
+  printf("%-24s %12zu %12zu\n", "requests served", rec_served, rep_served);
+  printf("%-24s %12zu %12zu\n", "requests rejected", rec_rejected, rep_rejected);
+  printf("%-24s %12zu %12zu\n", "requests not served", n - rec_served - rec_rejected,
+         n - rep_served - rep_rejected);
+  print_row("duration (s)", rec_end, rep_end);
+  print_row("requests served/s", rec_end > 0 ? rec_served / rec_end : 0,
+            rep_end > 0 ? rep_served / rep_end : 0);
+  print_row("burgers served/s", rec_end > 0 ? rec_burgers / rec_end : 0,
+            rep_end > 0 ? rep_burgers / rep_end : 0);
+  if ((rec_served > 0) && (rep_served > 0)) {
+    double rec_sum = 0, rep_sum = 0;
+
+    for (i = 0; i < rec_served; i++) rec_sum += rec_lat[i];
+    for (i = 0; i < rep_served; i++) rep_sum += rep_lat[i];
+    print_row("latency avg (s)", rec_sum / rec_served, rep_sum / rep_served);
+    print_row("latency p50 (s)", rec_lat[rec_served / 2], rep_lat[rep_served / 2]);
+    print_row("latency p99 (s)", rec_lat[rec_served * 99 / 100], rep_lat[rep_served * 99 / 100]);
+    print_row("latency max (s)", rec_lat[rec_served - 1], rep_lat[rep_served - 1]);
+  }
+
+  free(reps);
+  free(tids);
+  free(rec_lat);
+  free(rep_lat);
+  trace_free(&t);
+  return 0;
+}
+
 /// @brief program entry point
-int main(int argc, char const *argv[])
+int main(int argc, char *argv[])
 {
-  int i;
-  int num_threads;
+  int i, opt;
+  int num_threads, num_done = 0;
+  double sum_first = 0, sum_last = 0, max_first = 0, max_last = 0;
 
-  if (argc != 2) {
-    printf("usage ./client <num_threads>\n");
+  while ((opt = getopt(argc, argv, "sfu:p:M:P:x:w:r:t:")) != -1) {
+    switch (opt) {
+      case 's': stream = true; break;
+      case 'f': fast_open = true; break;
+      case 'r': retries = atoi(optarg); break;
+      case 't': timeout = atof(optarg); break;
+      case 'M': menu_path = optarg; break;
+      case 'P': replay_path = optarg; break;
+      case 'x': replay_speed = atof(optarg); break;
+      case 'w': replay_workers = atoi(optarg); break;
+      case 'u': unix_path = optarg; break;
+      case 'p': port = atoi(optarg); break;
+      default:
+        printf("usage ./client [-s] [-f] [-r <retries>] [-t <sec>] [-u <path>] [-p <port>] [-M <menu>]\n"
+           "               <num_threads> [<num_burgers>]\n"
+           "      ./client [-u <path>] [-p <port>] -P <trace> [-x <speed>] [-w <workers>]\n");
+        return 0;
+    }
+  }
+  argc -= optind - 1;
+  argv += optind - 1;
+
+  if (replay_path) return (replay() < 0) ? EXIT_FAILURE : 0;
+
+  if ((argc != 2) && (argc != 3)) {
+    printf("usage ./client [-s] [-f] [-r <retries>] [-t <sec>] [-u <path>] [-p <port>] [-M <menu>]\n"
+           "               <num_threads> [<num_burgers>]\n"
+           "      ./client [-u <path>] [-p <port>] -P <trace> [-x <speed>] [-w <workers>]\n");
+    return 0;
+  }
+
+  if (argc == 3) {
+    num_burgers = atoi(argv[2]);
+    if (num_burgers == 0) {
+      printf("number of burgers must be positive\n");
+      return 0;
+    }
+  }
+
+  // Order only burgers the server has on its menu
+  if (menu_load(menu_path) < 0) {
+    perror(menu_path ? menu_path : "menu");
     return 0;
   }
 
@@ -188,13 +660,32 @@ int main(int argc, char const *argv[])
 
   num_threads = atoi(argv[1]);
   pthread_t tids[num_threads];
+  Timing *timings = (Timing *)calloc(num_threads, sizeof(Timing));
   for (i = 0; i < num_threads; i++) {
-    pthread_create(&tids[i], NULL, thread_task, NULL);
+    pthread_create(&tids[i], NULL, thread_task, &timings[i]);
   }
 
   for (i = 0; i < num_threads; i++) {
     pthread_join(tids[i], NULL);
   }
 
+  // Summarize time to first and last burger over all served requests
+  for (i = 0; i < num_threads; i++) {
+    if (!timings[i].done) continue;
+    num_done++;
+    sum_first += timings[i].first;
+    sum_last += timings[i].last;
+    if (timings[i].first > max_first) max_first = timings[i].first;
+    if (timings[i].last > max_last) max_last = timings[i].last;
+  }
+
+  if (num_done > 0) {
+    printf("\n====== Statistics ======\n");
+    printf("Requests served: %d/%d\n", num_done, num_threads);
+    printf("Time to first burger: avg %.3f s, max %.3f s\n", sum_first / num_done, max_first);
+    printf("Time to last burger: avg %.3f s, max %.3f s\n", sum_last / num_done, max_last);
+  }
+  free(timings);
+
   return 0;
 }
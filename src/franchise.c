@@ -0,0 +1,928 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  franchise.c
+/// @brief Front-end router of a McDonald's franchise: forwards customers to one of several servers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab configurable backlog, TCP Fast Open and deferred accept; drain accepts
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+/// 2026/10/19 ARC lab back off accepting when out of file descriptors
+/// 2026/10/19 ARC lab relay both directions without blocking
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+
+#include "net.h"
+#include "burger.h"
+#include "log.h"
+#include "stats.h"
+#include "lockprof.h"
+
+/// @name Macro definitions
+/// @{
+
+#define BACKEND_MAX 64                                    ///< max. number of servers
+#define BACKEND_VNODES 64                                 ///< points of a server on the hash ring
+#define BACKEND_RETRY_MS 2000                             ///< a failed server is skipped this long
+#define MONITOR_MS 200                                    ///< interval of reading the statistics
+#define RELAY_SIZE 16384                                  ///< relay buffer per direction
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief how the router picks a server for a customer
+enum policy {
+  POLICY_HASH,                                              ///< consistent hashing of address and port
+  POLICY_HASH_IP,                                           ///< consistent hashing of the address
+  POLICY_LEAST,                                             ///< least outstanding orders
+  POLICY_MAX
+};
+
+/// @brief a server of the franchise. Servers are never freed, so that their names can be logged
+///        asynchronously and connections can finish on a server that was removed.
+typedef struct __backend {
+  char name[128];                                           ///< host:port
+  struct sockaddr_storage addr;                             ///< address of the server
+  socklen_t addrlen;                                        ///< length of addr
+  char stats[128];                                          ///< shared memory of its statistics
+  const StatsShm *shm;                                      ///< mapped statistics (NULL: none)
+  uint64_t ino;                                             ///< inode of the mapped statistics
+  bool from_file;                                           ///< configured in the backends file
+  bool seen;                                                ///< found while reading the file
+  bool removed;                                             ///< not part of the franchise anymore
+  bool drain;                                               ///< configured to drain
+  bool draining;                                            ///< the server reports it is draining
+  uint64_t down_until;                                      ///< failed; skipped until then (ms)
+  uint64_t queued;                                          ///< orders waiting in its kitchen
+  unsigned int active;                                      ///< connections being forwarded
+  uint64_t outstanding;                                     ///< forwarded burgers not yet served
+  uint64_t customers;                                       ///< customers forwarded
+  uint64_t burgers;                                         ///< burgers ordered through the router
+  uint64_t failures;                                        ///< failed connection attempts
+} Backend;
+
+/// @brief a point of a server on the hash ring
+typedef struct __point {
+  uint64_t hash;                                            ///< position on the ring
+  Backend *backend;                                         ///< server
+} Point;
+
+/// @brief state of the router
+struct franchise {
+  Backend *backends[BACKEND_MAX];                           ///< servers
+  unsigned int nbackends;                                   ///< number of servers
+  Point ring[BACKEND_MAX * BACKEND_VNODES];                 ///< hash ring, sorted by hash
+  unsigned int npoints;                                     ///< number of points on the ring
+  unsigned int next;                                        ///< rotates ties of POLICY_LEAST
+  unsigned int active;                                      ///< customers being forwarded
+  pthread_mutex_t lock;                                     ///< lock variable for the router
+  pthread_cond_t idle;                                      ///< signals that all customers left
+};
+
+/// @brief a customer being forwarded
+typedef struct __customer {
+  int fd;                                                   ///< socket of the customer
+  uint64_t key;                                             ///< hash of the customer's address
+} Customer;
+
+/// @brief counts the burgers of a request passing through: tokens of the first line that are
+///        not options
+typedef struct __counter {
+  bool in_token;                                            ///< inside a token
+  bool option;                                              ///< token is a key=value option
+  bool done;                                                ///< end of the request seen
+  unsigned int count;                                       ///< burgers so far
+} Counter;
+
+/// @brief one direction of a relayed connection
+typedef struct __relay_dir {
+  int from;                                                 ///< socket data is received from
+  int to;                                                   ///< socket data is sent to
+  size_t head;                                              ///< start of the data not sent yet
+  size_t tail;                                              ///< end of the data not sent yet
+  bool eof;                                                 ///< the receiving side is closed
+  char buf[RELAY_SIZE];                                     ///< data received
+} RelayDir;
+
+/// @}
+
+/// @name Global variables
+/// @{
+
+const char *policy_names[POLICY_MAX] = { "hash", "hash-ip", "least" };  ///< names of policies
+
+struct franchise fr = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .idle = PTHREAD_COND_INITIALIZER,
+};
+enum policy policy = POLICY_HASH;                           ///< policy of the router
+unsigned short port = PORT;                                 ///< port of the router
+char *backends_file = NULL;                                 ///< backends file (NULL: none)
+int backlog = LISTEN_BACKLOG;                               ///< backlog of the listening socket
+int fastopen = LISTEN_FASTOPEN;                             ///< TCP Fast Open queue (0: off)
+int defer_accept = 0;                                       ///< seconds to wait for data (0: off)
+int wake_pipe[2];                                           ///< wakes up main thread on signals
+volatile sig_atomic_t keep_running = 1;                     ///< keeps accepting customers
+volatile sig_atomic_t reload = 0;                           ///< re-read the backends file
+volatile bool monitoring = true;                            ///< keeps the monitor running
+
+/// @}
+
+
+/// @brief current time
+/// @retval milliseconds on CLOCK_MONOTONIC
+uint64_t now_ms(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000ULL + now.tv_nsec / 1000000;
+}
+
+/// @brief 64-bit hash of a byte string (FNV-1a, finalized with splitmix64)
+/// @param data data
+/// @param len length of @a data
+/// @retval hash
+uint64_t hash_bytes(const void *data, size_t len)
+{
+  const unsigned char *p = (const unsigned char *)data;
+  uint64_t x = 0xcbf29ce484222325ULL;
+  size_t i;
+
+  for (i = 0; i < len; i++) x = (x ^ p[i]) * 0x100000001b3ULL;
+
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/// @brief true if a server may get new customers. Must be called with fr.lock held.
+/// @param b server
+/// @param now current time (ms)
+bool eligible(const Backend *b, uint64_t now)
+{
+  return !b->removed && !b->drain && !b->draining && (now >= b->down_until);
+}
+
+/// @brief compare two points of the ring by hash
+int cmp_point(const void *a, const void *b)
+{
+  uint64_t x = ((const Point *)a)->hash, y = ((const Point *)b)->hash;
+
+  return (x > y) - (x < y);
+}
+
+/// @brief rebuild the hash ring from the servers. Servers that drain or failed keep their points,
+///        so that a customer only moves if its own server is unavailable. Must be called with
+///        fr.lock held.
+void build_ring(void)
+{
+  char vnode[160];
+  unsigned int i, v;
+  int len;
+
+  fr.npoints = 0;
+  for (i = 0; i < fr.nbackends; i++) {
+    if (fr.backends[i]->removed) continue;
+    for (v = 0; v < BACKEND_VNODES; v++) {
+      len = snprintf(vnode, sizeof(vnode), "%s#%u", fr.backends[i]->name, v);
+      fr.ring[fr.npoints].hash = hash_bytes(vnode, len);
+      fr.ring[fr.npoints].backend = fr.backends[i];
+      fr.npoints++;
+    }
+  }
+  qsort(fr.ring, fr.npoints, sizeof(Point), cmp_point);
+}
+
+/// @brief find a server by name. Must be called with fr.lock held.
+/// @param name host:port
+/// @retval Backend* server
+/// @retval NULL if there is no such server
+Backend* find_backend(const char *name)
+{
+  unsigned int i;
+
+  for (i = 0; i < fr.nbackends; i++) {
+    if (strcmp(fr.backends[i]->name, name) == 0) return fr.backends[i];
+  }
+  return NULL;
+}
+
+/// @brief add a server, or update it if it is known. Must be called with fr.lock held.
+/// @param spec host:port[=<statistics>]. Servers on localhost publish their statistics under the
+///        default name of their port unless another name (or "" for none) is given.
+/// @param from_file server is configured in the backends file
+/// @param drain server is configured to drain
+/// @retval 0 on success
+/// @retval -1 if @a spec is invalid or the server cannot be resolved
+int add_backend(const char *spec, bool from_file, bool drain)
+{
+  char host[128], name[128], *colon, *eq, *end;
+  struct addrinfo *ai;
+  Backend *b;
+  long p;
+
+  strncpy(name, spec, sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+  if ((eq = strchr(name, '=')) != NULL) *eq++ = '\0';
+
+  colon = strrchr(name, ':');
+  if (colon == NULL) return -1;
+  p = strtol(colon + 1, &end, 10);
+  if ((end == colon + 1) || (*end != '\0') || (p <= 0) || (p > 65535)) return -1;
+  snprintf(host, sizeof(host), "%.*s", (int)(colon - name), name);
+
+  if ((b = find_backend(name)) == NULL) {
+    if (fr.nbackends == BACKEND_MAX) return -1;
+
+    ai = getsocklist(host, p, AF_UNSPEC, SOCK_STREAM, 0, NULL);
+    if (ai == NULL) return -1;
+
+    b = (Backend *)calloc(1, sizeof(Backend));
+    if (b == NULL) {
+      freesocklist(ai);
+      return -1;
+    }
+    strcpy(b->name, name);
+    memcpy(&b->addr, ai->ai_addr, ai->ai_addrlen);
+    b->addrlen = ai->ai_addrlen;
+    freesocklist(ai);
+
+    if (eq) strncpy(b->stats, eq, sizeof(b->stats) - 1);
+    else if ((strcmp(host, "localhost") == 0) || (strcmp(host, "127.0.0.1") == 0)) {
+      if (p == PORT) snprintf(b->stats, sizeof(b->stats), "%s", STATS_NAME);
+      else snprintf(b->stats, sizeof(b->stats), "%s.%ld", STATS_NAME, p);
+    }
+
+    fr.backends[fr.nbackends++] = b;
+    log_info("Added %s", b->name);
+  } else if (b->removed) {
+    b->removed = false;
+    log_info("Added %s", b->name);
+  }
+
+  if (b->drain != drain) log_info("%s %s", b->name, drain ? "drains" : "takes customers again");
+  b->from_file = from_file;
+  b->drain = drain;
+  b->seen = true;
+
+  return 0;
+}
+
+/// @brief read the backends file: one server per line, host:port[=<statistics>], optionally
+///        followed by the word `drain`. Servers that are not in the file anymore are removed;
+///        their customers are served to the end.
+/// @param path backends file
+/// @retval 0 on success
+/// @retval -1 if the file cannot be read
+int load_backends(const char *path)
+{
+  char line[256], spec[200], word[16];
+  FILE *f;
+  unsigned int i;
+  int n;
+
+  if ((f = fopen(path, "r")) == NULL) return -1;
+
+  pthread_mutex_lock(&fr.lock);
+  for (i = 0; i < fr.nbackends; i++) fr.backends[i]->seen = false;
+
+  while (fgets(line, sizeof(line), f) != NULL) {
+    line[strcspn(line, "#\n")] = '\0';
+    word[0] = '\0';
+    n = sscanf(line, "%199s %15s", spec, word);
+    if (n < 1) continue;
+    if ((n == 2) && (strcmp(word, "drain") != 0)) {
+      log_warn("%s: invalid line", path);
+      continue;
+    }
+    if (add_backend(spec, true, n == 2) < 0) log_warn("%s: invalid server", path);
+  }
+  fclose(f);
+
+  for (i = 0; i < fr.nbackends; i++) {
+    if (fr.backends[i]->from_file && !fr.backends[i]->seen && !fr.backends[i]->removed) {
+      fr.backends[i]->removed = true;
+      log_info("Removed %s", fr.backends[i]->name);
+    }
+  }
+  build_ring();
+  pthread_mutex_unlock(&fr.lock);
+
+  return 0;
+}
+
+/// @brief pick a server for a customer and count it as active on the server
+/// @param key hash of the customer
+/// @param tried servers that failed for this customer
+/// @param ntried number of servers in @a tried
+/// @retval Backend* server
+/// @retval NULL if no server is available
+Backend* pick_backend(uint64_t key, Backend **tried, unsigned int ntried)
+{
+  Backend *b, *best = NULL;
+  uint64_t now = now_ms(), load, best_load = 0;
+  unsigned int i, j, lo, hi;
+
+  pthread_mutex_lock(&fr.lock);
+
+  if (policy == POLICY_LEAST) {
+    // Orders forwarded by us and not served yet, plus the backlog the server reports (which
+    // includes customers that did not come through the router); fewer connections break ties
+    for (i = 0; i < fr.nbackends; i++) {
+      b = fr.backends[(fr.next + i) % fr.nbackends];
+      for (j = 0; (j < ntried) && (tried[j] != b); j++);
+      if ((j < ntried) || !eligible(b, now)) continue;
+
+      load = b->outstanding + b->queued;
+      if ((best == NULL) || (load < best_load) ||
+          ((load == best_load) && (b->active < best->active))) {
+        best = b;
+        best_load = load;
+      }
+    }
+    fr.next++;
+  } else {
+    // First point at or after the key; walk on past servers that are not available
+    lo = 0;
+    hi = fr.npoints;
+    while (lo < hi) {
+      i = (lo + hi) / 2;
+      if (fr.ring[i].hash < key) lo = i + 1;
+      else hi = i;
+    }
+    for (i = 0; (i < fr.npoints) && (best == NULL); i++) {
+      b = fr.ring[(lo + i) % fr.npoints].backend;
+      for (j = 0; (j < ntried) && (tried[j] != b); j++);
+      if ((j == ntried) && eligible(b, now)) best = b;
+    }
+  }
+
+  if (best) best->active++;
+  pthread_mutex_unlock(&fr.lock);
+
+  return best;
+}
+
+/// @brief connect to a server
+/// @param b server
+/// @retval socket
+/// @retval -1 on error
+int connect_backend(Backend *b)
+{
+  int fd, opt = 1;
+
+  fd = socket(b->addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+
+  if (connect(fd, (struct sockaddr *)&b->addr, b->addrlen) < 0) {
+    close(fd);
+    return -1;
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+  return fd;
+}
+
+/// @brief count the burgers in a piece of the request
+/// @param c counter
+/// @param buf piece of the request
+/// @param len length of @a buf
+/// @retval number of burgers completed in this piece
+unsigned int count_burgers(Counter *c, const char *buf, size_t len)
+{
+  unsigned int before = c->count;
+  size_t i;
+  bool sep;
+
+  for (i = 0; (i < len) && !c->done; i++) {
+    sep = (buf[i] == ' ') || (buf[i] == '\n') || (buf[i] == '\r') || (buf[i] == '\t');
+    if (sep) {
+      if (c->in_token && !c->option) c->count++;
+      c->in_token = false;
+      c->done = (buf[i] == '\n');
+    } else if (!c->in_token) {
+      c->in_token = true;
+      c->option = (buf[i] == '=');
+    } else if (buf[i] == '=') {
+      c->option = true;
+    }
+  }
+
+  return c->count - before;
+}
+
+/// @brief move the data of one direction of a relayed connection: receive when the buffer is
+///        empty, then send as much of it as the peer takes. Never blocks.
+/// @param d direction
+/// @param rx data or an end of file may be waiting on the receiving socket
+/// @retval number of bytes received
+/// @retval -1 if sending failed
+ssize_t pump(RelayDir *d, bool rx)
+{
+  ssize_t n, received = 0;
+
+  if (rx && !d->eof && (d->head == d->tail)) {
+    n = recv(d->from, d->buf, RELAY_SIZE, MSG_DONTWAIT);
+    if (n > 0) {
+      d->head = 0;
+      d->tail = received = n;
+    } else if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR))) {
+      d->eof = true;
+    }
+  }
+
+  while (d->head < d->tail) {
+    n = send(d->to, d->buf + d->head, d->tail - d->head, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) break;
+      return -1;
+    }
+    d->head += n;
+  }
+
+  return received;
+}
+
+/// @brief forward data between a customer and a server until the server closes the connection.
+///        Both directions move on their own, so that a server streaming its reply to a customer
+///        who is still sending does not stall the relay. The burgers of the request count as
+///        outstanding on the server until then.
+/// @param clientfd socket of the customer
+/// @param serverfd socket of the server
+/// @param b server
+/// @retval number of burgers ordered
+unsigned int relay(int clientfd, int serverfd, Backend *b)
+{
+  struct pollfd pfd[2];
+  RelayDir *up, *down;
+  Counter counter;
+  ssize_t n;
+  unsigned int burgers;
+  bool shut = false;
+
+  up = calloc(2, sizeof(*up));
+  if (up == NULL) return 0;
+  down = up + 1;
+  up->from = down->to = clientfd;
+  up->to = down->from = serverfd;
+  memset(&counter, 0, sizeof(counter));
+
+  pfd[0].revents = pfd[1].revents = POLLIN;
+  while (1) {
+    // Customer to server; an end of file is passed on as a half close once the data is sent
+    if ((n = pump(up, pfd[0].revents != 0)) < 0) break;
+    if (n > 0) {
+      burgers = count_burgers(&counter, up->buf, n);
+      if (burgers > 0) __atomic_add_fetch(&b->outstanding, burgers, __ATOMIC_RELAXED);
+    }
+    if (up->eof && (up->head == up->tail) && !shut) {
+      shutdown(serverfd, SHUT_WR);
+      shut = true;
+    }
+
+    // Server to customer; the server closes the connection once the customer is served
+    if (pump(down, pfd[1].revents != 0) < 0) break;
+    if (down->eof && (down->head == down->tail)) break;
+
+    // Wait for data to fill an empty buffer or for room to send a full one. A socket with
+    // nothing to wait for is left out, so that its hangup does not wake the relay over and over.
+    pfd[0].events = ((!up->eof && (up->head == up->tail)) ? POLLIN : 0) |
+                    ((down->head < down->tail) ? POLLOUT : 0);
+    pfd[1].events = ((!down->eof && (down->head == down->tail)) ? POLLIN : 0) |
+                    ((up->head < up->tail) ? POLLOUT : 0);
+    pfd[0].fd = pfd[0].events ? clientfd : -1;
+    pfd[1].fd = pfd[1].events ? serverfd : -1;
+    if (poll(pfd, 2, -1) < 0) {
+      if (errno != EINTR) break;
+      pfd[0].revents = pfd[1].revents = 0;
+    }
+  }
+
+  // A burger name cut off by the end of the request still counts
+  if (counter.in_token && !counter.option) {
+    counter.count++;
+    __atomic_add_fetch(&b->outstanding, 1, __ATOMIC_RELAXED);
+  }
+
+  free(up);
+  return counter.count;
+}
+
+/// @brief customer task: connect the customer to a server and forward the connection. If a
+///        server cannot be reached, it is skipped for BACKEND_RETRY_MS and the next is tried.
+/// @param arg Customer*
+void* customer_task(void *arg)
+{
+  Customer *c = (Customer *)arg;
+  Backend *b, *tried[BACKEND_MAX];
+  unsigned int ntried = 0, burgers;
+  int serverfd = -1;
+
+  while ((b = pick_backend(c->key, tried, ntried)) != NULL) {
+    if ((serverfd = connect_backend(b)) >= 0) break;
+
+    pthread_mutex_lock(&fr.lock);
+    b->active--;
+    b->failures++;
+    if (now_ms() >= b->down_until) log_warn("%s is down", b->name);
+    b->down_until = now_ms() + BACKEND_RETRY_MS;
+    pthread_mutex_unlock(&fr.lock);
+
+    tried[ntried++] = b;
+  }
+
+  if (b == NULL) {
+    log_warn("No restaurant of the franchise is open. Connection refused.");
+  } else {
+    log_debug("Customer sent to %s", b->name);
+    burgers = relay(c->fd, serverfd, b);
+    close(serverfd);
+
+    pthread_mutex_lock(&fr.lock);
+    __atomic_sub_fetch(&b->outstanding, burgers, __ATOMIC_RELAXED);
+    b->active--;
+    b->customers++;
+    b->burgers += burgers;
+    pthread_mutex_unlock(&fr.lock);
+  }
+
+  close(c->fd);
+  free(c);
+
+  pthread_mutex_lock(&fr.lock);
+  if (--fr.active == 0) pthread_cond_broadcast(&fr.idle);
+  pthread_mutex_unlock(&fr.lock);
+
+  return NULL;
+}
+
+/// @brief monitor thread: every MONITOR_MS, read the health and queue depth that local servers
+///        publish in their statistics. A draining or closed server gets no new customers.
+void* monitor_task(void *dummy)
+{
+  struct timespec ts = { 0, MONITOR_MS * 1000000L };
+  StatsSnapshot snap;
+  Backend *b;
+  unsigned int i, n;
+  bool draining;
+
+  while (monitoring) {
+    pthread_mutex_lock(&fr.lock);
+    n = fr.nbackends;
+    pthread_mutex_unlock(&fr.lock);
+
+    for (i = 0; i < n; i++) {
+      b = fr.backends[i];
+      if (b->stats[0] == '\0') continue;
+
+      // A server that restarted or took over publishes a new object under the same name
+      if (b->shm && (stats_ino(b->stats) != b->ino)) {
+        stats_detach(b->shm);
+        b->shm = NULL;
+      }
+      if (b->shm == NULL) b->shm = stats_attach(b->stats, &b->ino);
+
+      if (b->shm) {
+        stats_read(b->shm, &snap);
+        draining = (snap.state != STATS_RUNNING);
+      } else {
+        snap.queued = 0;
+        draining = false;
+      }
+
+      pthread_mutex_lock(&fr.lock);
+      if (draining != b->draining) {
+        log_info("%s %s", b->name, draining ? "is closing" : "is open");
+      }
+      b->draining = draining;
+      b->queued = snap.queued;
+      pthread_mutex_unlock(&fr.lock);
+    }
+
+    nanosleep(&ts, NULL);
+  }
+
+  return NULL;
+}
+
+/// @brief open the listening socket of the router
+/// @retval listening socket
+/// @retval -1 on error
+int open_listener(void)
+{
+  struct addrinfo *ai, *ai_it;
+  int fd = -1, opt = 1;
+
+  ai = getsocklist(NULL, port, AF_INET, SOCK_STREAM, 1, NULL);
+
+  for (ai_it = ai; ai_it != NULL; ai_it = ai_it->ai_next) {
+    fd = socket(ai_it->ai_family, ai_it->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                ai_it->ai_protocol);
+    if (fd < 0) continue;
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if ((bind(fd, ai_it->ai_addr, ai_it->ai_addrlen) == 0) &&
+        (listen_socket(fd, backlog, fastopen, defer_accept) == 0)) break;
+    close(fd);
+    fd = -1;
+  }
+  freesocklist(ai);
+
+  return fd;
+}
+
+/// @brief hash of a customer's address for consistent hashing
+/// @param sa address of the customer
+/// @retval hash
+uint64_t customer_key(const struct sockaddr_storage *sa)
+{
+  const struct sockaddr_in *in = (const struct sockaddr_in *)sa;
+  const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)sa;
+  unsigned char key[18];
+  size_t len;
+
+  if (sa->ss_family == AF_INET6) {
+    memcpy(key, &in6->sin6_addr, 16);
+    memcpy(key + 16, &in6->sin6_port, 2);
+    len = 16;
+  } else {
+    memcpy(key, &in->sin_addr, 4);
+    memcpy(key + 4, &in->sin_port, 2);
+    len = 4;
+  }
+  if (policy == POLICY_HASH) len += 2;
+
+  return hash_bytes(key, len);
+}
+
+/// @brief print per-server statistics
+void print_statistics(void)
+{
+  Backend *b;
+  unsigned int i;
+
+  printf("\n====== Franchise Statistics ======\n");
+  for (i = 0; i < fr.nbackends; i++) {
+    b = fr.backends[i];
+    printf("%s%s: %lu customer(s), %lu burger(s), %lu failed connection(s)\n", b->name,
+           b->removed ? " (removed)" : b->drain ? " (drained)" : "", (unsigned long)b->customers,
+           (unsigned long)b->burgers, (unsigned long)b->failures);
+  }
+  lockprof_dump(stdout);
+  printf("\n");
+}
+
+/// @brief Second SIGINT handler function
+/// @param sig signal number
+void sigint_handler2(int sig)
+{
+  log_close();
+  print_statistics();
+  exit(EXIT_SUCCESS);
+}
+
+/// @brief First SIGINT handler function. Stops accepting customers; the main thread then waits
+///        for the customers being forwarded. A second SIGINT exits immediately.
+/// @param sig signal number
+void sigint_handler(int sig)
+{
+  signal(SIGINT, sigint_handler2);
+  keep_running = 0;
+  if (write(wake_pipe[1], "", 1) < 0) {}
+}
+
+/// @brief SIGHUP handler function. Re-reads the backends file.
+/// @param sig signal number
+void sighup_handler(int sig)
+{
+  reload = 1;
+  if (write(wake_pipe[1], "", 1) < 0) {}
+}
+
+/// @brief print usage
+/// @param prog program name
+void usage(const char *prog)
+{
+  printf("usage %s [-p <port>] [-P <policy>] [-f <file>] [-L <level>] [-b <backlog>] [-F <qlen>]\n"
+         "          [-D <sec>] [<host:port>...]\n", prog);
+  printf("  -p <port>   port of the router (default: %d)\n", PORT);
+  printf("  -P <policy> hash: consistent hashing of the customer's address and port (default)\n"
+         "              hash-ip: consistent hashing of the customer's address\n"
+         "              least: server with the least outstanding orders\n");
+  printf("  -f <file>   backends file, one host:port[=<statistics>] [drain] per line; re-read on\n"
+         "              SIGHUP\n");
+  printf("  -L <level>  log level: error, warn, info, debug (default: %s)\n",
+         log_level_names[LOG_INFO]);
+  printf("  -b <backlog> connections waiting to be accepted (default: %d)\n", LISTEN_BACKLOG);
+  printf("  -F <qlen>   TCP Fast Open queue (default: %d, 0: off)\n", LISTEN_FASTOPEN);
+  printf("  -D <sec>    accept connections only once the customer has sent data, or after <sec>\n"
+         "              seconds (default: 0, off)\n");
+  printf("  <host:port> server of the franchise. Local servers are monitored through their\n"
+         "              statistics (%s.<port>); append =<name> for another name, = for none\n",
+         STATS_NAME);
+}
+
+/// @brief program entry point
+int main(int argc, char *argv[])
+{
+  struct pollfd pfd[2];
+  struct sockaddr_storage sa;
+  socklen_t salen;
+  pthread_t tid, monitor;
+  pthread_attr_t attr;
+  Customer *c;
+  int opt, level, listenfd, fd, timeout = -1;
+  unsigned int i;
+  char dummy;
+
+  while ((opt = getopt(argc, argv, "p:P:f:L:b:F:D:")) != -1) {
+    switch (opt) {
+      case 'p': port = atoi(optarg); break;
+      case 'f': backends_file = optarg; break;
+      case 'b': backlog = atoi(optarg); break;
+      case 'F': fastopen = atoi(optarg); break;
+      case 'D': defer_accept = atoi(optarg); break;
+      case 'P':
+        for (level = 0; (level < POLICY_MAX) && strcmp(optarg, policy_names[level]); level++);
+        if (level == POLICY_MAX) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        policy = level;
+        break;
+      case 'L':
+        if ((level = log_parse_level(optarg)) < 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        log_set_level(level);
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+
+  signal(SIGINT, sigint_handler);
+  signal(SIGHUP, sighup_handler);
+  signal(SIGPIPE, SIG_IGN);
+  log_init(STDOUT_FILENO);
+  if (pipe2(wake_pipe, O_CLOEXEC) < 0) perror("pipe2");
+
+  pthread_mutex_lock(&fr.lock);
+  for (i = optind; i < argc; i++) {
+    if (add_backend(argv[i], false, false) < 0) log_error("Error: invalid server %s", argv[i]);
+  }
+  build_ring();
+  pthread_mutex_unlock(&fr.lock);
+
+  if (backends_file && (load_backends(backends_file) < 0)) {
+    log_error("Error: cannot read %s", backends_file);
+  }
+  if (fr.nbackends == 0) {
+    log_close();
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  listenfd = open_listener();
+  if (listenfd < 0) {
+    log_error("Error: cannot listen on port %u", port);
+    log_close();
+    return EXIT_FAILURE;
+  }
+  log_info("Franchise of %u restaurant(s) listening on port %u, policy: %s", fr.nbackends, port,
+           policy_names[policy]);
+
+  pthread_create(&monitor, NULL, monitor_task, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  pfd[0].fd = listenfd;
+  pfd[0].events = POLLIN;
+  pfd[1].fd = wake_pipe[0];
+  pfd[1].events = POLLIN;
+
+  while (keep_running) {
+    if (poll(pfd, 2, timeout) < 0) {
+      if (errno == EINTR) continue;
+      perror("poll");
+      break;
+    }
+
+    // After a pause for lack of file descriptors, watch the listening socket again
+    if (pfd[0].fd < 0) {
+      pfd[0].fd = listenfd;
+      pfd[0].revents = 0;
+      timeout = -1;
+    }
+
+    if (pfd[1].revents) {
+      if (read(wake_pipe[0], &dummy, 1) < 0) {}
+      if (reload && backends_file) {
+        reload = 0;
+        if (load_backends(backends_file) < 0) log_warn("Cannot read %s", backends_file);
+      }
+    }
+
+    // The listening socket is non-blocking: take every waiting connection, up to a batch
+    for (i = 0; pfd[0].revents && (i < ACCEPT_BATCH); i++) {
+      salen = sizeof(sa);
+      fd = accept4(listenfd, (struct sockaddr *)&sa, &salen, SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno == EINTR) continue;
+        // Out of fds, the listening socket stays readable; leave it out of poll() for a while
+        // (poll ignores fd -1) instead of spinning on it
+        if ((errno == EMFILE) || (errno == ENFILE)) {
+          pfd[0].fd = -1;
+          timeout = ACCEPT_BACKOFF_MS;
+        }
+        break;
+      }
+
+      c = (Customer *)malloc(sizeof(Customer));
+      if (c == NULL) {
+        close(fd);
+        continue;
+      }
+      c->fd = fd;
+      c->key = customer_key(&sa);
+
+      pthread_mutex_lock(&fr.lock);
+      fr.active++;
+      pthread_mutex_unlock(&fr.lock);
+
+      if (pthread_create(&tid, &attr, customer_task, c) != 0) {
+        close(fd);
+        free(c);
+        pthread_mutex_lock(&fr.lock);
+        fr.active--;
+        pthread_mutex_unlock(&fr.lock);
+      }
+    }
+  }
+  pthread_attr_destroy(&attr);
+
+  log_info("****** Closing the franchise ******");
+  close(listenfd);
+
+  // Customers being forwarded are served to the end
+  pthread_mutex_lock(&fr.lock);
+  if (fr.active > 0) log_info("Forwarding %u remaining customer(s)", fr.active);
+  while (fr.active > 0) pthread_cond_wait(&fr.idle, &fr.lock);
+  pthread_mutex_unlock(&fr.lock);
+
+  monitoring = false;
+  pthread_join(monitor, NULL);
+
+  log_close();
+  print_statistics();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,393 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  idem.c
+/// @brief Idempotency keys: in-flight and completed requests by key, for retries
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab a retry in flight waits on the seat of the request owning its key
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "idem.h"
+#include "burger.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief a key of a request in flight or completed
+typedef struct __idem_entry {
+  struct __idem_entry *chain;                               ///< next entry of the hash bucket
+  struct __idem_entry *older;                               ///< previous completed entry
+  struct __idem_entry *newer;                               ///< next completed entry
+  uint64_t hash;                                            ///< hash of key
+  uint64_t expires_ms;                                      ///< end of the TTL (0: in flight)
+  char *result;                                             ///< burgers made (NULL: in flight)
+  size_t len;                                               ///< length of result
+  unsigned int count;                                       ///< number of burgers
+  struct __idem_waiter *seatless;                           ///< retry waiting on the owner's seat
+  char key[TOKEN_MAX + 1];                                  ///< idempotency key
+} IdemEntry;
+
+/// @brief a retry waiting for a key of its stripe
+typedef struct __idem_waiter {
+  struct __idem_waiter *next;                               ///< next waiter of the stripe
+  int fd;                                                   ///< eventfd waking up the waiter
+} IdemWaiter;
+
+/// @brief a stripe of the table: keys whose hash falls into it, under a lock of their own.
+///        Completed entries are also listed oldest first; with a single TTL, that is the order in
+///        which they expire.
+typedef struct __idem_stripe {
+  pthread_mutex_t lock;                                     ///< lock variable for the stripe
+  pthread_cond_t done;                                      ///< a key completed or was abandoned
+  IdemWaiter *waiters;                                      ///< retries polling their socket
+  IdemEntry *bucket[IDEM_BUCKETS];                          ///< hash chains
+  IdemEntry *oldest;                                        ///< oldest completed entry
+  IdemEntry *newest;                                        ///< newest completed entry
+  unsigned int keys;                                        ///< entries in the stripe
+  unsigned int inflight;                                    ///< entries in flight
+  size_t bytes;                                             ///< bytes of the results
+  uint64_t hits;                                            ///< retries of a completed request
+  uint64_t reattached;                                      ///< retries of a request in flight
+  uint64_t abandoned;                                       ///< requests that failed with a key
+  uint64_t evicted;                                         ///< results dropped before their TTL
+} IdemStripe;
+
+/// @}
+
+/// @name Global variables
+/// @{
+
+static IdemStripe stripes[IDEM_STRIPES];                    ///< the table
+static unsigned int stripe_keys;                            ///< max. keys of a stripe (0: off)
+static size_t stripe_bytes;                                 ///< max. bytes of results of a stripe
+static unsigned int ttl;                                    ///< time a result is kept (ms)
+
+/// @}
+
+/// @brief milliseconds of the monotonic clock
+/// @retval milliseconds
+static uint64_t now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// @brief hash of a key (FNV-1a)
+/// @param key key
+/// @retval hash
+static uint64_t hash_key(const char *key)
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  while (*key) h = (h ^ (unsigned char)*key++) * 0x100000001b3ULL;
+  return h;
+}
+
+/// @brief stripe of a hash
+static inline IdemStripe* stripe_of(uint64_t h)
+{
+  return &stripes[h % IDEM_STRIPES];
+}
+
+/// @brief hash chain of a hash within its stripe
+static inline IdemEntry** bucket_of(IdemStripe *stripe, uint64_t h)
+{
+  return &stripe->bucket[(h / IDEM_STRIPES) % IDEM_BUCKETS];
+}
+
+/// @brief find the entry of a key. The stripe lock must be held.
+/// @param stripe stripe of the key
+/// @param key key
+/// @param h hash of the key
+/// @retval IdemEntry* entry
+/// @retval NULL if the key is unknown
+static IdemEntry* find(IdemStripe *stripe, const char *key, uint64_t h)
+{
+  IdemEntry *e;
+
+  for (e = *bucket_of(stripe, h); e; e = e->chain) {
+    if ((e->hash == h) && (strcmp(e->key, key) == 0)) return e;
+  }
+  return NULL;
+}
+
+/// @brief remove an entry from its stripe and free it. The stripe lock must be held.
+/// @param stripe stripe of the entry
+/// @param e entry
+static void drop(IdemStripe *stripe, IdemEntry *e)
+{
+  IdemEntry **p;
+
+  for (p = bucket_of(stripe, e->hash); *p != e; p = &(*p)->chain);
+  *p = e->chain;
+
+  if (e->result) {
+    if (e->older) e->older->newer = e->newer;
+    else stripe->oldest = e->newer;
+    if (e->newer) e->newer->older = e->older;
+    else stripe->newest = e->older;
+    stripe->bytes -= e->len;
+    free(e->result);
+  } else {
+    stripe->inflight--;
+  }
+  stripe->keys--;
+  free(e);
+}
+
+/// @brief wake up all retries waiting in a stripe; each one looks its key up again. The stripe
+///        lock must be held.
+/// @param stripe stripe
+static void wake(IdemStripe *stripe)
+{
+  uint64_t one = 1;
+  IdemWaiter *w;
+
+  pthread_cond_broadcast(&stripe->done);
+  for (w = stripe->waiters; w; w = w->next) {
+    if (write(w->fd, &one, sizeof(one)) < 0) {}
+  }
+}
+
+/// @brief drop completed entries past their TTL, then the oldest ones while the stripe holds
+///        more than @a keys entries or more than @a bytes bytes of results. The stripe lock must
+///        be held.
+/// @param stripe stripe
+/// @param keys max. entries to keep
+/// @param bytes max. bytes of results to keep
+static void evict(IdemStripe *stripe, unsigned int keys, size_t bytes)
+{
+  uint64_t now = now_ms();
+
+  while (stripe->oldest && (stripe->oldest->expires_ms <= now)) drop(stripe, stripe->oldest);
+  while (stripe->oldest && ((stripe->keys > keys) || (stripe->bytes > bytes))) {
+    drop(stripe, stripe->oldest);
+    stripe->evicted++;
+  }
+}
+
+void idem_setup(unsigned int keys, unsigned int ttl_ms)
+{
+  int i;
+
+  for (i = 0; i < IDEM_STRIPES; i++) {
+    pthread_mutex_init(&stripes[i].lock, NULL);
+    pthread_cond_init(&stripes[i].done, NULL);
+  }
+  stripe_keys = (keys + IDEM_STRIPES - 1) / IDEM_STRIPES;
+  stripe_bytes = IDEM_BYTES / IDEM_STRIPES;
+  ttl = ttl_ms;
+}
+
+enum idem_claim idem_claim(const char *key)
+{
+  uint64_t h = hash_key(key);
+  IdemStripe *stripe = stripe_of(h);
+  IdemEntry *e, **b;
+
+  if (stripe_keys == 0) return IDEM_NONE;
+
+  pthread_mutex_lock(&stripe->lock);
+  evict(stripe, stripe_keys, stripe_bytes);
+  if ((e = find(stripe, key, h)) != NULL) {
+    if (e->result) stripe->hits++;
+    else stripe->reattached++;
+    pthread_mutex_unlock(&stripe->lock);
+    return IDEM_RETRY;
+  }
+
+  // Make room for the new key; requests in flight are never dropped
+  evict(stripe, stripe_keys - 1, stripe_bytes);
+  if ((stripe->keys >= stripe_keys) || ((e = calloc(1, sizeof(*e))) == NULL)) {
+    pthread_mutex_unlock(&stripe->lock);
+    return IDEM_NONE;
+  }
+  e->hash = h;
+  strncpy(e->key, key, TOKEN_MAX);
+  b = bucket_of(stripe, h);
+  e->chain = *b;
+  *b = e;
+  stripe->keys++;
+  stripe->inflight++;
+  pthread_mutex_unlock(&stripe->lock);
+
+  return IDEM_OWNER;
+}
+
+void idem_complete(const char *key, const char *result, unsigned int count)
+{
+  uint64_t h = hash_key(key);
+  IdemStripe *stripe = stripe_of(h);
+  size_t len = strlen(result);
+  char *copy = (len < stripe_bytes) ? strdup(result) : NULL;
+  IdemEntry *e;
+
+  pthread_mutex_lock(&stripe->lock);
+  if ((e = find(stripe, key, h)) && !e->result) {
+    if (copy == NULL) {
+      // Too large to keep; a retry makes the order again
+      drop(stripe, e);
+      stripe->abandoned++;
+    } else {
+      stripe->inflight--;
+      stripe->bytes += len;
+      e->result = copy;
+      e->len = len;
+      e->count = count;
+      e->expires_ms = now_ms() + ttl;
+      e->older = stripe->newest;
+      if (stripe->newest) stripe->newest->newer = e;
+      else stripe->oldest = e;
+      stripe->newest = e;
+      copy = NULL;
+      evict(stripe, stripe_keys, stripe_bytes);
+    }
+    wake(stripe);
+  }
+  pthread_mutex_unlock(&stripe->lock);
+  free(copy);
+}
+
+void idem_abandon(const char *key)
+{
+  uint64_t h = hash_key(key);
+  IdemStripe *stripe = stripe_of(h);
+  IdemEntry *e;
+
+  pthread_mutex_lock(&stripe->lock);
+  if ((e = find(stripe, key, h)) && !e->result) {
+    drop(stripe, e);
+    stripe->abandoned++;
+    wake(stripe);
+  }
+  pthread_mutex_unlock(&stripe->lock);
+}
+
+int idem_wait(const char *key, int fd, void (*unseat)(void), bool *unseated, char **result,
+              unsigned int *count)
+{
+  uint64_t h = hash_key(key), value;
+  IdemStripe *stripe = stripe_of(h);
+  IdemWaiter w, **p;
+  IdemEntry *e;
+  struct pollfd pfd[2];
+  int n, ret = 0;
+
+  *unseated = false;
+
+  // Without an eventfd, fall back to the condition; the customer is then not watched
+  w.fd = eventfd(0, EFD_CLOEXEC);
+
+  // Entries may go away while we sleep, so look the key up again after every wakeup
+  pthread_mutex_lock(&stripe->lock);
+  if (w.fd >= 0) {
+    w.next = stripe->waiters;
+    stripe->waiters = &w;
+  }
+  while ((e = find(stripe, key, h)) != NULL) {
+    if (e->result) {
+      if ((*result = strdup(e->result)) != NULL) ret = 1;
+      *count = e->count;
+      break;
+    }
+    if (w.fd < 0) {
+      pthread_cond_wait(&stripe->done, &stripe->lock);
+      continue;
+    }
+
+    // The first retry of a key in flight waits on the seat of the owner and gives up its own
+    if (!*unseated && !e->seatless) {
+      e->seatless = &w;
+      *unseated = true;
+      pthread_mutex_unlock(&stripe->lock);
+      unseat();
+      pthread_mutex_lock(&stripe->lock);
+      continue;
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+    pfd[0].fd = fd;
+    pfd[0].events = POLLRDHUP;
+    pfd[1].fd = w.fd;
+    pfd[1].events = POLLIN;
+    n = poll(pfd, 2, -1);
+    if ((n > 0) && (pfd[1].revents & POLLIN) && (read(w.fd, &value, sizeof(value)) < 0)) {}
+    pthread_mutex_lock(&stripe->lock);
+
+    // The protocol never half-closes; the customer is gone
+    if ((n > 0) && (pfd[0].revents & (POLLRDHUP | POLLHUP | POLLERR))) {
+      ret = -1;
+      break;
+    }
+  }
+  if (w.fd >= 0) {
+    for (p = &stripe->waiters; *p != &w; p = &(*p)->next);
+    *p = w.next;
+  }
+  if (e && (e->seatless == &w)) e->seatless = NULL;
+  pthread_mutex_unlock(&stripe->lock);
+  if (w.fd >= 0) close(w.fd);
+
+  return ret;
+}
+
+void idem_stats(IdemStats *st)
+{
+  IdemStripe *stripe;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  for (i = 0; i < IDEM_STRIPES; i++) {
+    stripe = &stripes[i];
+    pthread_mutex_lock(&stripe->lock);
+    evict(stripe, UINT_MAX, SIZE_MAX);
+    st->keys += stripe->keys;
+    st->inflight += stripe->inflight;
+    st->bytes += stripe->bytes;
+    st->hits += stripe->hits;
+    st->reattached += stripe->reattached;
+    st->abandoned += stripe->abandoned;
+    st->evicted += stripe->evicted;
+    pthread_mutex_unlock(&stripe->lock);
+  }
+}
@@ -0,0 +1,122 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  idem.h
+/// @brief Idempotency keys: in-flight and completed requests by key, for retries
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab a retry in flight waits on the seat of the request owning its key
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __IDEM_H__
+#define __IDEM_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/// @name Macro definitions
+/// @{
+
+#define IDEM_KEYS 65536                                   ///< default max. keys in the table
+#define IDEM_TTL_MS 60000                                 ///< default time a result is kept
+#define IDEM_BYTES (64 << 20)                             ///< max. bytes of the results kept
+#define IDEM_STRIPES 64                                   ///< stripes of the table, one lock each
+#define IDEM_BUCKETS 256                                  ///< hash buckets of a stripe
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief result of idem_claim()
+enum idem_claim {
+  IDEM_NONE,                                                ///< no room or no table: not tracked
+  IDEM_OWNER,                                               ///< new key; the caller makes the order
+  IDEM_RETRY                                                ///< key in flight or done; collect it
+};
+
+/// @brief statistics of the table
+typedef struct __idem_stats {
+  uint64_t keys;                                            ///< keys in the table
+  uint64_t inflight;                                        ///< keys of requests being made
+  uint64_t bytes;                                           ///< bytes of the results kept
+  uint64_t hits;                                            ///< retries of a completed request
+  uint64_t reattached;                                      ///< retries of a request in flight
+  uint64_t abandoned;                                       ///< requests that failed with a key
+  uint64_t evicted;                                         ///< results dropped before their TTL
+} IdemStats;
+
+/// @}
+
+/// @brief size the table. Must be called before the first claim.
+/// @param keys max. keys in the table, rounded up to a multiple of IDEM_STRIPES (0: no table;
+///             keys are ignored)
+/// @param ttl_ms time a completed result is kept
+void idem_setup(unsigned int keys, unsigned int ttl_ms);
+
+/// @brief claim a key for a request. An unknown key becomes in flight, owned by the caller, who
+///        must end it with idem_complete() or idem_abandon(). Completed results past their TTL
+///        are evicted first, and the oldest results make room for a new key in a full stripe.
+/// @param key idempotency key
+/// @retval enum idem_claim
+enum idem_claim idem_claim(const char *key);
+
+/// @brief store the result of an owned key and wake up the retries waiting for it. A result
+///        too large for the byte budget of its stripe is not kept: the key is abandoned.
+/// @param key idempotency key
+/// @param result burgers made, separated by spaces
+/// @param count number of burgers
+void idem_complete(const char *key, const char *result, unsigned int count);
+
+/// @brief drop an owned key whose request failed and wake up the retries waiting for it
+/// @param key idempotency key
+void idem_abandon(const char *key);
+
+/// @brief wait until the request of a key completes and get its result. While waiting, the
+///        socket of the customer is watched, so that a retry that hangs up gives up its serving
+///        thread right away. An expired visit deadline shuts the socket down and ends the wait,
+///        too. The first retry that waits for a key in flight gives up its seat through @a unseat;
+///        it waits on the seat of the owner of the key, so that a request and its retry hold one
+///        seat between them.
+/// @param key idempotency key
+/// @param fd socket of the customer
+/// @param unseat gives up the seat of the caller
+/// @param unseated the caller gave up its seat. Out parameter.
+/// @param result burgers made, a copy to be freed by the caller. Out parameter.
+/// @param count number of burgers. Out parameter.
+/// @retval 1 on success
+/// @retval 0 if the request failed or its result was evicted
+/// @retval -1 if the customer left
+int idem_wait(const char *key, int fd, void (*unseat)(void), bool *unseated, char **result,
+              unsigned int *count);
+
+/// @brief get the statistics of the table
+/// @param st statistics. Out parameter.
+void idem_stats(IdemStats *st);
+
+#endif // __IDEM_H__
@@ -0,0 +1,681 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  journal.c
+/// @brief Group-committed, memory-mapped journal of requests and burgers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab burger types of the menu
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+/// 2026/10/19 ARC lab delete segments older than the oldest pending request
+/// 2026/10/19 ARC lab leave checking replayed burger types against the menu to the caller
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief a segment file found in the journal directory
+typedef struct __segment {
+  unsigned int run;                                         ///< run that wrote the segment
+  uint64_t seq;                                             ///< sequence number within the run
+} Segment;
+
+/// @brief a full segment whose tail still has to be synced before it is unmapped
+typedef struct __retired {
+  char *map;                                                ///< mapping of the segment
+  int fd;                                                   ///< segment file
+  size_t from;                                              ///< synced up to here
+  size_t to;                                                ///< written up to here
+} Retired;
+
+#define JOURNAL_RETIRED_MAX 16                            ///< max. segments waiting for sync
+
+/// @brief a pending request and the segment that holds its REQUEST record. Slot of an open
+///        addressing table keyed by customer ID.
+typedef struct __open_request {
+  uint64_t seq;                                             ///< segment (0: free slot)
+  unsigned int id;                                          ///< customer ID
+} OpenRequest;
+
+/// @brief state of the journal
+struct journal {
+  bool enabled;                                             ///< journal is open
+  char dir[PATH_MAX];                                       ///< directory of the segments
+  int dirfd;                                                ///< directory (for fsync)
+  int lockfd;                                               ///< lock file of the run
+  unsigned int run;                                         ///< run of this server
+  uint64_t oldest;                                          ///< oldest segment on disk
+  uint64_t seq;                                             ///< current segment
+  int fd;                                                   ///< current segment file
+  char *map;                                                ///< mapping of the current segment
+  size_t off;                                               ///< written bytes of current segment
+  size_t synced_off;                                        ///< synced bytes of current segment
+  Retired retired[JOURNAL_RETIRED_MAX];                     ///< full segments to sync
+  unsigned int nretired;                                    ///< number of retired segments
+  bool dir_dirty;                                           ///< segments created or deleted
+  uint64_t written;                                         ///< records appended
+  uint64_t synced;                                          ///< records durable
+  unsigned int pending;                                     ///< requests not done
+  OpenRequest *open;                                        ///< pending requests by customer ID
+  size_t open_cap;                                          ///< slots of open (power of 2)
+  bool untracked;                                           ///< a pending request is not in open
+  JournalStats stats;                                       ///< metrics
+  struct timespec start;                                    ///< time the journal was opened
+  pthread_mutex_t lock;                                     ///< lock variable for the journal
+  pthread_cond_t work;                                      ///< wakes up the committer
+  pthread_cond_t done;                                      ///< signals a group commit
+  pthread_t thread;                                         ///< committer thread
+  bool closing;                                             ///< committer thread stops
+};
+
+/// @}
+
+static struct journal jr = {
+  .fd = -1,
+  .dirfd = -1,
+  .lockfd = -1,
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .work = PTHREAD_COND_INITIALIZER,
+  .done = PTHREAD_COND_INITIALIZER,
+};
+
+/// @brief checksum of a record (splitmix64 of its contents); never 0
+static uint32_t checksum(const JournalRecord *r)
+{
+  uint64_t x = r->request ^ ((uint64_t)r->count << 48) ^ ((uint64_t)r->type << 40) ^
+               ((uint64_t)r->kind << 32);
+
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+
+  return (uint32_t)x | 1;
+}
+
+/// @brief nanoseconds since @a start
+static uint64_t elapsed_ns(const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000000000ULL + now.tv_nsec - start->tv_nsec;
+}
+
+/// @brief path of segment @a seq of run @a run; seq 0 is the lock file of the run
+static void segment_path(char *path, size_t len, unsigned int run, uint64_t seq)
+{
+  if (seq == 0) snprintf(path, len, "%s/%s%u.lock", jr.dir, JOURNAL_PREFIX, run);
+  else snprintf(path, len, "%s/%s%u.%lu", jr.dir, JOURNAL_PREFIX, run, (unsigned long)seq);
+}
+
+/// @brief create and map segment @a seq as the current segment
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code
+static int new_segment(uint64_t seq)
+{
+  char path[PATH_MAX + 32];
+  char *map;
+  int fd;
+
+  segment_path(path, sizeof(path), jr.run, seq);
+  fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return -1;
+
+  if ((posix_fallocate(fd, 0, JOURNAL_SEGMENT_SIZE) != 0) &&
+      (ftruncate(fd, JOURNAL_SEGMENT_SIZE) < 0)) {
+    close(fd);
+    unlink(path);
+    return -1;
+  }
+
+  map = (char *)mmap(NULL, JOURNAL_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    close(fd);
+    unlink(path);
+    return -1;
+  }
+
+  jr.seq = seq;
+  jr.fd = fd;
+  jr.map = map;
+  jr.off = 0;
+  jr.synced_off = 0;
+  jr.dir_dirty = true;
+  jr.stats.segments++;
+
+  return 0;
+}
+
+/// @brief home slot of customer @a id in the table of pending requests
+static inline size_t open_slot(unsigned int id)
+{
+  return (id * 2654435761u) & (jr.open_cap - 1);
+}
+
+/// @brief remember that the REQUEST record of customer @a id is in segment @a seq. The table is
+///        kept at most half full. Called with the lock held.
+/// @retval 0 on success
+/// @retval -1 if out of memory
+static int open_insert(unsigned int id, uint64_t seq)
+{
+  OpenRequest *old = jr.open;
+  size_t cap = jr.open_cap, i, j;
+
+  if (2 * (jr.pending + 1) > jr.open_cap) {
+    jr.open_cap = cap ? 2 * cap : 64;
+    jr.open = (OpenRequest *)calloc(jr.open_cap, sizeof(OpenRequest));
+    if (jr.open == NULL) {
+      jr.open = old;
+      jr.open_cap = cap;
+      return -1;
+    }
+    for (i = 0; i < cap; i++) {
+      if (old[i].seq == 0) continue;
+      for (j = open_slot(old[i].id); jr.open[j].seq; j = (j + 1) & (jr.open_cap - 1));
+      jr.open[j] = old[i];
+    }
+    free(old);
+  }
+
+  for (i = open_slot(id); jr.open[i].seq; i = (i + 1) & (jr.open_cap - 1));
+  jr.open[i] = (OpenRequest){ seq, id };
+  return 0;
+}
+
+/// @brief forget the pending request of customer @a id. Entries after it in its cluster move
+///        back, so that lookups need no tombstones. Called with the lock held.
+/// @retval true if the request was pending
+static bool open_remove(unsigned int id)
+{
+  size_t mask = jr.open_cap - 1, i, j, k;
+
+  if (jr.open_cap == 0) return false;
+  for (i = open_slot(id); jr.open[i].seq && (jr.open[i].id != id); i = (i + 1) & mask);
+  if (jr.open[i].seq == 0) return false;
+
+  for (j = (i + 1) & mask; jr.open[j].seq; j = (j + 1) & mask) {
+    // The entry at j may stay if its home slot k lies cyclically in (i, j]
+    k = open_slot(jr.open[j].id);
+    if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) continue;
+    jr.open[i] = jr.open[j];
+    i = j;
+  }
+  jr.open[i].seq = 0;
+  return true;
+}
+
+/// @brief oldest segment still needed: the one holding the oldest REQUEST record of a pending
+///        request, or the current one. Called with the lock held.
+static uint64_t oldest_needed(void)
+{
+  uint64_t seq = jr.seq;
+  size_t i;
+
+  if (jr.untracked) return jr.oldest;
+  for (i = 0; i < jr.open_cap; i++) {
+    if (jr.open[i].seq && (jr.open[i].seq < seq)) seq = jr.open[i].seq;
+  }
+  return seq;
+}
+
+/// @brief delete the segments of this run older than segment @a keep (from jr.oldest on; 0 is
+///        the lock file). Called with the lock held.
+static void delete_old_segments(uint64_t keep)
+{
+  char path[PATH_MAX + 32];
+
+  for (; jr.oldest < keep; jr.oldest++) {
+    segment_path(path, sizeof(path), jr.run, jr.oldest);
+    unlink(path);
+    jr.dir_dirty = true;
+  }
+}
+
+/// @brief flush [@a from, @a to) of a mapped segment to disk
+static void sync_range(char *map, size_t from, size_t to)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = from & ~(page - 1);
+
+  if (to > from) msync(map + start, to - start, MS_SYNC);
+}
+
+/// @brief committer thread: syncs everything appended since the last commit with one fsync.
+///        Records appended while a commit runs form the next group.
+static void* journal_task(void *dummy)
+{
+  Retired retired[JOURNAL_RETIRED_MAX];
+  unsigned int nretired, i;
+  uint64_t target, seq, ns;
+  size_t from, to;
+  char *map;
+  bool dir_dirty;
+  struct timespec t0;
+
+  pthread_mutex_lock(&jr.lock);
+  while (1) {
+    while (!jr.closing && (jr.synced == jr.written) && (jr.nretired == 0)) {
+      pthread_cond_wait(&jr.work, &jr.lock);
+    }
+    if (jr.closing && (jr.synced == jr.written) && (jr.nretired == 0)) break;
+
+    // Take the group
+    target = jr.written;
+    nretired = jr.nretired;
+    memcpy(retired, jr.retired, nretired * sizeof(Retired));
+    jr.nretired = 0;
+    seq = jr.seq;
+    map = jr.map;
+    from = jr.synced_off;
+    to = jr.off;
+    dir_dirty = jr.dir_dirty;
+    jr.dir_dirty = false;
+    pthread_mutex_unlock(&jr.lock);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i = 0; i < nretired; i++) {
+      sync_range(retired[i].map, retired[i].from, retired[i].to);
+      munmap(retired[i].map, JOURNAL_SEGMENT_SIZE);
+      close(retired[i].fd);
+    }
+    sync_range(map, from, to);
+    if (dir_dirty) fsync(jr.dirfd);
+    ns = elapsed_ns(&t0);
+
+    pthread_mutex_lock(&jr.lock);
+    if (jr.seq == seq) jr.synced_off = to;
+    jr.synced = target;
+    jr.stats.commits++;
+    jr.stats.sync_ns += ns;
+    if (ns > jr.stats.sync_max_ns) jr.stats.sync_max_ns = ns;
+    pthread_cond_broadcast(&jr.done);
+  }
+  pthread_mutex_unlock(&jr.lock);
+
+  return NULL;
+}
+
+/// @brief state of a request during the replay
+typedef struct __replayed {
+  uint64_t request;                                         ///< (run << 32) | customer ID
+  unsigned int ordered[MENU_MAX];                    ///< burgers ordered
+  unsigned int made[MENU_MAX];                       ///< burgers made
+  bool done;                                                ///< request is over
+} Replayed;
+
+/// @brief order records by request
+static int compare_records(const void *a, const void *b)
+{
+  uint64_t x = ((const JournalRecord *)a)->request, y = ((const JournalRecord *)b)->request;
+  return (x > y) - (x < y);
+}
+
+/// @brief order segments by run and sequence number
+static int compare_segments(const void *a, const void *b)
+{
+  const Segment *x = (const Segment *)a, *y = (const Segment *)b;
+
+  if (x->run != y->run) return (x->run > y->run) - (x->run < y->run);
+  return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+/// @brief read the valid records of segment @a seq and append them to @a recs
+static void read_segment(Segment *seg, JournalRecord **recs, size_t *n, size_t *cap)
+{
+  char path[PATH_MAX + 32];
+  JournalRecord *r;
+  struct stat st;
+  char *map;
+  size_t i, count;
+  int fd;
+
+  segment_path(path, sizeof(path), seg->run, seg->seq);
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  if ((fstat(fd, &st) < 0) || (st.st_size < (off_t)sizeof(JournalRecord))) {
+    close(fd);
+    return;
+  }
+
+  map = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return;
+
+  // A segment ends at the first unwritten or torn record
+  count = st.st_size / sizeof(JournalRecord);
+  r = (JournalRecord *)map;
+  for (i = 0; (i < count) && (r[i].check != 0) && (r[i].check == checksum(&r[i])); i++) {
+    if (*n == *cap) {
+      *cap = *cap ? *cap * 2 : 4096;
+      *recs = (JournalRecord *)realloc(*recs, *cap * sizeof(JournalRecord));
+    }
+    (*recs)[(*n)++] = r[i];
+  }
+
+  munmap(map, st.st_size);
+}
+
+/// @brief find the segments and lock files (seq 0) in the journal directory
+/// @param segs segments sorted by run and sequence number. Out parameter; free it.
+/// @param last highest run found (0 if none). Out parameter.
+/// @retval number of segments
+static size_t list_segments(Segment **segs, unsigned int *last)
+{
+  size_t n = 0, cap = 0, plen = strlen(JOURNAL_PREFIX);
+  struct dirent *de;
+  unsigned long run;
+  uint64_t seq;
+  char *end;
+  DIR *d;
+
+  *segs = NULL;
+  *last = 0;
+  d = opendir(jr.dir);
+  if (d == NULL) return 0;
+  while ((de = readdir(d)) != NULL) {
+    if (strncmp(de->d_name, JOURNAL_PREFIX, plen) != 0) continue;
+    run = strtoul(de->d_name + plen, &end, 10);
+    if ((*end != '.') || (run == 0) || (run > UINT32_MAX)) continue;
+    if (strcmp(end, ".lock") == 0) {
+      seq = 0;
+    } else {
+      seq = strtoull(end + 1, &end, 10);
+      if ((*end != '\0') || (seq == 0)) continue;
+    }
+    if (n == cap) {
+      cap = cap ? cap * 2 : 16;
+      *segs = (Segment *)realloc(*segs, cap * sizeof(Segment));
+    }
+    (*segs)[n++] = (Segment){ (unsigned int)run, seq };
+    if (run > *last) *last = run;
+  }
+  closedir(d);
+
+  if (n > 0) qsort(*segs, n, sizeof(Segment), compare_segments);
+  return n;
+}
+
+/// @brief drop the segments of runs whose server is still alive (it holds the lock file of the
+///        run). A takeover leaves the journal of the old server alone while it drains.
+/// @retval number of remaining segments
+static size_t dead_segments(Segment *segs, size_t n)
+{
+  char path[PATH_MAX + 32];
+  size_t i, j, k = 0;
+  bool alive;
+  int fd;
+
+  for (i = 0; i < n; i = j) {
+    segment_path(path, sizeof(path), segs[i].run, 0);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    alive = (fd >= 0) && (flock(fd, LOCK_EX | LOCK_NB) < 0);
+    if (fd >= 0) close(fd);
+
+    for (j = i; (j < n) && (segs[j].run == segs[i].run); j++) {
+      if (!alive) segs[k++] = segs[j];
+    }
+  }
+
+  return k;
+}
+
+/// @brief replay the segments @a segs and report pending requests to @a fn
+static void replay(Segment *segs, size_t nsegs, journal_replay_fn fn, void *data)
+{
+  JournalRecord *recs = NULL;
+  size_t n = 0, cap = 0, i, j, t;
+  unsigned int pending[MENU_MAX];
+  Replayed req;
+  bool any;
+
+  for (i = 0; i < nsegs; i++) {
+    if (segs[i].seq > 0) read_segment(&segs[i], &recs, &n, &cap);
+  }
+
+  // Sum up the records of every request
+  qsort(recs, n, sizeof(JournalRecord), compare_records);
+  for (i = 0; i < n; i = j) {
+    memset(&req, 0, sizeof(req));
+    req.request = recs[i].request;
+    // A type of one byte always fits the MENU_MAX counters; the replay function checks it
+    // against the menu
+    for (j = i; (j < n) && (recs[j].request == req.request); j++) {
+      if (recs[j].kind == JOURNAL_ORDER) req.ordered[recs[j].type] += recs[j].count;
+      else if (recs[j].kind == JOURNAL_BURGER) req.made[recs[j].type]++;
+      else if (recs[j].kind == JOURNAL_DONE) req.done = true;
+    }
+    if (req.done) continue;
+
+    any = false;
+    for (t = 0; t < MENU_MAX; t++) {
+      pending[t] = (req.ordered[t] > req.made[t]) ? req.ordered[t] - req.made[t] : 0;
+      if (pending[t] > 0) any = true;
+    }
+    if (!any) continue;
+
+    jr.stats.recovered++;
+    if (fn) fn((unsigned int)(req.request >> 32), (unsigned int)req.request, pending, data);
+  }
+
+  free(recs);
+}
+
+int journal_open(const char *dir, journal_replay_fn fn, void *data)
+{
+  char path[PATH_MAX + 32];
+  Segment *segs;
+  unsigned int last;
+  size_t nsegs, i;
+
+  if (jr.enabled) return 0;
+  if (strlen(dir) >= sizeof(jr.dir)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  strcpy(jr.dir, dir);
+  jr.dirfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (jr.dirfd < 0) return -1;
+
+  // Our run follows the last one in the directory; its lock file tells other servers we are alive
+  nsegs = list_segments(&segs, &last);
+  jr.run = last + 1;
+  segment_path(path, sizeof(path), jr.run, 0);
+  jr.lockfd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if ((jr.lockfd < 0) || (flock(jr.lockfd, LOCK_EX) < 0) || (new_segment(1) < 0)) goto fail;
+  jr.oldest = 1;
+  clock_gettime(CLOCK_MONOTONIC, &jr.start);
+  jr.enabled = true;
+
+  // Restore the pending requests of dead runs into the new segment, make them durable, and drop
+  // the old segments
+  nsegs = dead_segments(segs, nsegs);
+  replay(segs, nsegs, fn, data);
+  sync_range(jr.map, 0, jr.off);
+  jr.synced_off = jr.off;
+  jr.synced = jr.written;
+  for (i = 0; i < nsegs; i++) {
+    segment_path(path, sizeof(path), segs[i].run, segs[i].seq);
+    unlink(path);
+  }
+  free(segs);
+  fsync(jr.dirfd);
+  jr.dir_dirty = false;
+
+  jr.closing = false;
+  if (pthread_create(&jr.thread, NULL, journal_task, NULL) != 0) {
+    jr.enabled = false;
+    munmap(jr.map, JOURNAL_SEGMENT_SIZE);
+    close(jr.fd);
+    jr.fd = -1;
+    goto fail;
+  }
+
+  return 0;
+
+fail:
+  free(segs);
+  if (jr.lockfd >= 0) {
+    segment_path(path, sizeof(path), jr.run, 0);
+    unlink(path);
+    close(jr.lockfd);
+  }
+  close(jr.dirfd);
+  jr.lockfd = jr.dirfd = -1;
+  return -1;
+}
+
+void journal_close(void)
+{
+  if (!jr.enabled) return;
+
+  pthread_mutex_lock(&jr.lock);
+  jr.closing = true;
+  pthread_cond_signal(&jr.work);
+  pthread_mutex_unlock(&jr.lock);
+  pthread_join(jr.thread, NULL);
+
+  // Nothing to recover after a clean shutdown
+  pthread_mutex_lock(&jr.lock);
+  jr.stats.seconds = elapsed_ns(&jr.start) / 1e9;
+  jr.enabled = false;
+  pthread_cond_broadcast(&jr.done);
+  if (jr.pending == 0) {
+    jr.oldest = 0;
+    delete_old_segments(jr.seq + 1);
+    fsync(jr.dirfd);
+  } else if (oldest_needed() > jr.oldest) {
+    delete_old_segments(oldest_needed());
+    fsync(jr.dirfd);
+  }
+  free(jr.open);
+  jr.open = NULL;
+  jr.open_cap = 0;
+  jr.pending = 0;
+  jr.untracked = false;
+  pthread_mutex_unlock(&jr.lock);
+
+  munmap(jr.map, JOURNAL_SEGMENT_SIZE);
+  close(jr.fd);
+  close(jr.lockfd);
+  close(jr.dirfd);
+  jr.fd = jr.lockfd = jr.dirfd = -1;
+}
+
+bool journal_enabled(void)
+{
+  return jr.enabled;
+}
+
+uint64_t journal_append(enum journal_kind kind, unsigned int customerID, enum burger_type type,
+                        unsigned int count)
+{
+  JournalRecord rec;
+  uint64_t lsn;
+
+  if (!jr.enabled) return 0;
+
+  rec.request = ((uint64_t)jr.run << 32) | customerID;
+  rec.count = (count > UINT16_MAX) ? UINT16_MAX : count;
+  rec.type = type;
+  rec.kind = kind;
+  rec.check = checksum(&rec);
+
+  pthread_mutex_lock(&jr.lock);
+  if (!jr.enabled) {
+    pthread_mutex_unlock(&jr.lock);
+    return 0;
+  }
+
+  // Segment full: hand it to the committer and continue in a new one. Older segments are only
+  // needed as long as they hold the start of a pending request; its later records follow in
+  // newer segments.
+  if (jr.off + sizeof(rec) > JOURNAL_SEGMENT_SIZE) {
+    while (jr.nretired == JOURNAL_RETIRED_MAX) pthread_cond_wait(&jr.done, &jr.lock);
+    jr.retired[jr.nretired++] = (Retired){ jr.map, jr.fd, jr.synced_off, jr.off };
+    if (new_segment(jr.seq + 1) < 0) {
+      // Keep the old segment; the record is lost
+      jr.nretired--;
+      pthread_mutex_unlock(&jr.lock);
+      return jr.synced;
+    }
+    delete_old_segments(oldest_needed());
+  }
+
+  memcpy(jr.map + jr.off, &rec, sizeof(rec));
+  jr.off += sizeof(rec);
+  if (kind == JOURNAL_REQUEST) {
+    // Without a slot, the request pins all segments until the journal is closed
+    if (open_insert(customerID, jr.seq) < 0) jr.untracked = true;
+    jr.pending++;
+  } else if ((kind == JOURNAL_DONE) && open_remove(customerID)) {
+    jr.pending--;
+  }
+  lsn = ++jr.written;
+  jr.stats.records++;
+  if (lsn == jr.synced + 1) pthread_cond_signal(&jr.work);
+
+  pthread_mutex_unlock(&jr.lock);
+
+  return lsn;
+}
+
+void journal_sync(uint64_t lsn)
+{
+  if (!jr.enabled) return;
+
+  pthread_mutex_lock(&jr.lock);
+  while (jr.enabled && (jr.synced < lsn)) pthread_cond_wait(&jr.done, &jr.lock);
+  pthread_mutex_unlock(&jr.lock);
+}
+
+void journal_stats(JournalStats *s)
+{
+  pthread_mutex_lock(&jr.lock);
+  *s = jr.stats;
+  if (jr.enabled) s->seconds = elapsed_ns(&jr.start) / 1e9;
+  pthread_mutex_unlock(&jr.lock);
+}
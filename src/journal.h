@@ -0,0 +1,134 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  journal.h
+/// @brief Group-committed, memory-mapped journal of requests and burgers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab burger types of the menu
+/// 2026/10/19 ARC lab delete segments older than the oldest pending request
+/// 2026/10/19 ARC lab leave checking replayed burger types against the menu to the caller
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "burger.h"
+
+/// @name Macro definitions
+/// @{
+
+#define JOURNAL_SEGMENT_SIZE (4 << 20)                    ///< size of a segment file
+#define JOURNAL_PREFIX "journal."                         ///< files: journal.<run>.<seq|lock>
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief kinds of journal records
+enum journal_kind {
+  JOURNAL_REQUEST = 1,                                      ///< a customer's request was accepted
+  JOURNAL_ORDER,                                            ///< count burgers of type were ordered
+  JOURNAL_BURGER,                                           ///< a burger of type was made
+  JOURNAL_DONE                                              ///< the request is over
+};
+
+/// @brief a journal record. Records are written to the mapped segment as they are and carry a
+///        checksum; a zero checksum marks the unwritten end of a segment.
+typedef struct __journal_record {
+  uint64_t request;                                         ///< (run << 32) | customer ID
+  uint16_t count;                                           ///< number of burgers (ORDER)
+  uint8_t type;                                             ///< burger type (ORDER, BURGER)
+  uint8_t kind;                                             ///< enum journal_kind
+  uint32_t check;                                           ///< checksum, never 0
+} JournalRecord;
+
+/// @brief journal metrics
+typedef struct __journal_stats {
+  uint64_t records;                                         ///< records appended
+  uint64_t commits;                                         ///< group commits (fsyncs)
+  uint64_t sync_ns;                                         ///< total time spent in fsync
+  uint64_t sync_max_ns;                                     ///< longest fsync
+  uint64_t segments;                                        ///< segments created
+  uint64_t recovered;                                       ///< requests restored by the replay
+  double seconds;                                           ///< time since the journal was opened
+} JournalStats;
+
+/// @brief replay function: called for every request whose burgers were not all made
+/// @param run run of the server that accepted the request
+/// @param customerID customer ID of the request in that run
+/// @param pending number of burgers still to make, per burger type (MENU_MAX entries). Types
+///        are not checked against the menu, which may have changed since the records were written.
+/// @param data user data
+typedef void (*journal_replay_fn)(unsigned int run, unsigned int customerID,
+                                  unsigned int *pending, void *data);
+
+/// @}
+
+/// @brief open the journal in directory @a dir. The segments of earlier runs whose server is gone
+///        are replayed, and @a fn is called for every pending request; it may append records for
+///        the restored requests. Afterwards, the replayed segments are deleted and a committer
+///        thread starts that syncs appended records in groups, one fsync per group. A server
+///        that is still running (e.g., draining after a takeover) keeps its segments.
+/// @param dir directory of the segment files
+/// @param fn replay function (may be NULL)
+/// @param data user data for @a fn
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code. The journal stays disabled.
+int journal_open(const char *dir, journal_replay_fn fn, void *data);
+
+/// @brief sync all records, stop the committer thread and close the journal. If no request is
+///        pending, the segments are deleted; otherwise those older than the segment of the
+///        oldest pending request.
+void journal_close(void);
+
+/// @brief true if the journal is open
+bool journal_enabled(void);
+
+/// @brief append a record. Does not wait for the record to become durable. No-op if the journal
+///        is not open.
+/// @param kind record kind
+/// @param customerID customer ID of the request in this run
+/// @param type burger type (ORDER, BURGER)
+/// @param count number of burgers (ORDER)
+/// @retval position of the record, for journal_sync()
+uint64_t journal_append(enum journal_kind kind, unsigned int customerID, enum burger_type type,
+                        unsigned int count);
+
+/// @brief wait until all records up to position @a lsn are durable
+/// @param lsn position returned by journal_append()
+void journal_sync(uint64_t lsn);
+
+/// @brief get the metrics of the journal
+/// @param s metrics. Out parameter.
+void journal_stats(JournalStats *s);
+
+#endif // __JOURNAL_H__
@@ -0,0 +1,249 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  lobby.c
+/// @brief Waiting room for idle customers: epoll instead of a thread per connection
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab name the lobby thread
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include "lobby.h"
+#include "pool.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief the lobby. Its thread is the only one that frees a waiting connection; an expired
+///        read deadline only shuts the socket down, which the thread then notices.
+struct lobby {
+  int epfd;                                                 ///< epoll instance
+  int wakefd;                                               ///< wakes up the thread to stop
+  pthread_t thread;                                         ///< lobby thread
+  bool started;                                             ///< lobby thread has been started
+  bool closing;                                             ///< lobby thread stops
+  lobby_fn fn;                                              ///< called when a customer leaves
+  unsigned int max;                                         ///< max. customers waiting
+  unsigned int timeout;                                     ///< max. wait without data (ms)
+  unsigned int count;                                       ///< customers waiting
+};
+
+/// @}
+
+static struct lobby lobby = { .epfd = -1, .wakefd = -1 };
+static Slab conns;                                          ///< slab of connections
+static pthread_once_t conns_once = PTHREAD_ONCE_INIT;
+
+/// @brief set up the slab of connections
+static void init_conns(void)
+{
+  slab_init(&conns, sizeof(Conn));
+}
+
+Conn* conn_new(int fd, unsigned int id)
+{
+  Conn *c;
+
+  pthread_once(&conns_once, init_conns);
+  if ((c = (Conn *)slab_alloc(&conns)) == NULL) return NULL;
+  memset(c, 0, sizeof(*c));
+  c->fd = fd;
+  c->id = id;
+  return c;
+}
+
+void conn_free(Conn *c)
+{
+  slab_free(&conns, c);
+}
+
+unsigned int conn_count(void)
+{
+  unsigned int n;
+
+  pthread_once(&conns_once, init_conns);
+  pthread_mutex_lock(&conns.lock);
+  n = conns.used;
+  pthread_mutex_unlock(&conns.lock);
+  return n;
+}
+
+/// @brief timer expiry function: a customer waited too long without sending. Shuts the socket
+///        down so that epoll reports it to the lobby thread.
+/// @param t expired timer
+static void expire_conn(Timer *t)
+{
+  Conn *c = (Conn *)t->data;
+  uint32_t waiting = CONN_WAITING;
+
+  if (__atomic_compare_exchange_n(&c->state, &waiting, CONN_EXPIRED, false, __ATOMIC_ACQ_REL,
+                                  __ATOMIC_ACQUIRE)) {
+    shutdown(c->fd, SHUT_RDWR);
+  }
+}
+
+/// @brief a customer leaves the lobby: data arrived, it hung up or it timed out
+/// @param c connection
+/// @param events epoll events of its socket
+static void leave(Conn *c, uint32_t events)
+{
+  uint32_t waiting = CONN_WAITING;
+  bool ready;
+  char byte;
+
+  // Whoever changes the state first owns the customer. After timer_cancel() returns, a running
+  // expiry function is done with it.
+  ready = __atomic_compare_exchange_n(&c->state, &waiting, CONN_READY, false, __ATOMIC_ACQ_REL,
+                                      __ATOMIC_ACQUIRE) && (events & EPOLLIN);
+  timer_cancel(&c->timer);
+  epoll_ctl(lobby.epfd, EPOLL_CTL_DEL, c->fd, NULL);
+  __atomic_sub_fetch(&lobby.count, 1, __ATOMIC_RELAXED);
+
+  // A customer who hung up without ordering needs no serving thread
+  if (ready && (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+    ready = recv(c->fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) > 0;
+  }
+  if (!ready) {
+    close(c->fd);
+    c->fd = -1;
+  }
+  lobby.fn(c, ready);
+}
+
+/// @brief lobby thread: wait for data on the sockets of the waiting customers
+/// @param dummy unused
+static void* lobby_task(void *dummy)
+{
+  struct epoll_event events[LOBBY_EVENTS];
+  uint64_t value;
+  int i, n;
+
+  pthread_setname_np(pthread_self(), "mcd-lobby");
+  while (!__atomic_load_n(&lobby.closing, __ATOMIC_ACQUIRE)) {
+    n = epoll_wait(lobby.epfd, events, LOBBY_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      perror("epoll_wait");
+      break;
+    }
+    for (i = 0; i < n; i++) {
+      if (events[i].data.ptr == NULL) {
+        if (read(lobby.wakefd, &value, sizeof(value)) < 0) {}
+        continue;
+      }
+      leave((Conn *)events[i].data.ptr, events[i].events);
+    }
+  }
+
+  return NULL;
+}
+
+int lobby_open(unsigned int max, unsigned int timeout_ms, lobby_fn fn)
+{
+  struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+
+  lobby.max = max;
+  lobby.timeout = timeout_ms;
+  lobby.fn = fn;
+  lobby.closing = false;
+
+  lobby.epfd = epoll_create1(EPOLL_CLOEXEC);
+  lobby.wakefd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if ((lobby.epfd < 0) || (lobby.wakefd < 0) ||
+      (epoll_ctl(lobby.epfd, EPOLL_CTL_ADD, lobby.wakefd, &ev) < 0) ||
+      pthread_create(&lobby.thread, NULL, lobby_task, NULL)) {
+    if (lobby.epfd >= 0) close(lobby.epfd);
+    if (lobby.wakefd >= 0) close(lobby.wakefd);
+    lobby.epfd = lobby.wakefd = -1;
+    return -1;
+  }
+  lobby.started = true;
+
+  return 0;
+}
+
+int lobby_enter(Conn *c)
+{
+  struct epoll_event ev;
+
+  if (!lobby.started || __atomic_load_n(&lobby.closing, __ATOMIC_ACQUIRE)) return -1;
+  if (__atomic_add_fetch(&lobby.count, 1, __ATOMIC_RELAXED) > lobby.max) {
+    __atomic_sub_fetch(&lobby.count, 1, __ATOMIC_RELAXED);
+    return -1;
+  }
+
+  // Arm the deadline first: once the socket is in the epoll set, the lobby thread may free c.
+  // A deadline that expires before shuts the socket down, which epoll reports right away.
+  c->state = CONN_WAITING;
+  timer_setup(&c->timer, expire_conn, c);
+  if (lobby.timeout > 0) timer_arm(&c->timer, lobby.timeout);
+
+  ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.ptr = c;
+  if (epoll_ctl(lobby.epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+    timer_cancel(&c->timer);
+    __atomic_sub_fetch(&lobby.count, 1, __ATOMIC_RELAXED);
+    return -1;
+  }
+
+  return 0;
+}
+
+unsigned int lobby_count(void)
+{
+  return __atomic_load_n(&lobby.count, __ATOMIC_RELAXED);
+}
+
+void lobby_close(void)
+{
+  uint64_t one = 1;
+
+  if (!lobby.started) return;
+
+  __atomic_store_n(&lobby.closing, true, __ATOMIC_RELEASE);
+  if (write(lobby.wakefd, &one, sizeof(one)) < 0) {}
+  pthread_join(lobby.thread, NULL);
+  lobby.started = false;
+
+  close(lobby.epfd);
+  close(lobby.wakefd);
+  lobby.epfd = lobby.wakefd = -1;
+}
@@ -0,0 +1,121 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  lobby.h
+/// @brief Waiting room for idle customers: epoll instead of a thread per connection
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab customers who ordered wait for a seat
+/// 2026/10/19 ARC lab lobby no larger than the limit on open files
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __LOBBY_H__
+#define __LOBBY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "timer.h"
+
+/// @name Macro definitions
+/// @{
+
+#define LOBBY_MAX 131072                                  ///< default max. customers waiting
+#define LOBBY_EVENTS 256                                  ///< events handled per wakeup
+#define LOBBY_FD_RESERVE 256                              ///< fds not given to the lobby: served
+                                                          ///< customers, kitchens, journal, logs
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief state of a connection in the lobby
+enum conn_state {
+  CONN_WAITING,                                             ///< waiting for data
+  CONN_READY,                                               ///< left the lobby
+  CONN_EXPIRED                                              ///< read deadline expired
+};
+
+/// @brief a customer's connection. Allocated from a slab; this is all the server keeps of an
+///        idle customer.
+typedef struct __conn {
+  int fd;                                                   ///< socket
+  unsigned int id;                                          ///< customer ID
+  uint32_t state;                                           ///< enum conn_state
+  bool welcomed;                                            ///< welcome message was sent
+  union {
+    Timer timer;                                            ///< read deadline in the lobby
+    struct __conn *next;                                    ///< next customer waiting for a seat,
+                                                            ///< once out of the lobby
+  };
+} Conn;
+
+/// @brief called on the lobby thread when a customer leaves the lobby
+/// @param c connection. The function takes ownership.
+/// @param ready data arrived; otherwise the customer hung up or timed out, and c->fd is closed
+typedef void (*lobby_fn)(Conn *c, bool ready);
+
+/// @}
+
+/// @brief allocate a connection
+/// @param fd socket
+/// @param id customer ID
+/// @retval Conn* connection
+/// @retval NULL if out of memory
+Conn* conn_new(int fd, unsigned int id);
+
+/// @brief free a connection; does not close its socket
+/// @param c connection
+void conn_free(Conn *c);
+
+/// @brief number of connections allocated right now
+/// @retval number of connections
+unsigned int conn_count(void);
+
+/// @brief start the lobby thread
+/// @param max max. customers waiting
+/// @param timeout_ms max. time a customer may wait without sending (0: none)
+/// @param fn called when a customer leaves the lobby
+/// @retval 0 on success
+/// @retval -1 on error
+int lobby_open(unsigned int max, unsigned int timeout_ms, lobby_fn fn);
+
+/// @brief let a customer wait in the lobby until data arrives on its socket
+/// @param c connection
+/// @retval 0 on success
+/// @retval -1 if the lobby is full or closed; the caller keeps @a c
+int lobby_enter(Conn *c);
+
+/// @brief number of customers waiting in the lobby
+/// @retval number of customers
+unsigned int lobby_count(void);
+
+/// @brief stop the lobby thread. Customers still waiting are dropped when the process exits.
+void lobby_close(void);
+
+#endif // __LOBBY_H__
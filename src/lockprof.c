@@ -0,0 +1,470 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  lockprof.c
+/// @brief Lock contention profiler, swapped in for the pthread locks at build time
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lockprof.h"
+
+/// @brief percentile of a wait or hold time histogram
+uint64_t lockprof_percentile(const uint64_t *hist, int p)
+{
+  uint64_t total = 0, target, sum = 0;
+  int i;
+
+  for (i = 0; i < LOCKPROF_BUCKETS; i++) total += hist[i];
+  if (total == 0) return 0;
+  target = (total * p + 99) / 100;
+  if (target == 0) target = 1;
+  for (i = 0; i < LOCKPROF_BUCKETS - 1; i++) {
+    sum += hist[i];
+    if (sum >= target) break;
+  }
+  return 1ULL << (i + 1);
+}
+
+#ifdef LOCKPROF
+
+// the wrappers below call the real functions
+#undef pthread_mutex_lock
+#undef pthread_mutex_unlock
+#undef pthread_cond_wait
+#undef pthread_cond_timedwait
+
+/// @name Structures
+/// @{
+
+/// @brief counters of a lock class. A thread's counters are written by that thread only and read
+///        by others with relaxed atomics, so they need no lock.
+typedef struct __lock_counts {
+  uint64_t acquired;                                        ///< acquisitions
+  uint64_t contended;                                       ///< acquisitions that had to wait
+  uint64_t wait_ns;                                         ///< total time waiting for the lock
+  uint64_t wait_max_ns;                                     ///< longest wait
+  uint64_t holds;                                           ///< holds timed
+  uint64_t hold_ns;                                         ///< total time of the holds timed
+  uint64_t hold_max_ns;                                     ///< longest hold timed
+  uint64_t sleeps;                                          ///< condition waits on the lock
+  uint64_t sleep_ns;                                        ///< total time in condition waits
+  uint64_t wait_hist[LOCKPROF_BUCKETS];                     ///< wait times of contended locks
+  uint64_t hold_hist[LOCKPROF_BUCKETS];                     ///< times of the holds timed
+} LockCounts;
+
+/// @brief a lock held by a thread
+typedef struct __lock_held {
+  pthread_mutex_t *m;                                       ///< mutex
+  int cls;                                                  ///< lock class
+  uint64_t since;                                           ///< time of the acquisition
+} LockHeld;
+
+/// @brief counters and held locks of a thread
+typedef struct __lock_thread {
+  LockCounts counts[LOCKPROF_CLASSES];                      ///< counters by lock class
+  LockHeld held[LOCKPROF_HELD];                             ///< locks timed, innermost last
+  int nheld;                                                ///< entries in held
+  unsigned int tick;                                        ///< acquisitions, picks those timed
+  struct __lock_thread *prev;                               ///< previous thread
+  struct __lock_thread *next;                               ///< next thread
+} LockThread;
+
+/// @}
+
+/// @name Global variables
+/// @{
+
+static pthread_mutex_t registry = PTHREAD_MUTEX_INITIALIZER; ///< protects the variables below
+static const char *names[LOCKPROF_CLASSES];                 ///< names of the lock classes
+static int nclasses;                                        ///< lock classes in names
+static LockThread *threads;                                 ///< threads that locked a mutex
+static LockCounts retired[LOCKPROF_CLASSES];                ///< counters of exited threads
+static LockSite *sites;                                     ///< sites that waited (lock-free push)
+static pthread_once_t once = PTHREAD_ONCE_INIT;             ///< creates key
+static pthread_key_t key;                                   ///< retires a thread's counters on exit
+static __thread LockThread *self;                           ///< counters of this thread
+
+/// @}
+
+/// @brief nanoseconds of the monotonic clock
+/// @retval nanoseconds
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/// @brief histogram bucket of a time
+/// @param ns time in nanoseconds
+/// @retval bucket
+static int bucket(uint64_t ns)
+{
+  int b = 63 - __builtin_clzll(ns | 1);
+
+  return (b < LOCKPROF_BUCKETS) ? b : LOCKPROF_BUCKETS - 1;
+}
+
+/// @brief add to a counter of this thread
+/// @param p counter
+/// @param v value
+static void bump(uint64_t *p, uint64_t v)
+{
+  __atomic_store_n(p, __atomic_load_n(p, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED);
+}
+
+/// @brief raise a maximum of this thread
+/// @param p maximum
+/// @param v value
+static void raise_max(uint64_t *p, uint64_t v)
+{
+  if (v > *p) __atomic_store_n(p, v, __ATOMIC_RELAXED);
+}
+
+/// @brief add counters
+/// @param dst sum
+/// @param src counters, possibly of a running thread
+static void merge(LockCounts *dst, const LockCounts *src)
+{
+  uint64_t v;
+  int i;
+
+  dst->acquired += __atomic_load_n(&src->acquired, __ATOMIC_RELAXED);
+  dst->contended += __atomic_load_n(&src->contended, __ATOMIC_RELAXED);
+  dst->wait_ns += __atomic_load_n(&src->wait_ns, __ATOMIC_RELAXED);
+  dst->holds += __atomic_load_n(&src->holds, __ATOMIC_RELAXED);
+  dst->hold_ns += __atomic_load_n(&src->hold_ns, __ATOMIC_RELAXED);
+  dst->sleeps += __atomic_load_n(&src->sleeps, __ATOMIC_RELAXED);
+  dst->sleep_ns += __atomic_load_n(&src->sleep_ns, __ATOMIC_RELAXED);
+  v = __atomic_load_n(&src->wait_max_ns, __ATOMIC_RELAXED);
+  if (v > dst->wait_max_ns) dst->wait_max_ns = v;
+  v = __atomic_load_n(&src->hold_max_ns, __ATOMIC_RELAXED);
+  if (v > dst->hold_max_ns) dst->hold_max_ns = v;
+  for (i = 0; i < LOCKPROF_BUCKETS; i++) {
+    dst->wait_hist[i] += __atomic_load_n(&src->wait_hist[i], __ATOMIC_RELAXED);
+    dst->hold_hist[i] += __atomic_load_n(&src->hold_hist[i], __ATOMIC_RELAXED);
+  }
+}
+
+/// @brief key destructor: fold the counters of an exiting thread into retired
+/// @param data counters of the thread
+static void retire(void *data)
+{
+  LockThread *t = data;
+  int i;
+
+  pthread_mutex_lock(&registry);
+  for (i = 0; i < LOCKPROF_CLASSES; i++) merge(&retired[i], &t->counts[i]);
+  if (t->prev) t->prev->next = t->next;
+  else threads = t->next;
+  if (t->next) t->next->prev = t->prev;
+  pthread_mutex_unlock(&registry);
+  self = NULL;
+  free(t);
+}
+
+/// @brief create the key that retires the counters of exiting threads
+static void create_key(void)
+{
+  pthread_key_create(&key, retire);
+}
+
+/// @brief get the counters of this thread, creating them on its first lock
+/// @retval LockThread* counters
+/// @retval NULL if out of memory; the thread's locks are not profiled
+static LockThread* thread_self(void)
+{
+  LockThread *t = self;
+
+  if (t) return t;
+  pthread_once(&once, create_key);
+  if ((t = calloc(1, sizeof(*t))) == NULL) return NULL;
+  t->tick = (uintptr_t)t >> 4;                              // threads start the sample apart
+  pthread_setspecific(key, t);
+
+  pthread_mutex_lock(&registry);
+  t->next = threads;
+  if (threads) threads->prev = t;
+  threads = t;
+  pthread_mutex_unlock(&registry);
+  return self = t;
+}
+
+/// @brief get the lock class of a call site: the lock expression without '&'. Locks past
+///        LOCKPROF_CLASSES - 1 classes share the last one.
+/// @param s call site
+/// @retval lock class
+static int site_class(LockSite *s)
+{
+  const char *name = s->lock;
+  int cls = __atomic_load_n(&s->cls, __ATOMIC_ACQUIRE);
+
+  if (cls > 0) return cls - 1;
+  while ((*name == '&') || (*name == ' ')) name++;
+
+  pthread_mutex_lock(&registry);
+  for (cls = 0; (cls < nclasses) && strcmp(names[cls], name); cls++);
+  if (cls == nclasses) {
+    if (nclasses < LOCKPROF_CLASSES - 1) {
+      names[nclasses++] = name;
+    } else {
+      cls = LOCKPROF_CLASSES - 1;
+      names[cls] = "(other)";
+      nclasses = LOCKPROF_CLASSES;
+    }
+  }
+  pthread_mutex_unlock(&registry);
+
+  __atomic_store_n(&s->cls, cls + 1, __ATOMIC_RELEASE);
+  return cls;
+}
+
+/// @brief count a wait at a call site; the site joins the list of waiters on its first wait
+/// @param s call site
+/// @param ns wait time
+static void site_wait(LockSite *s, uint64_t ns)
+{
+  uint64_t max = __atomic_load_n(&s->wait_max_ns, __ATOMIC_RELAXED);
+
+  if (!__atomic_exchange_n(&s->listed, 1, __ATOMIC_ACQ_REL)) {
+    s->next = __atomic_load_n(&sites, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&sites, &s->next, s, true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED));
+  }
+  __atomic_fetch_add(&s->waits, 1, __ATOMIC_RELAXED);
+  while ((ns > max) && !__atomic_compare_exchange_n(&s->wait_max_ns, &max, ns, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/// @brief time a lock this thread acquired until its release, if it is one of the sample
+/// @param t counters of this thread
+/// @param m mutex
+/// @param cls lock class
+/// @param now time of the acquisition (0: read the clock)
+static void hold(LockThread *t, pthread_mutex_t *m, int cls, uint64_t now)
+{
+  if ((++t->tick % LOCKPROF_SAMPLE) || (t->nheld == LOCKPROF_HELD)) return;
+  t->held[t->nheld++] = (LockHeld){ m, cls, now ? now : now_ns() };
+}
+
+/// @brief count the hold time of a lock this thread releases, if it was timed
+/// @param t counters of this thread
+/// @param m mutex
+/// @param now time of the release (0: read the clock)
+static void release(LockThread *t, pthread_mutex_t *m, uint64_t now)
+{
+  LockCounts *c;
+  uint64_t ns;
+  int i;
+
+  for (i = t->nheld - 1; (i >= 0) && (t->held[i].m != m); i--);
+  if (i < 0) return;
+
+  c = &t->counts[t->held[i].cls];
+  ns = (now ? now : now_ns()) - t->held[i].since;
+  bump(&c->holds, 1);
+  bump(&c->hold_ns, ns);
+  bump(&c->hold_hist[bucket(ns)], 1);
+  raise_max(&c->hold_max_ns, ns);
+  memmove(&t->held[i], &t->held[i + 1], (t->nheld - i - 1) * sizeof(LockHeld));
+  t->nheld--;
+}
+
+int lockprof_lock(pthread_mutex_t *m, LockSite *s)
+{
+  LockThread *t = thread_self();
+  int cls = site_class(s);
+  uint64_t start = 0, now = 0, ns;
+  LockCounts *c;
+  int ret;
+
+  ret = pthread_mutex_trylock(m);
+  if (ret == EBUSY) {
+    start = now_ns();
+    ret = pthread_mutex_lock(m);
+  }
+  if ((ret != 0) || (t == NULL)) return ret;
+
+  c = &t->counts[cls];
+  bump(&c->acquired, 1);
+  if (start > 0) {
+    now = now_ns();
+    ns = now - start;
+    bump(&c->contended, 1);
+    bump(&c->wait_ns, ns);
+    bump(&c->wait_hist[bucket(ns)], 1);
+    raise_max(&c->wait_max_ns, ns);
+    site_wait(s, ns);
+  }
+  hold(t, m, cls, now);
+  return 0;
+}
+
+int lockprof_unlock(pthread_mutex_t *m)
+{
+  if (self && self->nheld) release(self, m, 0);
+  return pthread_mutex_unlock(m);
+}
+
+int lockprof_cond_wait(pthread_cond_t *c, pthread_mutex_t *m, const struct timespec *until,
+                       LockSite *s)
+{
+  LockThread *t = thread_self();
+  int cls = site_class(s);
+  uint64_t start = now_ns(), now;
+  int ret;
+
+  // The wait releases the lock; the time until it is reacquired counts as sleep, not as wait
+  if (t) release(t, m, start);
+  ret = until ? pthread_cond_timedwait(c, m, until) : pthread_cond_wait(c, m);
+  if (t) {
+    now = now_ns();
+    bump(&t->counts[cls].sleeps, 1);
+    bump(&t->counts[cls].sleep_ns, now - start);
+    hold(t, m, cls, now);
+  }
+  return ret;
+}
+
+int lockprof_stats(LockStats *ls, int max)
+{
+  static LockCounts sum[LOCKPROF_CLASSES];
+  static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+  int order[LOCKPROF_CLASSES];
+  LockThread *t;
+  LockSite *s;
+  int i, j, k, n = 0;
+
+  pthread_mutex_lock(&stats_lock);
+  pthread_mutex_lock(&registry);
+  memcpy(sum, retired, sizeof(sum));
+  for (t = threads; t; t = t->next) {
+    for (i = 0; i < nclasses; i++) merge(&sum[i], &t->counts[i]);
+  }
+
+  // Sort the classes that were locked by their total wait time
+  for (i = 0; i < nclasses; i++) {
+    if (sum[i].acquired == 0) continue;
+    for (j = n; (j > 0) && (sum[order[j - 1]].wait_ns < sum[i].wait_ns); j--) order[j] = order[j - 1];
+    order[j] = i;
+    n++;
+  }
+  if (n > max) n = max;
+
+  for (k = 0; k < n; k++) {
+    LockCounts *c = &sum[order[k]];
+    LockStats *l = &ls[k];
+
+    memset(l, 0, sizeof(*l));
+    l->name = names[order[k]];
+    l->acquired = c->acquired;
+    l->contended = c->contended;
+    l->wait_ns = c->wait_ns;
+    l->wait_max_ns = c->wait_max_ns;
+    l->holds = c->holds;
+    l->hold_ns = c->hold_ns;
+    l->hold_max_ns = c->hold_max_ns;
+    l->sleeps = c->sleeps;
+    l->sleep_ns = c->sleep_ns;
+    memcpy(l->wait_hist, c->wait_hist, sizeof(l->wait_hist));
+    memcpy(l->hold_hist, c->hold_hist, sizeof(l->hold_hist));
+  }
+  pthread_mutex_unlock(&registry);
+
+  // Keep the call sites of the longest waits of every class
+  for (s = __atomic_load_n(&sites, __ATOMIC_ACQUIRE); s; s = s->next) {
+    int cls = __atomic_load_n(&s->cls, __ATOMIC_ACQUIRE) - 1;
+    LockSite copy = *s;
+
+    for (k = 0; (k < n) && (order[k] != cls); k++);
+    if (k == n) continue;
+    copy.wait_max_ns = __atomic_load_n(&s->wait_max_ns, __ATOMIC_RELAXED);
+    copy.waits = __atomic_load_n(&s->waits, __ATOMIC_RELAXED);
+    for (j = ls[k].nsites; (j > 0) && (ls[k].site[j - 1].wait_max_ns < copy.wait_max_ns); j--) {
+      if (j < LOCKPROF_SITES) ls[k].site[j] = ls[k].site[j - 1];
+    }
+    if (j < LOCKPROF_SITES) ls[k].site[j] = copy;
+    if (ls[k].nsites < LOCKPROF_SITES) ls[k].nsites++;
+  }
+  pthread_mutex_unlock(&stats_lock);
+  return n;
+}
+
+void lockprof_dump(FILE *f)
+{
+  static LockStats ls[LOCKPROF_CLASSES];
+  uint64_t wait[2], hold[2];
+  int i, j, k, n = lockprof_stats(ls, LOCKPROF_CLASSES);
+
+  if (n == 0) return;
+  fprintf(f, "Lock profile (us; p50 and p99 are upper bounds; 1 in %d holds timed):\n",
+          LOCKPROF_SAMPLE);
+  fprintf(f, "  %-22s %10s %6s %10s %8s %8s %8s %8s %8s %8s\n", "lock", "acquired", "cont%",
+          "wait tot", "p50", "p99", "max", "hold p50", "p99", "max");
+  for (i = 0; i < n; i++) {
+    for (k = 0; k < 2; k++) {
+      wait[k] = lockprof_percentile(ls[i].wait_hist, k ? 99 : 50);
+      if (wait[k] > ls[i].wait_max_ns) wait[k] = ls[i].wait_max_ns;
+      hold[k] = lockprof_percentile(ls[i].hold_hist, k ? 99 : 50);
+      if (hold[k] > ls[i].hold_max_ns) hold[k] = ls[i].hold_max_ns;
+    }
+    fprintf(f, "  %-22s %10lu %5.1f%% %10.0f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", ls[i].name,
+            (unsigned long)ls[i].acquired, 100.0 * ls[i].contended / ls[i].acquired,
+            ls[i].wait_ns / 1e3, wait[0] / 1e3, wait[1] / 1e3, ls[i].wait_max_ns / 1e3,
+            hold[0] / 1e3, hold[1] / 1e3, ls[i].hold_max_ns / 1e3);
+    if (ls[i].sleeps > 0) {
+      fprintf(f, "    %lu condition wait(s), %.1f ms asleep\n", (unsigned long)ls[i].sleeps,
+              ls[i].sleep_ns / 1e6);
+    }
+    for (j = 0; j < ls[i].nsites; j++) {
+      fprintf(f, "    %s:%d waited %lu time(s), max %.1f us\n", ls[i].site[j].file,
+              ls[i].site[j].line, (unsigned long)ls[i].site[j].waits,
+              ls[i].site[j].wait_max_ns / 1e3);
+    }
+  }
+}
+
+#else
+
+int lockprof_stats(LockStats *ls, int max)
+{
+  return 0;
+}
+
+void lockprof_dump(FILE *f)
+{
+}
+
+#endif // LOCKPROF
@@ -0,0 +1,139 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  lockprof.h
+/// @brief Lock contention profiler, swapped in for the pthread locks at build time
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __LOCKPROF_H__
+#define __LOCKPROF_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// @name Macro definitions
+/// @{
+
+#define LOCKPROF_CLASSES 32                               ///< locks told apart; the last is "other"
+#define LOCKPROF_BUCKETS 32                               ///< wait and hold time histogram buckets
+#define LOCKPROF_HELD 8                                   ///< locks a thread holds at once, timed
+#define LOCKPROF_SITES 4                                  ///< call sites of the longest waits
+#ifndef LOCKPROF_SAMPLE
+#define LOCKPROF_SAMPLE 16                                ///< a thread times every n-th hold
+#endif
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief a call site that locks a mutex. Every site is a static variable of its own, created by
+///        the macros below; it resolves its lock class once and is listed when it first waits.
+typedef struct __lock_site {
+  const char *lock;                                         ///< lock expression, names the class
+  const char *file;                                         ///< source file
+  int line;                                                 ///< source line
+  int cls;                                                  ///< lock class + 1 (0: unresolved)
+  int listed;                                               ///< site is on the list of waiters
+  uint64_t waits;                                           ///< contended acquisitions
+  uint64_t wait_max_ns;                                     ///< longest wait
+  struct __lock_site *next;                                 ///< next site on the list of waiters
+} LockSite;
+
+/// @brief profile of a lock class: all mutexes locked through the same expression, like
+///        "req->cond_mutex" for the mutexes of all requests.
+///        Histogram bucket i counts times of [2^i, 2^(i+1)) ns; the last takes everything longer.
+///        The wait histogram counts contended acquisitions only. Reading the clock costs more than
+///        taking a free lock, so only every LOCKPROF_SAMPLE-th acquisition of a thread is timed
+///        until its release; the hold times are those of the sample.
+typedef struct __lock_stats {
+  const char *name;                                         ///< lock expression without '&'
+  uint64_t acquired;                                        ///< acquisitions
+  uint64_t contended;                                       ///< acquisitions that had to wait
+  uint64_t wait_ns;                                         ///< total time waiting for the lock
+  uint64_t wait_max_ns;                                     ///< longest wait
+  uint64_t holds;                                           ///< holds timed
+  uint64_t hold_ns;                                         ///< total time of the holds timed
+  uint64_t hold_max_ns;                                     ///< longest hold timed
+  uint64_t sleeps;                                          ///< condition waits on the lock
+  uint64_t sleep_ns;                                        ///< total time in condition waits
+  uint64_t wait_hist[LOCKPROF_BUCKETS];                     ///< wait times of contended locks
+  uint64_t hold_hist[LOCKPROF_BUCKETS];                     ///< times of the holds timed
+  unsigned int nsites;                                      ///< entries in site
+  LockSite site[LOCKPROF_SITES];                            ///< call sites of the longest waits
+} LockStats;
+
+/// @}
+
+/// @brief get the profiles of the locks, merged over all threads and sorted by total wait time.
+///        Without LOCKPROF, there are none.
+/// @param ls profiles. Out parameter.
+/// @param max entries in @a ls
+/// @retval number of profiles
+int lockprof_stats(LockStats *ls, int max);
+
+/// @brief print the profiles of the locks; prints nothing without LOCKPROF
+/// @param f output stream
+void lockprof_dump(FILE *f);
+
+/// @brief percentile of a wait or hold time histogram
+/// @param hist histogram
+/// @param p percentile (0-100)
+/// @retval upper bound of the bucket holding the percentile in ns, 0 for an empty histogram
+uint64_t lockprof_percentile(const uint64_t *hist, int p);
+
+#ifdef LOCKPROF
+
+/// @name Instrumented locks
+/// With LOCKPROF defined (make LOCKPROF=1), the macros below replace the pthread calls of every
+/// source file that includes this header after <pthread.h>. Each thread adds up its own counters, so a
+/// free lock costs a trylock more and touches no shared cache line; only a contended one reads
+/// the clock and updates its call site.
+/// @{
+
+int lockprof_lock(pthread_mutex_t *m, LockSite *s);
+int lockprof_unlock(pthread_mutex_t *m);
+int lockprof_cond_wait(pthread_cond_t *c, pthread_mutex_t *m, const struct timespec *until,
+                       LockSite *s);
+
+/// @brief the call site of a lock operation on @a m
+#define LOCKPROF_SITE(m) \
+  ({ static LockSite __lockprof_site = { #m, __FILE__, __LINE__ }; &__lockprof_site; })
+
+#define pthread_mutex_lock(m) lockprof_lock((m), LOCKPROF_SITE(m))
+#define pthread_mutex_unlock(m) lockprof_unlock(m)
+#define pthread_cond_wait(c, m) lockprof_cond_wait((c), (m), NULL, LOCKPROF_SITE(m))
+#define pthread_cond_timedwait(c, m, t) lockprof_cond_wait((c), (m), (t), LOCKPROF_SITE(m))
+
+/// @}
+
+#endif // LOCKPROF
+
+#endif // __LOCKPROF_H__
@@ -0,0 +1,399 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  log.c
+/// @brief Asynchronous logging through per-thread ring buffers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief a single log message; formatted by the drainer thread
+typedef struct __log_record {
+  uint64_t ts;                                              ///< CLOCK_MONOTONIC timestamp in ns
+  const char *fmt;                                          ///< format string
+  uint64_t args[LOG_ARGS_MAX];                              ///< arguments of fmt
+  int level;                                                ///< log level
+} LogRecord;
+
+/// @brief single-producer/single-consumer ring of the records of one thread. The owning thread
+///        only advances head, the drainer only advances tail; both live on their own cache line.
+typedef struct __log_ring {
+  LogRecord rec[LOG_RING_SIZE];                             ///< records
+  uint64_t head __attribute__((aligned(64)));               ///< next record to write
+  uint64_t dropped;                                         ///< records dropped by the owner
+  uint64_t tail __attribute__((aligned(64)));               ///< next record to drain
+  uint64_t reported;                                        ///< dropped records already reported
+  int dead;                                                 ///< owning thread has exited
+  struct __log_ring *next;                                  ///< next ring in ring list
+} LogRing;
+
+/// @}
+
+/// @name Global variables
+/// @{
+
+const char *log_level_names[] = { "error", "warn", "info", "debug" };
+volatile int log_level = LOG_INFO;
+
+static LogRing *rings = NULL;                               ///< rings of all threads
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER; ///< protects ring list
+static pthread_key_t ring_key;                              ///< marks a ring dead at thread exit
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;    ///< creates ring_key
+static __thread LogRing *my_ring = NULL;                    ///< ring of the calling thread
+
+static pthread_t drainer;                                   ///< drainer thread
+static bool drainer_running = false;                        ///< drainer thread has been started
+static volatile int drainer_stop = 0;                       ///< asks the drainer to finish
+static volatile int log_closed = 0;                         ///< drop all further records
+static int log_fd = -1;                                     ///< output file descriptor
+static uint64_t total_dropped = 0;                          ///< dropped records reported so far
+
+static LogRecord *batch = NULL;                             ///< records drained in one round
+static size_t batch_cap = 0;                                ///< allocated records in batch
+
+/// @}
+
+
+/// @brief thread-specific data destructor: hand the ring of an exiting thread to the drainer
+/// @param ring ring of the exiting thread
+static void release_ring(void *ring)
+{
+  __atomic_store_n(&((LogRing *)ring)->dead, 1, __ATOMIC_RELEASE);
+}
+
+/// @brief create ring_key
+static void create_ring_key(void)
+{
+  pthread_key_create(&ring_key, release_ring);
+}
+
+/// @brief allocate and register the ring of the calling thread
+/// @retval LogRing* ring of the calling thread
+/// @retval NULL if out of memory
+static LogRing* new_ring(void)
+{
+  LogRing *r;
+
+  pthread_once(&ring_key_once, create_ring_key);
+
+  r = (LogRing *)aligned_alloc(64, sizeof(LogRing));
+  if (r == NULL) return NULL;
+  memset(r, 0, sizeof(LogRing));
+
+  pthread_mutex_lock(&rings_lock);
+  r->next = rings;
+  rings = r;
+  pthread_mutex_unlock(&rings_lock);
+
+  pthread_setspecific(ring_key, r);
+  my_ring = r;
+
+  return r;
+}
+
+void log_write(int level, const char *fmt, ...)
+{
+  LogRing *r = my_ring;
+  LogRecord *rec;
+  struct timespec ts;
+  uint64_t head, tail;
+  const char *p;
+  bool long_arg;
+  va_list ap;
+  int n = 0;
+
+  if (log_closed) return;
+  if ((r == NULL) && ((r = new_ring()) == NULL)) return;
+
+  head = r->head;
+  tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= LOG_RING_SIZE) {
+    __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  rec = &r->rec[head & (LOG_RING_SIZE - 1)];
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  rec->ts = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  rec->fmt = fmt;
+  rec->level = level;
+
+  // Store the raw arguments; the conversions tell their types
+  va_start(ap, fmt);
+  for (p = fmt; *p && (n < LOG_ARGS_MAX); p++) {
+    if (*p != '%') continue;
+    if (*++p == '\0') break;
+    if (*p == '%') continue;
+
+    p += strspn(p, "-+ #0123456789.");
+    long_arg = false;
+    while (*p == 'l') {
+      long_arg = true;
+      p++;
+    }
+
+    switch (*p) {
+      case 's':
+        rec->args[n++] = (uintptr_t)va_arg(ap, const char *);
+        break;
+      case 'd':
+      case 'i':
+        rec->args[n++] = long_arg ? (uint64_t)va_arg(ap, long) : (uint64_t)va_arg(ap, int);
+        break;
+      case 'u':
+      case 'x':
+      case 'c':
+        rec->args[n++] = long_arg ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+        break;
+      default:
+        p--;
+        break;
+    }
+  }
+  va_end(ap);
+
+  __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/// @brief format a record into a '\n'-terminated line
+/// @param out output buffer
+/// @param size size of @a out
+/// @param rec record
+/// @retval length of the line; at most @a size - 1
+static size_t format_record(char *out, size_t size, const LogRecord *rec)
+{
+  char spec[16];
+  const char *p, *start;
+  size_t len = 0, slen;
+  bool long_arg;
+  int n = 0, ret;
+
+  for (p = rec->fmt; *p && (len + 1 < size); p++) {
+    if ((*p != '%') || (p[1] == '%')) {
+      out[len++] = *p;
+      if (*p == '%') p++;
+      continue;
+    }
+
+    start = p++;
+    p += strspn(p, "-+ #0123456789.");
+    long_arg = false;
+    while (*p == 'l') {
+      long_arg = true;
+      p++;
+    }
+    slen = p - start + 1;
+    if ((slen >= sizeof(spec)) || !strchr("diuxcs", *p) || (*p == '\0') || (n == LOG_ARGS_MAX)) {
+      p--;
+      continue;
+    }
+    memcpy(spec, start, slen);
+    spec[slen] = '\0';
+
+    switch (*p) {
+      case 's':
+        ret = snprintf(out + len, size - len, spec, (const char *)(uintptr_t)rec->args[n]);
+        break;
+      case 'd':
+      case 'i':
+        ret = long_arg ? snprintf(out + len, size - len, spec, (long)rec->args[n])
+                       : snprintf(out + len, size - len, spec, (int)rec->args[n]);
+        break;
+      default:
+        ret = long_arg ? snprintf(out + len, size - len, spec, (unsigned long)rec->args[n])
+                       : snprintf(out + len, size - len, spec, (unsigned int)rec->args[n]);
+        break;
+    }
+    n++;
+    if (ret > 0) len += ((size_t)ret < size - len) ? (size_t)ret : size - len - 1;
+  }
+
+  out[len++] = '\n';
+  return len;
+}
+
+/// @brief write all of @a len bytes of @a buf to the log output
+/// @param buf data
+/// @param len length of @a buf
+static void write_out(const char *buf, size_t len)
+{
+  ssize_t ret;
+
+  while (len > 0) {
+    ret = write(log_fd, buf, len);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    buf += ret;
+    len -= ret;
+  }
+}
+
+/// @brief compare two records by their timestamp
+static int compare_records(const void *a, const void *b)
+{
+  const LogRecord *ra = (const LogRecord *)a, *rb = (const LogRecord *)b;
+
+  return (ra->ts > rb->ts) - (ra->ts < rb->ts);
+}
+
+/// @brief collect the pending records of all rings, release rings of exited threads, and write
+///        the records in timestamp order with as few writes as possible
+static void drain_rings(void)
+{
+  static char out[LOG_BATCH_SIZE];
+  LogRing **it, *r;
+  uint64_t head, tail, dropped, new_drops = 0;
+  size_t count = 0, len = 0, i;
+  int dead;
+
+  pthread_mutex_lock(&rings_lock);
+  it = &rings;
+  while ((r = *it) != NULL) {
+    dead = __atomic_load_n(&r->dead, __ATOMIC_ACQUIRE);
+    head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    tail = r->tail;
+
+    if (count + (head - tail) > batch_cap) {
+      batch_cap = (count + (head - tail)) * 2;
+      batch = (LogRecord *)realloc(batch, batch_cap * sizeof(LogRecord));
+    }
+    for (; tail != head; tail++) batch[count++] = r->rec[tail & (LOG_RING_SIZE - 1)];
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+
+    dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+    new_drops += dropped - r->reported;
+    r->reported = dropped;
+
+    if (dead) {
+      *it = r->next;
+      free(r);
+    } else {
+      it = &r->next;
+    }
+  }
+  pthread_mutex_unlock(&rings_lock);
+
+  if (count > 1) qsort(batch, count, sizeof(LogRecord), compare_records);
+
+  for (i = 0; i < count; i++) {
+    if (len + 256 > sizeof(out)) {
+      write_out(out, len);
+      len = 0;
+    }
+    len += format_record(out + len, sizeof(out) - len, &batch[i]);
+  }
+  if (new_drops > 0) {
+    __atomic_add_fetch(&total_dropped, new_drops, __ATOMIC_RELAXED);
+    if (len + 64 > sizeof(out)) {
+      write_out(out, len);
+      len = 0;
+    }
+    len += snprintf(out + len, sizeof(out) - len, "log: %lu record(s) dropped\n",
+                    (unsigned long)new_drops);
+  }
+  if (len > 0) write_out(out, len);
+}
+
+/// @brief drainer thread: periodically write pending records
+static void* log_task(void *dummy)
+{
+  struct timespec period = { 0, LOG_FLUSH_MS * 1000000L };
+
+  while (!drainer_stop) {
+    nanosleep(&period, NULL);
+    drain_rings();
+  }
+  drain_rings();
+
+  return NULL;
+}
+
+void log_init(int fd)
+{
+  log_fd = fd;
+
+  // Output of stdio must not appear after records written later
+  fflush(stdout);
+
+  if (pthread_create(&drainer, NULL, log_task, NULL) == 0) drainer_running = true;
+}
+
+void log_close(void)
+{
+  if (log_closed) return;
+  log_closed = 1;
+
+  if (drainer_running) {
+    drainer_stop = 1;
+    pthread_join(drainer, NULL);
+    drainer_running = false;
+  }
+}
+
+void log_set_level(int level)
+{
+  if (level < LOG_ERROR) level = LOG_ERROR;
+  if (level >= LOG_LEVEL_MAX) level = LOG_LEVEL_MAX - 1;
+  log_level = level;
+}
+
+int log_parse_level(const char *name)
+{
+  int i;
+
+  for (i = 0; i < LOG_LEVEL_MAX; i++) {
+    if (strcasecmp(name, log_level_names[i]) == 0) return i;
+  }
+
+  return -1;
+}
+
+uint64_t log_dropped(void)
+{
+  return __atomic_load_n(&total_dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  log.h
+/// @brief Asynchronous logging through per-thread ring buffers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab names of menu items may be logged
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <stdint.h>
+
+/// @name Macro definitions
+/// @{
+
+#define LOG_RING_SIZE 256                                 ///< records per thread (power of two)
+#define LOG_ARGS_MAX 4                                    ///< max. arguments per record
+#define LOG_FLUSH_MS 10                                   ///< drainer period
+#define LOG_BATCH_SIZE 65536                              ///< output buffer of the drainer
+
+/// @}
+
+/// @brief log levels. A record is kept if its level is at most the current log level.
+enum log_level {
+  LOG_ERROR,
+  LOG_WARN,
+  LOG_INFO,
+  LOG_DEBUG,
+  LOG_LEVEL_MAX
+};
+
+extern const char *log_level_names[];                     ///< log levels as strings
+extern volatile int log_level;                            ///< current log level
+
+/// @brief log a message if @a level is enabled. Costs a single compare if it is not.
+///
+/// The message is not formatted by the caller: @a fmt and up to LOG_ARGS_MAX arguments are stored
+/// in a ring buffer of the calling thread and formatted by the drainer thread later. Therefore
+/// @a fmt and all string arguments must stay valid for the lifetime of the program (string
+/// literals, menu item names, ...). Supported conversions are d, i, u, x, c, s with optional flags,
+/// width and the l modifier. If the ring of the thread is full the record is dropped and counted.
+#define log_msg(level, ...)                                                                       \
+  do {                                                                                            \
+    if (__builtin_expect((level) <= log_level, 0)) log_write((level), __VA_ARGS__);               \
+  } while (0)
+
+#define log_error(...) log_msg(LOG_ERROR, __VA_ARGS__)      ///< log an error
+#define log_warn(...)  log_msg(LOG_WARN, __VA_ARGS__)       ///< log a warning
+#define log_info(...)  log_msg(LOG_INFO, __VA_ARGS__)       ///< log an informational message
+#define log_debug(...) log_msg(LOG_DEBUG, __VA_ARGS__)      ///< log a debug message
+
+/// @brief start the drainer thread writing formatted records to @a fd
+/// @param fd output file descriptor
+void log_init(int fd);
+
+/// @brief write all pending records and stop the drainer thread. Further records are dropped.
+void log_close(void);
+
+/// @brief store a record in the ring of the calling thread. Use log_msg() instead.
+/// @param level log level
+/// @param fmt printf-like format string
+void log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/// @brief set the log level
+/// @param level new log level; clamped to the valid range
+void log_set_level(int level);
+
+/// @brief map a log level name to its log level
+/// @param name log level name
+/// @retval log level or -1 if the name is unknown
+int log_parse_level(const char *name);
+
+/// @brief number of records dropped because a ring was full
+/// @retval number of dropped records
+uint64_t log_dropped(void);
+
+#endif // __LOG_H__
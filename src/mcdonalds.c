@@ -11,6 +11,33 @@
 /// 2020/11/18 Hyunik Kim created
 /// 2021/11/23 Jaume Mateu Cuadrat cleanup, add milestones
 /// 2024/05/31 ARC lab add multiple orders per request
+/// 2026/10/19 ARC lab stream large requests into the kitchen
+/// 2026/10/19 ARC lab optionally stream burgers to the customer as they are made
+/// 2026/10/19 ARC lab zero-downtime restart, drain customers on shutdown
+/// 2026/10/19 ARC lab asynchronous logging
+/// 2026/10/19 ARC lab deadlines for slow or stalled customers
+/// 2026/10/19 ARC lab cancel orders of customers who left
+/// 2026/10/19 ARC lab topology-aware thread placement
+/// 2026/10/19 ARC lab optional io_uring I/O backend
+/// 2026/10/19 ARC lab listen on a Unix domain socket, too
+/// 2026/10/19 ARC lab journal for crash recovery
+/// 2026/10/19 ARC lab publish live statistics in shared memory
+/// 2026/10/19 ARC lab configurable port for franchise backends
+/// 2026/10/19 ARC lab deadline-aware requests
+/// 2026/10/19 ARC lab optional pipelined kitchen
+/// 2026/10/19 ARC lab elastic kitchen pool
+/// 2026/10/19 ARC lab lobby for idle customers and pooled receive buffers
+/// 2026/10/19 ARC lab menu loaded at startup
+/// 2026/10/19 ARC lab record a trace of the requests
+/// 2026/10/19 ARC lab static tracepoints and thread names for profiling
+/// 2026/10/19 ARC lab per-client rate limit at the accept path
+/// 2026/10/19 ARC lab configurable backlog, TCP Fast Open and deferred accept
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+/// 2026/10/19 ARC lab idempotency keys: retries collect the burgers of a lost request
+/// 2026/10/19 ARC lab customers who order while all seats are taken wait for one
+/// 2026/10/19 ARC lab lobby no larger than the limit on open files
+/// 2026/10/19 ARC lab admit a request with a deadline as a whole
+/// 2026/10/19 ARC lab a retry in flight waits on the seat of the request owning its key
 ///
 /// @section license_section License
 /// Copyright (c) 2020-2023, Computer Systems and Platforms Laboratory, SNU
@@ -45,47 +72,81 @@
 #include <signal.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
 
 #include "net.h"
 #include "burger.h"
+#include "order.h"
+#include "log.h"
+#include "timer.h"
+#include "topo.h"
+#include "journal.h"
+#include "stats.h"
+#include "pipeline.h"
+#include "lobby.h"
+#include "menu.h"
+#include "pool.h"
+#include "trace.h"
+#include "probe.h"
+#include "ratelimit.h"
+#include "idem.h"
+#include "lockprof.h"
 
 /// @name Structures
 /// @{
 
-/// @brief general node element to implement a singly-linked list
-typedef struct __node {
-  struct __node *next;                                      ///< pointer to next node
-  unsigned int customerID;                                  ///< customer ID that requested
-  enum burger_type type;                                    ///< requested burger type
-  pthread_cond_t *cond;                                     ///< conditional variable
-  pthread_mutex_t *cond_mutex;                              ///< mutex variable for conditional variable
-  char **order_str;                                         ///< pointer of string to be made by kitchen
-  unsigned int *remain_count;                               ///< number of remaining burgers
-  //
-  // TODO: Add more variables if needed
-  //
-  bool *finished;
-} Node;
-
-/// @brief order data
-typedef struct __order_list {
-  Node *head;                                               ///< head of order list
-  Node *tail;                                               ///< tail of order list
-  unsigned int count;                                       ///< number of nodes in list
-} OrderList;
+/// @brief state of a kitchen slot
+enum kitchen_state {
+  KITCHEN_FREE,                                             ///< no thread
+  KITCHEN_RUNNING,                                          ///< thread is running
+  KITCHEN_EXITED                                            ///< thread was dismissed, to be joined
+};
 
 /// @brief structure for server context
 struct mcdonalds_ctx {
   unsigned int total_customers;                             ///< number of customers served
-  unsigned int total_burgers[BURGER_TYPE_MAX];              ///< number of burgers produced by types
+  unsigned int total_burgers[MENU_MAX];                     ///< number of burgers produced by types
   unsigned int total_queueing;                              ///< number of customers in queue
-  OrderList list;                                           ///< starting point of list structure
+  unsigned int total_waiting;                               ///< customers in the lobby or for a seat
+  unsigned int total_seatless;                              ///< retries on the seat of their key's owner
+  Conn *seat_first;                                         ///< first customer waiting for a seat
+  Conn *seat_last;                                          ///< last customer waiting for a seat
+  unsigned int total_walkouts;                              ///< customers who left without ordering
+  unsigned int total_timeouts;                              ///< number of customers timed out
+  unsigned int total_skipped;                               ///< burgers not made for customers who left
+  unsigned int total_remote;                                ///< orders made on another NUMA node
+  unsigned int total_stolen;                                ///< orders taken from another pool
+  unsigned int total_recovered;                             ///< requests restored from the journal
+  unsigned int total_rejected;                              ///< requests whose deadline can't be met
+  unsigned int total_deadline_hits;                         ///< requests served by their deadline
+  unsigned int total_deadline_misses;                       ///< requests served after their deadline
+  unsigned int kitchens;                                    ///< running kitchen threads
+  unsigned int kitchens_peak;                               ///< max. running kitchen threads
+  uint64_t kitchen_ns;                                      ///< time kitchens ran until kitchens_since
+  uint64_t kitchens_since;                                  ///< last change of kitchens
+  unsigned int total_scale_ups;                             ///< times the scaler added kitchens
+  unsigned int total_scale_downs;                           ///< times the scaler dismissed kitchens
+  uint64_t total_orders;                                    ///< orders handed to the kitchen
+  uint64_t cooking_since[KITCHEN_MAX];                      ///< start of each kitchen's burger (0: idle)
+  uint64_t busy_ns;                                         ///< time kitchens spent on made burgers
+  uint64_t latency_hist[STATS_BUCKETS];                     ///< durations of finished requests
+  uint64_t latency_count;                                   ///< number of finished requests
+  uint64_t latency_sum_us;                                  ///< total duration of finished requests
+  uint64_t latency_max_us;                                  ///< longest finished request
+  OrderList *lists[TOPO_NODE_MAX];                          ///< order list of every kitchen pool
+  unsigned int nlists;                                      ///< number of kitchen pools
   pthread_mutex_t lock;                                     ///< lock variable for server context
+  pthread_cond_t drained;                                   ///< signals that all customers left
 };
 
 /// @}
@@ -93,433 +154,1662 @@ struct mcdonalds_ctx {
 /// @name Global variables
 /// @{
 
-int listenfd;                                               ///< listen file descriptor
+int listenfd = -1;                                          ///< listen file descriptor
+unsigned short port = PORT;                                 ///< TCP port of the server
+int unixfd = -1;                                            ///< listening Unix domain socket
+int handoff_fd = -1;                                        ///< listening socket for handoff
+int wake_pipe[2];                                           ///< wakes up main thread on SIGINT, SIGHUP
 struct mcdonalds_ctx server_ctx;                            ///< keeps server context
-sig_atomic_t keep_running = 1;                              ///< keeps all the threads running
-pthread_t kitchen_thread[NUM_KITCHEN];                      ///< thread for kitchen
-pthread_mutex_t kitchen_mutex;                              ///< shared mutex for kitchen threads
+volatile sig_atomic_t keep_running = 1;                     ///< keeps accepting customers
+volatile sig_atomic_t reload_limits = 0;                    ///< re-read the limits file
+pthread_t kitchen_thread[KITCHEN_MAX];                      ///< thread for kitchen
+unsigned int kitchen_pool[KITCHEN_MAX];                     ///< kitchen pool of every kitchen
+enum kitchen_state kitchen_state[KITCHEN_MAX];              ///< state of every kitchen slot
+pthread_mutex_t kitchen_mutex;                              ///< protects kitchen slots and scaler
+pthread_cond_t scale_cond;                                  ///< wakes up the scaler to stop
+pthread_t scale_thread;                                     ///< kitchen scaler
+bool scale_stop = false;                                    ///< scaler stops
+unsigned int kitchens_min = NUM_KITCHEN;                    ///< min. kitchens of the elastic pool
+unsigned int kitchens_max = NUM_KITCHEN;                    ///< max. kitchens of the elastic pool
+unsigned int lobby_max = LOBBY_MAX;                         ///< max. customers in the lobby (0: none)
+char *handoff_path = HANDOFF_PATH;                          ///< path of the handoff socket
+char *unix_path = UNIX_PATH;                                ///< path of unixfd ("": none)
+bool takeover = false;                                      ///< take over a running server
+unsigned int read_timeout = READ_TIMEOUT_MS;                ///< max. wait for request data (ms)
+unsigned int write_timeout = WRITE_TIMEOUT_MS;              ///< max. wait to send a response (ms)
+unsigned int request_timeout = REQUEST_TIMEOUT_MS;          ///< max. duration of a request (ms)
+enum placement placement = PLACE_NONE;                      ///< thread placement policy
+char topology[512];                                         ///< description of the topology
+int io_backend = NET_POSIX;                                 ///< requested I/O backend
+char *journal_dir = NULL;                                   ///< journal directory (NULL: none)
+char *stats_name = STATS_NAME;                              ///< shared memory of statistics ("": none)
+char *menu_path = NULL;                                     ///< menu file (NULL: built-in menu)
+char *trace_path = NULL;                                    ///< trace of the requests (NULL: none)
+char *limits_path = NULL;                                   ///< rate limits file (NULL: none)
+int backlog = LISTEN_BACKLOG;                               ///< backlog of the listening sockets
+int fastopen = LISTEN_FASTOPEN;                             ///< TCP Fast Open queue (0: off)
+int defer_accept = 0;                                       ///< seconds to wait for data (0: off)
+unsigned int idem_keys = IDEM_KEYS;                         ///< max. idempotency keys (0: none)
+unsigned int idem_ttl = IDEM_TTL_MS;                        ///< time results of keys are kept (ms)
+bool pipelined = false;                                     ///< pipelined kitchen instead of kitchens
 
 /// @}
 
 
-/// @brief Enqueue elements in tail of the OrderList
-/// @param customerID customer ID
-/// @param types list of burger types
-/// @param burger_count number of burgers
-/// @retval Node** of issued order Nodes
-Node** issue_orders(unsigned int customerID, enum burger_type *types, unsigned int burger_count)
-{
-  // List of node pointers that are to be issued
-  Node **node_list = (Node **)malloc(sizeof(Node *) * burger_count);
-
-  // Initialize order string for request
-  char **order_str = (char **)malloc(sizeof(char *));
-  *order_str = NULL;
-
-  // Initialize conditon variable and mutex for request
-  pthread_cond_t *cond = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
-  pthread_mutex_t *cond_mutex = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
-  pthread_cond_init(cond, NULL);
-  pthread_mutex_init(cond_mutex, NULL);
-
-  // Initialize remaining count
-  unsigned int *remain_count = (unsigned int*)malloc(sizeof(unsigned int));
-  *remain_count = burger_count;
-
-  //
-  // TODO: Initialize shared Node variables if added any
-  //
-  bool *finish = (bool*)malloc(sizeof(bool));
-  *finish = false;
-
-  for (int i=0; i<burger_count; i++){
-    // Create new Node
-    Node *new_node = malloc(sizeof(Node));
-
-    // Initialize Node variables
-    new_node->customerID = customerID;
-    new_node->type = types[i];
-    new_node->next = NULL;
-    new_node->remain_count = remain_count;
-    new_node->order_str = order_str;
-    new_node->cond = cond;
-    new_node->cond_mutex = cond_mutex;
-
-    //
-    // TODO: Initialize other Node variables if added any
-    //
-    new_node->finished = finish;
-
-    // Add Node to list
-    pthread_mutex_lock(&server_ctx.lock);
-    if (server_ctx.list.tail == NULL) {
-      server_ctx.list.head = new_node;
-      server_ctx.list.tail = new_node;
-    } else {
-      server_ctx.list.tail->next = new_node;
-      server_ctx.list.tail = new_node;
+/// @brief current time
+/// @retval nanoseconds on CLOCK_MONOTONIC
+uint64_t monotonic_ns(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/// @brief get the next order for a kitchen. With a single pool, wait for the next order. Kitchens
+///        of per-node pools take the orders of their own node first and, when they run out,
+///        steal orders of other nodes every STEAL_MS while idle.
+/// @param pool kitchen pool of the kitchen
+/// @param stolen set if the order comes from another pool. Out parameter.
+/// @retval Node* next order
+/// @retval NULL if the restaurant closes
+Node* next_order(unsigned int pool, bool *stolen)
+{
+  OrderList *own = server_ctx.lists[pool];
+  Node *order;
+  bool closed;
+  unsigned int i;
+
+  *stolen = false;
+  if (server_ctx.nlists == 1) return wait_order(own);
+
+  while (1) {
+    if ((order = get_order(own)) != NULL) return order;
+
+    for (i = 1; i < server_ctx.nlists; i++) {
+      order = get_order(server_ctx.lists[(pool + i) % server_ctx.nlists]);
+      if (order != NULL) {
+        *stolen = true;
+        return order;
+      }
     }
-    server_ctx.list.count++;
-    pthread_mutex_unlock(&server_ctx.lock);
 
-    // Add new node to node list
-    node_list[i] = new_node;
+    if ((order = wait_order_for(own, STEAL_MS, &closed)) != NULL) return order;
+    if (closed) return NULL;
   }
-
-  // Return node list
-  return node_list;
 }
 
-/// @brief Dequeue element from the OrderList
-/// @retval Node* Node from head of the list
-Node* get_order(void)
+/// @brief account for an order that was made or skipped, and release it
+/// @param order order
+/// @param skip the order was dropped because its request was cancelled
+/// @param stolen the order was taken from another kitchen pool
+/// @param cooked time spent making the burger (ns)
+/// @param kitchen kitchen that made it; -1 for the pipelined kitchen
+void finish_order(Node *order, bool skip, bool stolen, uint64_t cooked, int kitchen)
 {
-  Node *target_node;
+  Request *req = order->req;
+  enum burger_type type = order->type;
+  unsigned int customerID = order->customerID;
+  bool orphaned, remote = false;
+  pthread_t tid = pthread_self();
 
-  if (server_ctx.list.head == NULL) return NULL;
+  if (!skip) {
+    journal_append(JOURNAL_BURGER, customerID, type, 1);
+    remote = (topo_nodes() > 1) && (topo_current_node() != req->node);
+  }
+  free(order);
+
+  // Reduce `remain_count` of request. Fire signal to serving thread if every burger is made,
+  // or if it waits for the kitchen to catch up with a large request.
+  // The serving thread may release the request as soon as we unlock; do not touch it after.
+  // If the serving thread has left already, the last order releases the request.
+  pthread_mutex_lock(&req->cond_mutex);
+  req->remain_count--;
+  orphaned = req->orphaned && (req->remain_count == 0);
+  if (req->complete && (req->remain_count == 0)) {
+    if (!req->cancelled) log_info("[Thread %lu] all orders done for customer %u", tid, customerID);
+    wake_request(req);
+  } else if (req->throttled && (req->remain_count <= REQUEST_WINDOW / 2)) {
+    wake_request(req);
+  }
+  pthread_mutex_unlock(&req->cond_mutex);
 
+  if (orphaned) {
+    if (req->recovered) journal_append(JOURNAL_DONE, customerID, 0, 0);
+    free_request(req);
+  }
+
+  // Increase burger count
   pthread_mutex_lock(&server_ctx.lock);
+  if (skip) server_ctx.total_skipped++;
+  else server_ctx.total_burgers[type]++;
+  if (!skip && remote) server_ctx.total_remote++;
+  if (stolen) server_ctx.total_stolen++;
+  server_ctx.busy_ns += cooked;
+  if (kitchen >= 0) __atomic_store_n(&server_ctx.cooking_since[kitchen], 0, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&server_ctx.lock);
+}
 
-  target_node = server_ctx.list.head;
+/// @brief completion function of the pipelined kitchen. Its stations keep their own busy time.
+/// @param order order
+/// @param skip the order was dropped because its request was cancelled
+void pipeline_done(Node *order, bool skip)
+{
+  finish_order(order, skip, false, 0, -1);
+}
 
-  if (server_ctx.list.head == server_ctx.list.tail) {
-    server_ctx.list.head = NULL;
-    server_ctx.list.tail = NULL;
-  } else {
-    server_ctx.list.head = server_ctx.list.head->next;
+/// @brief change the number of running kitchens and account the time they ran. Must be called
+///        with kitchen_mutex held.
+/// @param delta kitchens started (> 0) or exited (< 0)
+void count_kitchens(int delta)
+{
+  uint64_t now = monotonic_ns();
+
+  server_ctx.kitchen_ns += server_ctx.kitchens * (now - server_ctx.kitchens_since);
+  server_ctx.kitchens_since = now;
+  __atomic_store_n(&server_ctx.kitchens, server_ctx.kitchens + delta, __ATOMIC_RELAXED);
+  if (server_ctx.kitchens > server_ctx.kitchens_peak) {
+    server_ctx.kitchens_peak = server_ctx.kitchens;
   }
+}
+
+/// @brief Kitchen task for kitchen thread
+/// @param arg kitchen number as uintptr_t
+void* kitchen_task(void *arg)
+{
+  Node *order;
+  Request *req;
+  enum burger_type type;
+  unsigned int customerID, kitchen = (uintptr_t)arg, pool = kitchen_pool[kitchen];
+  bool skip, stolen;
+  uint64_t cooked;
+  pthread_t tid = pthread_self();
 
-  server_ctx.list.count--;
+  pthread_setname_np(pthread_self(), "mcd-kitchen");
+  log_debug("[Thread %lu] Kitchen thread ready", tid);
 
-  pthread_mutex_unlock(&server_ctx.lock);
+  // Keep dequeuing until the restaurant closes; wait while no order is available
+  while ((order = next_order(pool, &stolen)) != NULL) {
+    req = order->req;
+    type = order->type;
+    customerID = order->customerID;
+
+    // Don't cook for a customer who left; the order is just dropped
+    skip = __atomic_load_n(&req->cancelled, __ATOMIC_ACQUIRE);
+    cooked = 0;
+    if (skip) {
+      log_debug("[Thread %lu] skipping %s burger for customer %u", tid, menu->item[type].name, customerID);
+    } else {
+      log_debug("[Thread %lu] generating %s burger for customer %u", tid, menu->item[type].name, customerID);
+      cooked = monotonic_ns();
+      __atomic_store_n(&server_ctx.cooking_since[kitchen], cooked, __ATOMIC_RELAXED);
+      PROBE3(cook_start, customerID, type, kitchen);
+      make_burger(order);
+      cooked = monotonic_ns() - cooked;
+      PROBE3(cook_end, customerID, type, kitchen);
+      log_debug("[Thread %lu] %s burger for customer %u is ready", tid, menu->item[type].name, customerID);
+    }
+    finish_order(order, skip, stolen, cooked, kitchen);
+  }
+
+  // Closed, or dismissed by the scaler; the slot is joined when it is reused or at exit
+  pthread_mutex_lock(&kitchen_mutex);
+  kitchen_state[kitchen] = KITCHEN_EXITED;
+  count_kitchens(-1);
+  pthread_mutex_unlock(&kitchen_mutex);
+
+  log_debug("[Thread %lu] terminated", tid);
+  pthread_exit(NULL);
+}
+
+/// @brief start a kitchen thread in a free slot. Must be called with kitchen_mutex held.
+/// @retval 0 on success
+/// @retval -1 if no slot is free or the thread cannot be created
+int start_kitchen(void)
+{
+  pthread_attr_t attr;
+  unsigned int i;
+  int err;
+
+  for (i = 0; i < kitchens_max; i++) {
+    if (kitchen_state[i] != KITCHEN_RUNNING) break;
+  }
+  if (i == kitchens_max) return -1;
+  if (kitchen_state[i] == KITCHEN_EXITED) pthread_join(kitchen_thread[i], NULL);
+  kitchen_state[i] = KITCHEN_FREE;
+
+  pthread_attr_init(&attr);
+  kitchen_pool[i] = topo_place(&attr, placement, i);
+  err = pthread_create(&kitchen_thread[i], &attr, kitchen_task, (void *)(uintptr_t)i);
+  pthread_attr_destroy(&attr);
+  if (err) {
+    errno = err;
+    return -1;
+  }
+
+  kitchen_state[i] = KITCHEN_RUNNING;
+  count_kitchens(1);
+  return 0;
+}
+
+/// @brief kitchen scaler of the elastic pool. Every SCALE_MS, it sizes the pool for the arrival
+///        rate of orders plus working off the queued ones within SCALE_DRAIN_MS, but never below
+///        the kitchens cooking right now. It adds kitchens right away. It sends idle kitchens home
+///        only if the pool stayed over 125% of its size for SCALE_COOLDOWN_MS, and at most half
+///        of them at a time, so that it does not flap.
+/// @param dummy unused
+void* scale_task(void *dummy)
+{
+  struct timespec until;
+  uint64_t now, last = monotonic_ns(), orders, last_orders = 0, oversized = 0;
+  double rate = 0, needed;
+  unsigned int queued, busy, running, target, keep, n, i;
+
+  pthread_mutex_lock(&kitchen_mutex);
+  while (!scale_stop) {
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += SCALE_MS * 1000000L;
+    if (until.tv_nsec >= 1000000000L) {
+      until.tv_sec++;
+      until.tv_nsec -= 1000000000L;
+    }
+    pthread_cond_timedwait(&scale_cond, &kitchen_mutex, &until);
+    if (scale_stop) break;
+
+    // Arrival rate, smoothed over a few intervals
+    now = monotonic_ns();
+    orders = __atomic_load_n(&server_ctx.total_orders, __ATOMIC_RELAXED);
+    rate = (rate + (orders - last_orders) * 1e9 / (now - last)) / 2;
+    last = now;
+    last_orders = orders;
+
+    queued = 0;
+    for (i = 0; i < server_ctx.nlists; i++) queued += order_left(server_ctx.lists[i]);
+    busy = 0;
+    for (i = 0; i < kitchens_max; i++) {
+      if (__atomic_load_n(&server_ctx.cooking_since[i], __ATOMIC_RELAXED)) busy++;
+    }
+    running = server_ctx.kitchens;
+
+    needed = rate * menu->mean_ms / 1000 + (double)queued * menu->mean_ms / SCALE_DRAIN_MS;
+    target = kitchens_max;
+    if (needed < kitchens_max) target = (unsigned int)needed + (needed > (unsigned int)needed);
+    if (target < busy) target = busy;
+    if (target < kitchens_min) target = kitchens_min;
+
+    if (target > running) {
+      // Busy: cancel pending dismissals and add kitchens now
+      for (i = 0; i < server_ctx.nlists; i++) dismiss_waiters(server_ctx.lists[i], 0);
+      for (n = running; n < target; n++) {
+        if (start_kitchen() < 0) {
+          perror("kitchen");
+          break;
+        }
+      }
+      log_info("Kitchens: %u -> %u (%u queued, %u orders/s)", running, server_ctx.kitchens,
+               queued, (unsigned int)rate);
+      pthread_mutex_lock(&server_ctx.lock);
+      server_ctx.total_scale_ups++;
+      pthread_mutex_unlock(&server_ctx.lock);
+      oversized = 0;
+    } else if ((target + target / 4 < running) && (busy < running)) {
+      if (oversized == 0) oversized = now;
+      if (now - oversized < SCALE_COOLDOWN_MS * 1000000ULL) continue;
+
+      keep = (running + 1) / 2;
+      if (keep < target) keep = target;
+      n = running - keep;
+      for (i = 0; i < server_ctx.nlists; i++) {
+        dismiss_waiters(server_ctx.lists[i], n / server_ctx.nlists + (i < n % server_ctx.nlists));
+      }
+      log_info("Kitchens: %u -> %u (%u queued, %u orders/s)", running, keep, queued,
+               (unsigned int)rate);
+      pthread_mutex_lock(&server_ctx.lock);
+      server_ctx.total_scale_downs++;
+      pthread_mutex_unlock(&server_ctx.lock);
+      oversized = now;
+    } else {
+      oversized = 0;
+    }
+  }
+  pthread_mutex_unlock(&kitchen_mutex);
 
-  return target_node;
+  return NULL;
 }
 
-/// @brief Returns number of element left in OrderList
-/// @retval number of element(s) in OrderList
-unsigned int order_left(void)
+/// @brief cancel a request: nobody collects its burgers anymore. Kitchens drop its remaining
+///        orders, and the serving thread stops waiting for them. Must be called with the
+///        cond_mutex of the request held.
+/// @param req request
+void cancel_request(Request *req)
 {
+  req->lost = true;
+  if (!req->cancelled) {
+    __atomic_store_n(&req->cancelled, true, __ATOMIC_RELEASE);
+    wake_request(req);
+  }
+}
+
+/// @brief the connection to the customer of a request is lost. A request that owns its
+///        idempotency key is made to the end, so that a retry collects the burgers; others are
+///        cancelled. Must be called with the cond_mutex of the request held.
+/// @param req request
+void lose_customer(Request *req)
+{
+  if (req->keyed && !req->expired) req->lost = true;
+  else cancel_request(req);
+}
+
+/// @brief wait for the kitchen to make progress on a request. Must be called with the
+///        cond_mutex of the request held. While waiting, the socket is watched so that a
+///        customer who hangs up is noticed right away and the request is cancelled.
+/// @param req request
+void wait_kitchen(Request *req)
+{
+  struct pollfd pfd[2];
+  uint64_t count;
   int ret;
 
-  pthread_mutex_lock(&server_ctx.lock);
-  ret = server_ctx.list.count;
-  pthread_mutex_unlock(&server_ctx.lock);
+  if (!req->lost && (req->wake_fd < 0)) req->wake_fd = eventfd(0, EFD_CLOEXEC);
+  if (req->lost || (req->wake_fd < 0)) {
+    pthread_cond_wait(&req->cond, &req->cond_mutex);
+    return;
+  }
 
-  return ret;
+  // Kitchens write to wake_fd instead of only signalling the condition while we poll
+  req->polling = true;
+  pthread_mutex_unlock(&req->cond_mutex);
+
+  pfd[0].fd = req->clientfd;
+  pfd[0].events = POLLRDHUP;
+  pfd[1].fd = req->wake_fd;
+  pfd[1].events = POLLIN;
+  ret = poll(pfd, 2, -1);
+  if ((ret > 0) && (pfd[1].revents & POLLIN) && (read(req->wake_fd, &count, sizeof(count)) < 0)) {}
+
+  pthread_mutex_lock(&req->cond_mutex);
+  req->polling = false;
+  if ((ret > 0) && (pfd[0].revents & (POLLRDHUP | POLLHUP | POLLERR)) && !req->cancelled) {
+    // The protocol never half-closes; the customer is gone
+    if (!req->expired) {
+      log_info(req->keyed ? "Customer #%u left, making %u order(s) for a retry" :
+                            "Customer #%u left, cancelling %u order(s)",
+               req->customerID, req->remain_count);
+    }
+    lose_customer(req);
+  }
 }
 
-/// @brief "cook" burger by appending burger name to order_str of Node
-/// @param order Order Node
-void make_burger(Node *order)
+/// @brief send made burgers of a streamed request to the customer. Must be called with the
+///        cond_mutex of the request held; the mutex is released while sending.
+/// @param req request
+void send_ready(Request *req)
 {
-  // == DO NOT MODIFY ==
-  enum burger_type type = order->type;
-  char *temp;
+  char *ready = req->ready_str;
+  size_t len = req->ready_len;
+  bool lost = req->lost;
+  int sent = 1;
 
-  if(*(order->order_str) != NULL){
-    // If string is initialized, append burger name to order_string
+  if (len == 0) return;
 
-    // Copy original string to temp buffer
-    int ret = asprintf(&temp, "%s", *(order->order_str));
-    if(ret < 0) perror("asprintf");
-    free(*(order->order_str));
+  req->ready_str = NULL;
+  req->ready_len = req->ready_cap = 0;
+  pthread_mutex_unlock(&req->cond_mutex);
 
-    // Append burger name to order_str
-    ret = asprintf(order->order_str, "%s %s", temp, burger_names[type]);
-    if(ret < 0) perror("asprintf");
-    free(temp);
+  if (!lost) {
+    timer_arm(&req->io_timer, write_timeout);
+    sent = put_data(req->clientfd, ready, len);
+    timer_arm(&req->io_timer, 0);
   }
-  else{
-    // If string is not initialized, copy burger name to order string
-    int str_len = strlen(burger_names[type]);
-    *(order->order_str) = (char *)malloc(sizeof(char) * str_len);
-    strncpy(*(order->order_str), burger_names[type], str_len);
+  free(ready);
+
+  pthread_mutex_lock(&req->cond_mutex);
+  if (sent <= 0) {
+    if (!req->expired) log_error("Error: cannot send data to client");
+    lose_customer(req);
   }
+}
+
+/// @brief record orders of a request in the journal, one record per burger type
+/// @param req request
+/// @param types list of burger types
+/// @param burger_count number of burgers
+void journal_orders(Request *req, enum burger_type *types, unsigned int burger_count)
+{
+  unsigned int count[MENU_MAX] = { 0 };
+  unsigned int i;
 
-  sleep(1);
-  // ===================
+  if (!journal_enabled()) return;
+
+  for (i = 0; i < burger_count; i++) count[types[i]]++;
+  for (i = 0; i < menu->items; i++) {
+    if (count[i] > 0) req->journal_lsn = journal_append(JOURNAL_ORDER, req->customerID, i, count[i]);
+  }
 }
 
-/// @brief Kitchen task for kitchen thread
-void* kitchen_task(void *dummy)
+/// @brief estimate whether the kitchen can make more orders of a request by its deadline. Under
+///        EDF, only queued orders with an earlier or equal deadline are made first; the kitchens
+///        of the pool make kitchens_max / nlists of them per round of the mean cook time of the
+///        menu, as an elastic pool grows within SCALE_MS when orders queue up. Unless idle
+///        kitchens take all of them right away, burgers in the making delay the first round by up
+///        to the longest cook time.
+/// @param req request with a deadline
+/// @param burger_count number of burgers to add
+/// @retval true if the burgers are expected to be ready in time
+bool meets_deadline(Request *req, unsigned int burger_count)
 {
-  Node *order;
-  enum burger_type type;
-  unsigned int customerID;
-  pthread_t tid = pthread_self();
+  OrderList *list = server_ctx.lists[req->node % server_ctx.nlists];
+  unsigned int kitchens = kitchens_max / server_ctx.nlists, idle;
+  uint64_t orders, ms;
 
-  printf("[Thread %lu] Kitchen thread ready\n", tid);
+  if (kitchens == 0) kitchens = 1;
+  orders = orders_before(list, req->deadline_ns, &idle) + burger_count;
+  ms = (orders + kitchens - 1) / kitchens * menu->mean_ms + ((orders > idle) ? menu->max_ms : 0);
 
-  while (keep_running || order_left()) {
-    // Keep dequeuing if possible
-    order = get_order();
+  return monotonic_ns() + ms * 1000000ULL <= req->deadline_ns;
+}
+
+/// @brief hand orders of a request to the kitchen. Blocks while too many orders of the request
+///        are still waiting in the queue so that a large request cannot flood the kitchen.
+///        Orders of a cancelled request are dropped.
+/// @param req request
+/// @param types list of burger types
+/// @param burger_count number of burgers
+void hand_to_kitchen(Request *req, enum burger_type *types, unsigned int burger_count)
+{
+  pthread_mutex_lock(&req->cond_mutex);
+  while (req->remain_count + burger_count > REQUEST_WINDOW) {
+    req->throttled = true;
+    if (req->cancelled) break;
+    if (req->stream && (req->ready_len > 0)) send_ready(req);
+    else wait_kitchen(req);
+  }
+  req->throttled = false;
+  if (req->cancelled) {
+    // Don't cook for a customer who is gone
+    pthread_mutex_unlock(&req->cond_mutex);
+    return;
+  }
+  pthread_mutex_unlock(&req->cond_mutex);
 
-    // If no order is available, sleep and try again
-    if (order == NULL) {
-      sleep(2);
+  journal_orders(req, types, burger_count);
+  issue_orders(server_ctx.lists[req->node % server_ctx.nlists], req, types, burger_count);
+  __atomic_add_fetch(&server_ctx.total_orders, burger_count, __ATOMIC_RELAXED);
+}
+
+/// @brief mark all orders of a request issued and wait until the kitchen made every burger or
+///        the request is cancelled. Burgers of a streamed request are sent while waiting.
+/// @param req request
+void wait_request(Request *req)
+{
+  struct timespec until;
+
+  pthread_mutex_lock(&req->cond_mutex);
+  req->complete = true;
+  while ((req->remain_count > 0) && !req->cancelled) {
+    if (req->stream && (req->ready_len > 0)) {
+      // Give burgers that are made close together a moment to go out in a single write
+      clock_gettime(CLOCK_REALTIME, &until);
+      until.tv_nsec += COALESCE_MS * 1000000L;
+      if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+      }
+      while ((req->remain_count > 0) && !req->cancelled &&
+             (pthread_cond_timedwait(&req->cond, &req->cond_mutex, &until) != ETIMEDOUT));
+      send_ready(req);
       continue;
     }
+    wait_kitchen(req);
+  }
+  if (req->stream) send_ready(req);
+  pthread_mutex_unlock(&req->cond_mutex);
+}
 
-    type = order->type;
-    customerID = order->customerID;
-    printf("[Thread %lu] generating %s burger for customer %u\n", tid, burger_names[type], customerID);
+void start_serving(Conn *c);
 
-    // Make burger and reduce `remain_count` of request
-    // - Use make_burger()
-    // - Reduce `remain_count` by one
-    // TODO
+/// @brief account for a customer leaving. The seat goes to the customer who has waited longest
+///        with an order from the lobby. Wakes up the main thread once the last customer of a
+///        closing restaurant is gone.
+void customer_left(void)
+{
+  Conn *c;
 
-    pthread_mutex_lock(order->cond_mutex);
-    make_burger(order);
-    *(order->remain_count) -= 1;
-    pthread_mutex_unlock(order->cond_mutex);
+  pthread_mutex_lock(&server_ctx.lock);
+  if ((c = server_ctx.seat_first) != NULL) {
+    if ((server_ctx.seat_first = c->next) == NULL) server_ctx.seat_last = NULL;
+    server_ctx.total_waiting--;
+    pthread_mutex_unlock(&server_ctx.lock);
+    start_serving(c);
+    return;
+  }
+  if (--server_ctx.total_queueing + server_ctx.total_waiting + server_ctx.total_seatless == 0) {
+    pthread_cond_broadcast(&server_ctx.drained);
+  }
+  pthread_mutex_unlock(&server_ctx.lock);
+}
 
-    printf("[Thread %lu] %s burger for customer %u is ready\n", tid, burger_names[type], customerID);
+/// @brief give up the seat of a retry that waits on the seat of the request owning its key. The
+///        retry still counts until it leaves, so that a closing restaurant answers it.
+void give_up_seat(void)
+{
+  pthread_mutex_lock(&server_ctx.lock);
+  server_ctx.total_seatless++;
+  pthread_mutex_unlock(&server_ctx.lock);
+  customer_left();
+}
 
-    // If every burger is made, fire signal to serving thread
-    if(*(order->remain_count) == 0 && !*(order->finished)){
-      printf("[Thread %lu] all orders done for customer %u\n", tid, customerID);
-      *(order->finished) = true;
-      pthread_cond_signal(order->cond);
-    }
+/// @brief account for a retry leaving that gave up its seat
+void seatless_left(void)
+{
+  pthread_mutex_lock(&server_ctx.lock);
+  if (server_ctx.total_queueing + server_ctx.total_waiting + --server_ctx.total_seatless == 0) {
+    pthread_cond_broadcast(&server_ctx.drained);
+  }
+  pthread_mutex_unlock(&server_ctx.lock);
+}
 
-    // Increase burger count
-    pthread_mutex_lock(&server_ctx.lock);
-    server_ctx.total_burgers[type]++;
-    pthread_mutex_unlock(&server_ctx.lock);
+/// @brief timer expiry function: a deadline of a request expired. Shuts down the connection,
+///        which fails any receive or send the serving thread is blocked in, and cancels the
+///        request.
+/// @param t expired timer
+void expire_request(Timer *t)
+{
+  Request *req = (Request *)t->data;
+
+  pthread_mutex_lock(&req->cond_mutex);
+  if (!req->expired) {
+    req->expired = true;
+    shutdown(req->clientfd, SHUT_RDWR);
+    cancel_request(req);
   }
+  pthread_mutex_unlock(&req->cond_mutex);
+}
 
-  printf("[Thread %lu] terminated\n", tid);
-  pthread_exit(NULL);
+/// @brief send a line to the customer within the write deadline
+/// @param req request
+/// @param message message
+/// @param len length of message
+/// @retval >0 on success
+/// @retval <=0 on error or expired deadline
+int put_customer(Request *req, char *message, size_t len)
+{
+  int sent;
+
+  timer_arm(&req->io_timer, write_timeout);
+  sent = put_line(req->clientfd, message, len);
+  timer_arm(&req->io_timer, 0);
+
+  return sent;
 }
 
-/// @brief error function for the serve_client
-/// @param clientfd file descriptor of the client*
-/// @param newsock socketid of the client as void*
-/// @param newsock buffer for the messages*
-void error_client(int clientfd, void *newsock,char *buffer) {
-  close(clientfd);
-  free(newsock);
-  free(buffer);
+/// @brief finish a request: stop its deadlines, close the connection and release it. Orders of
+///        a cancelled request may still be queued; the kitchen releases the request then.
+/// @param req request
+void finish_request(Request *req)
+{
+  uint64_t now = monotonic_ns(), us = (now - req->arrived_ns) / 1000;
+
+  // After cancelling the timers, no expiry function can touch the socket anymore
+  timer_cancel(&req->io_timer);
+  timer_cancel(&req->deadline);
+
+  if (req->expired) log_warn("Customer #%u timed out", req->customerID);
 
   pthread_mutex_lock(&server_ctx.lock);
-  server_ctx.total_queueing--;
+  if (req->expired) server_ctx.total_timeouts++;
+  if (req->deadline_ns && req->complete && !req->cancelled) {
+    if (now <= req->deadline_ns) server_ctx.total_deadline_hits++;
+    else server_ctx.total_deadline_misses++;
+  }
+  server_ctx.latency_hist[stats_bucket(us)]++;
+  server_ctx.latency_count++;
+  server_ctx.latency_sum_us += us;
+  if (us > server_ctx.latency_max_us) server_ctx.latency_max_us = us;
   pthread_mutex_unlock(&server_ctx.lock);
+
+  journal_append(JOURNAL_DONE, req->customerID, 0, 0);
+  close(req->clientfd);
+  release_request(req);
+}
+
+/// @brief error function for the serve_client
+/// @param req request of the client
+/// @param c connection of the client
+void error_client(Request *req, Conn *c) {
+  finish_request(req);
+  conn_free(c);
+
+  customer_left();
+}
+
+/// @brief lend a receive buffer for a single read. With io_uring, the thread's registered buffer
+///        is lent; otherwise a buffer of the smallest pool class that holds @a want bytes.
+/// @param want bytes to receive
+/// @param cap size of the buffer. Out parameter.
+/// @retval char* buffer
+/// @retval NULL if out of memory
+char* lend_buffer(size_t want, size_t *cap)
+{
+  if (net_backend() == NET_URING) {
+    *cap = CHUNK_SIZE;
+    return net_alloc_buffer(CHUNK_SIZE);
+  }
+  return pool_alloc(want, cap);
+}
+
+/// @brief return a buffer lent by lend_buffer()
+/// @param buf buffer
+/// @param cap size of the buffer
+void return_buffer(char *buf, size_t cap)
+{
+  if (net_backend() == NET_URING) net_free_buffer(buf);
+  else pool_free(buf, cap);
+}
+
+/// @brief record a finished request in the trace
+/// @param req request
+/// @param mix burgers ordered, per burger type
+/// @param rejected the deadline of the request could not be met
+/// @param invalid the request was invalid
+void trace_customer(Request *req, const unsigned int *mix, bool rejected, bool invalid)
+{
+  TraceRecord r;
+  struct sockaddr_storage sa;
+  socklen_t len = sizeof(sa);
+  uint64_t us = (monotonic_ns() - req->arrived_ns) / 1000;
+
+  memset(&r, 0, sizeof(r));
+  r.customerID = req->customerID;
+  r.latency_us = (us < UINT32_MAX) ? us : UINT32_MAX;
+  if (req->deadline_ns) r.deadline_ms = (req->deadline_ns - req->arrived_ns) / 1000000;
+  if (req->stream) r.flags |= TRACE_STREAM;
+  if ((getsockname(req->clientfd, (struct sockaddr *)&sa, &len) == 0) && (sa.ss_family == AF_UNIX)) {
+    r.flags |= TRACE_UNIX;
+  }
+
+  pthread_mutex_lock(&req->cond_mutex);
+  if (rejected) r.outcome = TRACE_REJECTED;
+  else if (invalid) r.outcome = TRACE_INVALID;
+  else if (req->expired) r.outcome = TRACE_TIMEOUT;
+  else if (req->cancelled || req->lost) r.outcome = TRACE_LEFT;
+  else r.outcome = TRACE_SERVED;
+  pthread_mutex_unlock(&req->cond_mutex);
+
+  trace_request(&r, req->arrived_ns, mix);
+}
+
+/// @brief wait for the request that owns the idempotency key of a retry and format its burgers as
+///        the reply. A streamed retry gets all of them at once. Gives up when the customer hangs
+///        up or the visit deadline expires.
+/// @param req retry
+/// @param message reply (NULL: the customer left). Out parameter.
+/// @param unseated the retry gave up its seat to wait on the seat of the owner. Out parameter.
+/// @retval >0 length of the reply
+/// @retval 0 if the customer left
+/// @retval -1 on error
+int retry_reply(Request *req, char **message, bool *unseated)
+{
+  char *burgers, *name, *save;
+  unsigned int count;
+  int len = 0;
+
+  *message = NULL;
+  switch (idem_wait(req->key, req->clientfd, give_up_seat, unseated, &burgers, &count)) {
+    case -1:
+      log_info("Customer #%u left before the burgers for the key were made", req->customerID);
+      return 0;
+    case 0:
+      log_info("Customer #%u: no burgers for the key, order again", req->customerID);
+      return asprintf(message, "Sorry, your order could not be made. Please order again. Goodbye!\n");
+  }
+  log_info("Customer #%u: %u burger(s) collected with the key", req->customerID, count);
+
+  if (!req->stream) {
+    len = asprintf(message, "Your order(%s) is ready! Goodbye!\n", burgers);
+    free(burgers);
+    return len;
+  }
+
+  if ((*message = (char *)malloc(strlen(burgers) + 8 * count + 64)) == NULL) {
+    free(burgers);
+    return -1;
+  }
+  for (name = strtok_r(burgers, " ", &save); name; name = strtok_r(NULL, " ", &save)) {
+    len += sprintf(*message + len, "ready: %s\n", name);
+  }
+  len += sprintf(*message + len, "Your order of %u burger(s) is complete! Goodbye!\n", count);
+  free(burgers);
+  return len;
 }
 
 /// @brief client task for client thread
-/// @param newsock socketID of the client as void*
-void* serve_client(void *newsock)
+/// @param conn connection of the client as Conn*
+void* serve_client(void *conn)
 {
+  Conn *c = (Conn *)conn;         // connection of the client
   ssize_t read, sent;             // size of read and sent message
-  size_t msglen;                  // message buffer size
   char *message, *buffer;         // message buffers
-  char *burger;                   // parsed burger string
   unsigned int customerID;        // customer ID
-  enum burger_type *types;        // list of burger types
-  Node **order_list = NULL;       // list of orders issued
-  int ret, i, clientfd;           // misc. values
-  unsigned int burger_count = 0;  // number of burgers in request
-  Node *first_order;              // first order of requests
+  int ret, clientfd;              // misc. values
+  size_t pos;                     // parse position in buffer
+  size_t want = 1 << POOL_MIN_SHIFT; // size of the next receive buffer
+  size_t cap;                     // size of the lent receive buffer
+  Parser parser;                  // request parser
+  enum parse_result res;          // result of parsing a piece of the request
+  bool done = false;              // received the end of the request
+  bool error = false;             // received an invalid request or lost the connection
+  bool rejected = false;          // the deadline of the request cannot be met
+  bool invalid = false;           // received an invalid request
+  bool tracing = trace_enabled(); // record the request in the trace
+  bool claimed = false;           // looked up the idempotency key of the request
+  bool made;                      // all burgers of the request were made
+  bool unseated = false;          // the retry gave up its seat to wait on the owner's
+  enum idem_claim claim = IDEM_NONE; // role of the request for its idempotency key
+  unsigned int mix[MENU_MAX];     // burgers ordered per type, for the trace
+  enum burger_type *held = NULL, *grown; // orders of a request with a deadline, until admitted
+  unsigned int held_count = 0, held_cap = 0, i;
+  Request *req;                   // request of the customer
+  char sorry[] = "Sorry, your order cannot be ready in time. Goodbye!\n";
+
+  clientfd = c->fd;
+  customerID = c->id;
+  pthread_setname_np(pthread_self(), "mcd-serve");
+
+  // Start the deadlines of the customer
+  // - the whole visit must end within request_timeout
+  // - every receive must get data within read_timeout, every send complete within write_timeout
+  // An expired deadline shuts down the connection and cancels the request.
+  req = new_request(customerID, clientfd);
+  req->node = topo_current_node();
+  req->arrived_ns = monotonic_ns();
+  journal_append(JOURNAL_REQUEST, customerID, 0, 0);
+  timer_setup(&req->io_timer, expire_request, req);
+  timer_setup(&req->deadline, expire_request, req);
+  timer_arm(&req->deadline, request_timeout);
+
+  // A customer from the lobby got its welcome already and has data waiting. Otherwise, send
+  // welcome to mcdonalds and receive the first piece of the request in one go.
+  // Receive buffers are lent for one read only; a customer waiting for burgers holds none.
+  // They start small, since most requests are a short line, and grow while reads fill them.
+  if ((buffer = lend_buffer(want, &cap)) == NULL) {
+    perror("lend_buffer");
+    error_client(req, c);
+    return NULL;
+  }
+  timer_arm(&req->io_timer, read_timeout);
+  if (c->welcomed) {
+    read = get_some(clientfd, buffer, cap);
+  } else {
+    ret = asprintf(&message, "Welcome to McDonald's, customer #%d\n", customerID);
+    if (ret < 0) {
+      perror("asprintf");
+      return_buffer(buffer, cap);
+      error_client(req, c);
+      return NULL;
+    }
+    read = put_get(clientfd, message, ret, buffer, cap);
+    free(message);
+  }
+  timer_arm(&req->io_timer, 0);
+
+  // Receive the request and parse it while it streams in
+  // - The request is a single '\n'-terminated line of arbitrary length. It is consumed in chunks
+  //   of CHUNK_SIZE bytes; the parser carries a burger name split across two chunks over.
+  // - Parsed orders are handed to the kitchen every ORDER_CHUNK burgers and whenever the
+  //   received data is used up, so the kitchen starts cooking while the upload continues.
+  // - If a burger is not an available type, exit connection
+  init_parser(&parser, req);
+  if (tracing) memset(mix, 0, sizeof(mix));
+
+  while (!done && !error) {
+    if (read <= 0) {
+      error = true;
+      break;
+    }
+    if (((size_t)read == cap) && (want < CHUNK_SIZE)) want <<= 1;
+
+    pos = 0;
+    do {
+      res = parse_request(&parser, buffer, read, &pos);
+      if (res == PARSE_ERROR) break;
+
+      // The key comes with the options, before the first burger
+      if (req->key[0] && !claimed) {
+        claimed = true;
+        claim = idem_claim(req->key);
+        req->keyed = (claim == IDEM_OWNER);
+      }
 
-  clientfd = *(int *) newsock;
-  buffer = (char *) malloc(BUF_SIZE);
-  msglen = BUF_SIZE;
+      if (parser.count > 0) {
+        PROBE2(parse, customerID, parser.count);
+        if (tracing) {
+          for (unsigned int i = 0; i < parser.count; i++) mix[parser.types[i]]++;
+        }
+        // A retry collects the burgers of the request that owns its key instead.
+        // A request with a deadline is admitted as a whole, before any of its burgers is cooked:
+        // its orders are held until the request is complete, and it is rejected as soon as the
+        // orders so far cannot be ready in time.
+        if (claim == IDEM_RETRY) {
+        } else if (req->deadline_ns) {
+          if (held_count + parser.count > held_cap) {
+            held_cap = held_cap ? 2 * held_cap : 4 * ORDER_CHUNK;
+            if ((grown = (enum burger_type *)realloc(held, held_cap * sizeof(*held))) == NULL) {
+              perror("realloc");
+              error = true;
+              break;
+            }
+            held = grown;
+          }
+          memcpy(held + held_count, parser.types, parser.count * sizeof(*held));
+          held_count += parser.count;
+          if (!meets_deadline(req, held_count)) {
+            rejected = true;
+            break;
+          }
+        } else {
+          hand_to_kitchen(req, parser.types, parser.count);
+        }
+        parser.count = 0;
+      }
+    } while (res == PARSE_CHUNK);
+
+    if (rejected) {
+      log_info("Customer #%u: order cannot be ready by the deadline, rejected", customerID);
+      error = true;
+    } else if (res == PARSE_ERROR) {
+      log_error("Error: unknown burger type or invalid option");
+      error = true;
+      invalid = true;
+    } else if (res == PARSE_DONE) {
+      done = true;
+    }
 
-  // Get customer ID
-  pthread_mutex_lock(&server_ctx.lock);
-  customerID = server_ctx.total_customers++;
-  pthread_mutex_unlock(&server_ctx.lock);
+    return_buffer(buffer, cap);
+    buffer = NULL;
 
-  printf("Customer #%d visited\n", customerID);
+    if (req->stream) {
+      pthread_mutex_lock(&req->cond_mutex);
+      send_ready(req);
+      pthread_mutex_unlock(&req->cond_mutex);
+    }
 
-  // Generate welcome message
-  ret = asprintf(&message, "Welcome to McDonald's, customer #%d\n", customerID);
-  if (ret < 0) {
-    perror("asprintf");
-    return NULL;
+    if (!done && !error) {
+      if ((buffer = lend_buffer(want, &cap)) == NULL) {
+        perror("lend_buffer");
+        read = -1;
+        continue;
+      }
+      timer_arm(&req->io_timer, read_timeout);
+      read = get_some(clientfd, buffer, cap);
+      timer_arm(&req->io_timer, 0);
+    }
   }
+  if (buffer) return_buffer(buffer, cap);
 
-  // Send welcome to mcdonalds
-  sent = put_line(clientfd, message, ret);
-  if (sent < 0) {
-    printf("Error: cannot send data to client\n");
-    error_client(clientfd, newsock, buffer);
-    return NULL;
+  // The request with a deadline is admitted; cook it
+  if (!error) {
+    for (i = 0; i < held_count; i += ORDER_CHUNK) {
+      hand_to_kitchen(req, held + i, (held_count - i < ORDER_CHUNK) ? held_count - i : ORDER_CHUNK);
+    }
   }
-  free(message);
-
-  // Receive request from the customer
-  // TODO
+  free(held);
 
-  ret = get_line(clientfd, &buffer, &msglen);
-  if (ret <= 0) {
-      error_client(clientfd, newsock, buffer);
-      return NULL;
+  // Don't keep a customer with an invalid request waiting, and don't cook for it
+  if (error) {
+    if (rejected) {
+      pthread_mutex_lock(&server_ctx.lock);
+      server_ctx.total_rejected++;
+      pthread_mutex_unlock(&server_ctx.lock);
+      put_customer(req, sorry, sizeof(sorry) - 1);
+    }
+    shutdown(clientfd, SHUT_RDWR);
+    pthread_mutex_lock(&req->cond_mutex);
+    cancel_request(req);
+    pthread_mutex_unlock(&req->cond_mutex);
   }
 
-  // Parse and split request from the customer into orders
-  // - Fill in `types` variable with each parsed burger type and increase `burger_count`
-  // - While parsing, if burger is not an available type, exit connection
-  // - Tip: try using strtok_r() with while statement
-  // TODO
+  // The orders are accepted once they are in the journal
+  if (!error) journal_sync(req->journal_lsn);
+
+  // Wait until every order is made or the customer left
+  wait_request(req);
 
-  char *token;
-  char *rest = buffer;
-  // remove '\0'from buffer
-  char *end = rest + strlen(rest) - 1;
-  while (end > rest && isspace((unsigned char)*end)) {
-    *end = '\0';
-    end--;
+  // Keep the burgers for retries before replying, so that a failed reply loses nothing
+  if (claim == IDEM_OWNER) {
+    pthread_mutex_lock(&req->cond_mutex);
+    made = !error && !req->cancelled;
+    pthread_mutex_unlock(&req->cond_mutex);
+    if (made) idem_complete(req->key, req->order_str ? req->order_str : "", req->total_count);
+    else idem_abandon(req->key);
   }
 
-  types = (enum burger_type*)malloc(sizeof(enum burger_type) * MAX_BURGERS);
+  // If request is successfully handled, hand ordered burgers and say goodbye
+  // Streamed requests have received their burgers already and get a summary instead
+  if (!error && !req->lost) {
+    if (claim == IDEM_RETRY)
+      ret = retry_reply(req, &message, &unseated);
+    else if (req->stream)
+      ret = asprintf(&message, "Your order of %u burger(s) is complete! Goodbye!\n",
+                     req->total_count);
+    else
+      ret = asprintf(&message, "Your order(%s) is ready! Goodbye!\n",
+                     req->order_str ? req->order_str : "");
+    if (ret < 0) perror("asprintf");
+    else if (ret > 0) {
+      sent = put_customer(req, message, ret);
+      free(message);
+      if ((sent <= 0) && !req->expired) log_error("Error: cannot send data to client");
+    }
+  }
 
-  while ((token = strtok_r(rest, " ", &rest))) {
-    if (burger_count >= MAX_BURGERS) break;
-    enum burger_type type = BURGER_TYPE_MAX;
+  PROBE3(reply, customerID, req->total_count, error);
+  if (tracing) trace_customer(req, mix, rejected, invalid);
+  finish_request(req);
+  conn_free(c);
 
-    if (strcmp(token, "bigmac") == 0) type = BURGER_BIGMAC;
-    else if (strcmp(token, "cheese") == 0) type = BURGER_CHEESE;
-    else if (strcmp(token, "chicken") == 0) type = BURGER_CHICKEN;
-    else if (strcmp(token, "bulgogi") == 0) type = BURGER_BULGOGI;
+  if (unseated) seatless_left();
+  else customer_left();
 
-    if (type == BURGER_TYPE_MAX) {
-        printf("Error: unknown burger type\n");
-        error_client(clientfd, newsock, buffer);
-        return NULL;
-    }
+  return NULL;
+}
+
+/// @brief take over the listening socket of a running server through the handoff socket. The
+///        old server stops accepting customers and releases the handoff socket before it closes
+///        the connection.
+/// @retval 0 on success
+/// @retval -1 if no server could be taken over
+int take_over(void)
+{
+  struct sockaddr_un sa;
+  int fd, n, fds[2];
+  char c;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strncpy(sa.sun_path, handoff_path, sizeof(sa.sun_path) - 1);
 
-    types[burger_count] = type;
-    burger_count += 1;
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+
+  if ((connect(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) || ((n = recv_fds(fd, fds, 2)) < 1)) {
+    close(fd);
+    return -1;
   }
 
-  // Issue orders to kitchen and wait
-  // - Tip: use pthread_cond_wait() to wait
-  // - Tip2: use issue_orders() to issue request
-  // - Tip3: all orders in a request share the same `cond` and `cond_mutex`,
-  //         so access such variables through the first order
-  // TODO
+  // Wait for old server to let go of the handoff socket
+  while (get_some(fd, &c, 1) > 0);
+  close(fd);
 
-  // If request is successfully handled, hand ordered burgers and say goodbye
-  // All orders share the same `remain_count`, so access it through the first orders  
+  listenfd = fds[0];
+  if (n > 1) unixfd = fds[1];
+  return 0;
+}
 
-  order_list = issue_orders(customerID, types, burger_count);
-  first_order = order_list[0];
+/// @brief open the handoff socket through which a new server can take over the listening socket
+void open_handoff(void)
+{
+  struct sockaddr_un sa;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sun_family = AF_UNIX;
+  strncpy(sa.sun_path, handoff_path, sizeof(sa.sun_path) - 1);
 
-  while (*(first_order->remain_count) > 0) {
-    pthread_cond_wait(first_order->cond, first_order->cond_mutex);
+  handoff_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (handoff_fd < 0) {
+    perror("socket");
+    return;
   }
 
-  if (*(first_order->remain_count) == 0) {
-    ret = asprintf(&message, "Your order(%s) is ready! Goodbye!\n", *(first_order->order_str));
-    sent = put_line(clientfd, message, ret);
-    if (sent <= 0) {
-      printf("Error: cannot send data to client\n");
-      error_client(clientfd, newsock, buffer);
-      return NULL;
-    }
+  unlink(handoff_path);
+  if ((bind(handoff_fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) || (listen(handoff_fd, 1) < 0)) {
+    perror("handoff socket");
+    close(handoff_fd);
+    handoff_fd = -1;
   }
-  
-  pthread_cond_destroy(first_order->cond);
-  pthread_mutex_destroy(first_order->cond_mutex);
+}
 
-  // If any, free unused variables
-  // TODO
+/// @brief hand the listening socket over to a new server connecting to the handoff socket
+/// @retval 0 on success
+/// @retval -1 on error; keep serving customers
+int hand_over(void)
+{
+  int fd = accept(handoff_fd, NULL, NULL);
+  int fds[2] = { listenfd, unixfd };
 
-  //free(order_list);
+  if (fd < 0) return -1;
 
-  close(clientfd);
-  free(newsock);
-  free(buffer);
+  if (send_fds(fd, fds, (unixfd >= 0) ? 2 : 1) < 0) {
+    close(fd);
+    return -1;
+  }
 
-  pthread_mutex_lock(&server_ctx.lock);
-  server_ctx.total_queueing--;
-  pthread_mutex_unlock(&server_ctx.lock);
+  // Release the handoff socket for the new server, then tell it we are done
+  close(handoff_fd);
+  handoff_fd = -1;
+  unlink(handoff_path);
+  close(fd);
 
-  return NULL;
+  return 0;
 }
 
-/// @brief start server listening
-void start_server()
+/// @brief open a listening socket
+/// @param host path of the socket for AF_UNIX, NULL otherwise
+/// @param port port for AF_INET
+/// @param family AF_INET or AF_UNIX
+/// @retval listening socket
+/// @retval -1 on error
+int open_listener(const char *host, unsigned short port, int family)
 {
-  int clientfd, addrlen, opt = 1, *newsock;
-  struct sockaddr_in client;
   struct addrinfo *ai, *ai_it;
+  int fd = -1, opt = 1;
 
   // Get socket list by using getsocklist()
-  // TODO
+  ai = getsocklist(host, port, family, SOCK_STREAM, 1, NULL);
 
-  ai = getsocklist(NULL, PORT, AF_INET, SOCK_STREAM, 1, NULL);
+  // A server that got killed leaves its Unix domain socket behind. We own the TCP port, so no
+  // other server uses it.
+  if (family == AF_UNIX) unlink(host);
 
   // Iterate over addrinfos and try to bind & listen
-  // TODO
-
-  printf("Listening...\n");
-
   ai_it = ai;
   while (ai_it != NULL) {
     //dump_sockaddr(ai_it->ai_addr);
-    listenfd = socket(ai_it->ai_family, ai_it->ai_socktype, ai_it->ai_protocol);
+    fd = socket(ai_it->ai_family, ai_it->ai_socktype, ai_it->ai_protocol);
 
-    if(listenfd != -1) {
-      if ((bind(listenfd, ai_it->ai_addr, ai_it->ai_addrlen) == 0) && (listen(listenfd, 32) == 0)) {
+    if(fd != -1) {
+      if (family != AF_UNIX) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+      if ((bind(fd, ai_it->ai_addr, ai_it->ai_addrlen) == 0) &&
+          (listen_socket(fd, backlog, fastopen, defer_accept) == 0)) {
         break;
       }
-      close(listenfd);
+      close(fd);
+      fd = -1;
     }
     ai_it = ai_it->ai_next;
   }
 
-  //freeaddrinfo(ai);
+  freesocklist(ai);
+
+  return fd;
+}
+
+/// @brief start a serve_client thread for a customer counted in total_queueing
+/// @param c connection of the customer
+void start_serving(Conn *c)
+{
+  pthread_t serve_client_tid;
+  pthread_attr_t attr;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, SERVE_STACK);
+  topo_place(&attr, placement, c->id);
+  if (pthread_create(&serve_client_tid, &attr, serve_client, c)) {
+    perror("pthread_create");
+    close(c->fd);
+    conn_free(c);
+    customer_left();
+  } else {
+    pthread_detach(serve_client_tid);
+  }
+  pthread_attr_destroy(&attr);
+}
+
+/// @brief lobby function: a customer left the lobby. Serve it if it sent data and the restaurant
+///        has room. A customer who ordered while all seats are taken waits for the next free
+///        seat, first come, first served; it still counts as waiting.
+/// @param c connection of the customer
+/// @param ready data arrived; otherwise the customer hung up or timed out, and c->fd is closed
+void leave_lobby(Conn *c, bool ready)
+{
+  bool serve = false;
+
+  pthread_mutex_lock(&server_ctx.lock);
+  if (ready && (server_ctx.total_queueing >= CUSTOMER_MAX)) {
+    c->next = NULL;
+    if (server_ctx.seat_last) server_ctx.seat_last->next = c;
+    else server_ctx.seat_first = c;
+    server_ctx.seat_last = c;
+    pthread_mutex_unlock(&server_ctx.lock);
+    log_debug("Customer #%u waits for a seat", c->id);
+    return;
+  }
+  server_ctx.total_waiting--;
+  if (!ready) {
+    server_ctx.total_walkouts++;
+    if (c->state == CONN_EXPIRED) server_ctx.total_timeouts++;
+  } else {
+    server_ctx.total_queueing++;
+    serve = true;
+  }
+  if (server_ctx.total_queueing + server_ctx.total_waiting + server_ctx.total_seatless == 0) {
+    pthread_cond_broadcast(&server_ctx.drained);
+  }
+  pthread_mutex_unlock(&server_ctx.lock);
+
+  if (serve) {
+    start_serving(c);
+    return;
+  }
+
+  if (c->state == CONN_EXPIRED) {
+    log_warn("Customer #%u timed out in the lobby", c->id);
+  } else {
+    log_info("Customer #%u left without ordering", c->id);
+  }
+  conn_free(c);
+}
+
+/// @brief admit an accepted customer. With a lobby, the customer gets its welcome and waits
+///        there without a thread until it sends its order. Otherwise, create a serve_client
+///        thread unless the restaurant is full.
+/// @param clientfd socket of the customer
+void admit_customer(int clientfd)
+{
+  char welcome[64];
+  static const char busy[] = "Sorry, you are visiting too often. Goodbye!\n";
+  unsigned int customerID;
+  bool lobby = lobby_max > 0;
+  Conn *c;
+  int len, ret;
+
+  // Turn away a client over its rate limit before it costs a connection, thread or buffer
+  if (!rate_admit(clientfd)) {
+    if (send(clientfd, busy, sizeof(busy) - 1, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {}
+    close(clientfd);
+    log_debug("Connection refused: client over its rate limit");
+    return;
+  }
+
+  if ((c = conn_new(clientfd, 0)) == NULL) {
+    perror("conn_new");
+    close(clientfd);
+    return;
+  }
+
+  pthread_mutex_lock(&server_ctx.lock);
+  if ((lobby && (server_ctx.total_waiting >= lobby_max)) ||
+      (!lobby && (server_ctx.total_queueing >= CUSTOMER_MAX))) {
+    pthread_mutex_unlock(&server_ctx.lock);
+    close(clientfd);
+    conn_free(c);
+    log_warn("Maximum number of customers reached. Connection refused.");
+    return;
+  }
+  if (lobby) server_ctx.total_waiting++;
+  else server_ctx.total_queueing++;
+  customerID = c->id = server_ctx.total_customers++;
+  pthread_mutex_unlock(&server_ctx.lock);
+  PROBE2(accept, customerID, clientfd);
+
+  log_info("Customer #%u visited", customerID);
+
+  if (!lobby) {
+    start_serving(c);
+    return;
+  }
+
+  // A fresh socket has room for the welcome. If it has not, the serving thread sends it.
+  len = snprintf(welcome, sizeof(welcome), "Welcome to McDonald's, customer #%u\n", customerID);
+  ret = send(clientfd, welcome, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+  c->welcomed = (ret == len);
+  if ((ret >= 0) && (ret < len)) {
+    close(clientfd);
+    c->fd = -1;
+    leave_lobby(c, false);
+  } else if (!c->welcomed || (lobby_enter(c) < 0)) {
+    // No room in the lobby: serve right away
+    leave_lobby(c, true);
+  }
+}
+
+/// @brief gather function of the statistics publisher; runs on its own thread
+/// @param s snapshot. Out parameter.
+/// @param data unused
+void gather_statistics(StatsSnapshot *s, void *data)
+{
+  static LockStats locks[STATS_LOCKS];
+  IdemStats is;
+  JournalStats js;
+  PoolStats ps;
+  RateStats rs;
+  uint64_t now, since;
+  int i;
+
+  pthread_mutex_lock(&kitchen_mutex);
+  s->kitchens = server_ctx.kitchens;
+  s->kitchens_peak = server_ctx.kitchens_peak;
+  s->kitchen_ns = server_ctx.kitchen_ns +
+                  server_ctx.kitchens * (monotonic_ns() - server_ctx.kitchens_since);
+  pthread_mutex_unlock(&kitchen_mutex);
+
+  // Burgers in the making count toward the busy time, too; a finished burger moves from its
+  // kitchen's cooking_since to busy_ns under the lock
+  pthread_mutex_lock(&server_ctx.lock);
+  now = monotonic_ns();
+  for (i = 0; i < kitchens_max; i++) {
+    since = __atomic_load_n(&server_ctx.cooking_since[i], __ATOMIC_RELAXED);
+    if ((since == 0) || (since > now)) continue;
+    s->kitchens_busy++;
+    s->busy_ns += now - since;
+  }
+  s->customers = server_ctx.total_customers;
+  s->queueing = server_ctx.total_queueing;
+  s->waiting = server_ctx.total_waiting;
+  s->walkouts = server_ctx.total_walkouts;
+  s->timeouts = server_ctx.total_timeouts;
+  s->skipped = server_ctx.total_skipped;
+  s->remote = server_ctx.total_remote;
+  s->stolen = server_ctx.total_stolen;
+  s->recovered = server_ctx.total_recovered;
+  s->rejected = server_ctx.total_rejected;
+  s->deadline_hits = server_ctx.total_deadline_hits;
+  s->deadline_misses = server_ctx.total_deadline_misses;
+  s->scale_ups = server_ctx.total_scale_ups;
+  s->scale_downs = server_ctx.total_scale_downs;
+  for (i = 0; i < menu->items; i++) s->burgers[i] = server_ctx.total_burgers[i];
+  s->busy_ns += server_ctx.busy_ns;
+  memcpy(s->latency_hist, server_ctx.latency_hist, sizeof(s->latency_hist));
+  s->latency_count = server_ctx.latency_count;
+  s->latency_sum_us = server_ctx.latency_sum_us;
+  s->latency_max_us = server_ctx.latency_max_us;
+  pthread_mutex_unlock(&server_ctx.lock);
 
-  // Keep listening and accepting clients
+  for (i = 0; i < server_ctx.nlists; i++) s->queued += order_left(server_ctx.lists[i]);
+  s->kitchens_min = kitchens_min;
+  s->kitchens_max = kitchens_max;
+  s->orders = __atomic_load_n(&server_ctx.total_orders, __ATOMIC_RELAXED);
+
+  // The stations of the pipelined kitchen keep their busy time per stage
+  if (pipelined) {
+    StationStats st[MENU_STATIONS];
+    int j;
+
+    pipeline_stats(st);
+    for (i = 0; i < menu->stations; i++) {
+      s->station_lanes[i] = st[i].lanes;
+      s->station_backlog[i] = st[i].backlog;
+      s->station_lane_ns[i] = st[i].lane_ns;
+      for (j = 0; j < STAGE_MAX; j++) {
+        s->station_busy_ns[i][j] = st[i].busy_ns[j];
+        s->busy_ns += st[i].busy_ns[j];
+      }
+    }
+  }
+
+  journal_stats(&js);
+  s->journal_records = js.records;
+  s->journal_commits = js.commits;
+  s->journal_sync_ns = js.sync_ns;
+  s->log_dropped = log_dropped();
+
+  pool_stats(&ps);
+  s->conns = conn_count();
+  s->pool_bytes = ps.bytes;
+  s->pool_used = ps.used;
+
+  rate_stats(&rs);
+  s->rate_limit = rs.rate;
+  s->rate_burst = rs.burst;
+  s->rate_rejected = rs.rejected;
+  s->rate_clients = rs.clients;
+  s->talkers = (rs.ntop < STATS_TALKERS) ? rs.ntop : STATS_TALKERS;
+  for (i = 0; i < s->talkers; i++) {
+    s->talker_family[i] = rs.top[i].client.family;
+    memcpy(s->talker_addr[i], rs.top[i].client.addr, sizeof(s->talker_addr[i]));
+    s->talker_admitted[i] = rs.top[i].admitted;
+    s->talker_rejected[i] = rs.top[i].rejected;
+  }
+
+  idem_stats(&is);
+  s->idem_keys = is.keys;
+  s->idem_inflight = is.inflight;
+  s->idem_hits = is.hits;
+  s->idem_reattached = is.reattached;
+  s->idem_abandoned = is.abandoned;
+  s->idem_evicted = is.evicted;
+
+  // Only a build with LOCKPROF has lock profiles; they come sorted by total wait time
+  s->locks = lockprof_stats(locks, STATS_LOCKS);
+  for (i = 0; i < s->locks; i++) {
+    strncpy((char*)s->lock_name[i], locks[i].name, STATS_LOCK_NAME - 1);
+    s->lock_acquired[i] = locks[i].acquired;
+    s->lock_contended[i] = locks[i].contended;
+    s->lock_wait_ns[i] = locks[i].wait_ns;
+    s->lock_wait_max_ns[i] = locks[i].wait_max_ns;
+    s->lock_hold_ns[i] = locks[i].holds ?
+                         (double)locks[i].hold_ns / locks[i].holds * locks[i].acquired : 0;
+  }
+}
+
+/// @brief name the burgers and stations of the menu for readers of the statistics
+/// @param labels names. Out parameter.
+void label_statistics(StatsLabels *labels)
+{
+  unsigned int i;
+
+  memset(labels, 0, sizeof(*labels));
+  labels->items = menu->items;
+  labels->stations = menu->stations;
+  for (i = 0; i < menu->items; i++) strcpy(labels->item[i], menu->item[i].name);
+  for (i = 0; i < menu->stations; i++) strcpy(labels->station[i], menu->station[i]);
+}
+
+/// @brief log the rate limit of every client
+void log_rate_limit(void)
+{
+  RateStats rs;
+
+  rate_stats(&rs);
+  if (rs.rate == 0) log_info("Rate limit: none");
+  else log_info("Rate limit: %u connection(s)/s per client, burst %u", rs.rate, rs.burst);
+}
+
+/// @brief start server listening
+void start_server()
+{
+  int fds[ACCEPT_BATCH], listenfds[2], watch[2];
+  char drain[64];
+  int i, n, max;
+  unsigned int events;
+  Acceptor *acceptor;
+  bool handed_over = false;
+  StatsLabels labels;
+
+  if (takeover) {
+    if (take_over() == 0) log_info("Took over from running McDonald's at %s", handoff_path);
+    else log_warn("No McDonald's to take over at %s", handoff_path);
+  }
+
+  if (listenfd < 0) {
+    listenfd = open_listener(NULL, port, AF_INET);
+    if (listenfd < 0) {
+      log_error("Error: cannot listen on port %u", port);
+      return;
+    }
+  }
+
+  // A backlog larger than the system allows is cut silently; storms then overflow it
+  max = listen_backlog_max();
+  if ((max > 0) && (max < backlog)) {
+    log_warn("Backlog of %d cut to %d by net.core.somaxconn", backlog, max);
+  }
+
+  // Co-located customers can skip the TCP stack
+  if ((unixfd < 0) && (unix_path[0] != '\0')) {
+    unixfd = open_listener(unix_path, 0, AF_UNIX);
+    if (unixfd < 0) log_warn("Cannot listen on %s", unix_path);
+  }
+
+  open_handoff();
+
+  // Monitors map the counters read-only; publishing costs the serving threads nothing. The name
+  // belongs to the server that owns the listening socket.
+  if (stats_name[0] != '\0') {
+    label_statistics(&labels);
+    if (stats_open(stats_name, &labels, gather_statistics, NULL) < 0) {
+      log_warn("Cannot publish statistics in %s", stats_name);
+    } else {
+      log_info("Statistics: %s", stats_name);
+    }
+  }
+
+  if (unixfd >= 0) log_info("Listening on port %u and %s...", port, unix_path);
+  else log_info("Listening on port %u...", port);
+
+  // Wait for customers on the listening sockets and for SIGINT or a new server on the other fds
+  listenfds[0] = listenfd;
+  listenfds[1] = unixfd;
+  watch[0] = wake_pipe[0];
+  watch[1] = handoff_fd;
+  acceptor = new_acceptor(listenfds, (unixfd >= 0) ? 2 : 1, watch, 2);
+  if (acceptor == NULL) {
+    log_error("Error: cannot accept customers");
+    return;
+  }
+
+  // Keep listening and accepting clients until SIGINT or until a new server takes over
   // Check if max number of customers is not exceeded after accepting
   // Create a serve_client thread for the client
-  // TODO
-
+  // With io_uring, one wakeup may deliver several customers
   while (keep_running) {
-    clientfd = accept(listenfd, (struct sockaddr *)&client, (socklen_t *)&addrlen);
+    n = accept_some(acceptor, fds, ACCEPT_BATCH, &events);
+    if (n < 0) {
+      perror("accept");
+      break;
+    }
 
-    if (clientfd > 0) {
-      if (server_ctx.total_queueing >= CUSTOMER_MAX) {
-        close(clientfd);
-        printf("Maximum number of customers reached. Connection refused.\n");
-        continue;
+    for (i = 0; i < n; i++) admit_customer(fds[i]);
+
+    // SIGHUP: re-read the rate limits
+    if ((events & 1) && reload_limits) {
+      reload_limits = 0;
+      if (read(wake_pipe[0], drain, sizeof(drain)) < 0) {}
+      if (rate_load(limits_path) < 0) log_warn("Cannot read rate limits from %s", limits_path);
+      else log_rate_limit();
+    }
+
+    if (events & 2) {
+      // Customers accepted by the kernel before we stopped are ours; the new server gets the rest
+      while ((n = stop_accepting(acceptor, fds, ACCEPT_BATCH)) > 0) {
+        for (i = 0; i < n; i++) admit_customer(fds[i]);
+      }
+      if (hand_over() == 0) {
+        handed_over = true;
+        break;
       }
+    }
+  }
 
-      pthread_mutex_lock(&server_ctx.lock);
-      server_ctx.total_queueing++;
-      pthread_mutex_unlock(&server_ctx.lock);
+  while ((n = stop_accepting(acceptor, fds, ACCEPT_BATCH)) > 0) {
+    for (i = 0; i < n; i++) admit_customer(fds[i]);
+  }
+  free_acceptor(acceptor);
+
+  if (handed_over) log_info("****** Handed over to new McDonald's, closing ******");
+  else log_info("****** I'm tired, closing McDonald's ******");
+
+  // Stop accepting customers. After a handoff, the new server keeps the listening sockets open.
+  close(listenfd);
+  listenfd = -1;
+  if (unixfd >= 0) {
+    close(unixfd);
+    unixfd = -1;
+    if (!handed_over) unlink(unix_path);
+  }
+  if (handoff_fd >= 0) {
+    close(handoff_fd);
+    handoff_fd = -1;
+    unlink(handoff_path);
+  }
+}
+
+/// @brief restore a request from the journal: its remaining burgers are made for pickup under a
+///        new customer ID. Nobody waits for it; the kitchen releases it when it is done.
+/// @param run run of the server that accepted the request
+/// @param oldID customer ID of the request in that run
+/// @param pending number of burgers still to make, per burger type
+/// @param data unused
+void recover_request(unsigned int run, unsigned int oldID, unsigned int *pending, void *data)
+{
+  enum burger_type types[ORDER_CHUNK];
+  unsigned int customerID, count, total = 0;
+  Request *req;
+  int t;
+
+  pthread_mutex_lock(&server_ctx.lock);
+  customerID = server_ctx.total_customers++;
+  server_ctx.total_recovered++;
+  pthread_mutex_unlock(&server_ctx.lock);
+
+  req = new_request(customerID, -1);
+  req->recovered = true;
+  journal_append(JOURNAL_REQUEST, customerID, 0, 0);
 
-      pthread_t serve_client_tid;
-      int *thread_client_fd = (int*) malloc(sizeof(int));
-      *thread_client_fd = clientfd;
-      pthread_create(&serve_client_tid, NULL, serve_client, (void*)thread_client_fd);
-      pthread_detach(serve_client_tid);
+  for (t = 0; t < MENU_MAX; t++) {
+    if ((t >= menu->items) && (pending[t] > 0)) {
+      log_warn("Cannot restore %u burger(s) of customer #%u (run %u): not on the menu",
+               pending[t], oldID, run);
+      continue;
+    }
+    while (pending[t] > 0) {
+      count = (pending[t] < ORDER_CHUNK) ? pending[t] : ORDER_CHUNK;
+      for (unsigned int i = 0; i < count; i++) types[i] = t;
+      journal_orders(req, types, count);
+      issue_orders(server_ctx.lists[0], req, types, count);
+      pending[t] -= count;
+      total += count;
     }
   }
+
+  log_info("Restored %u burger(s) of customer #%u (run %u) as customer #%u", total, oldID, run,
+           customerID);
+
+  pthread_mutex_lock(&req->cond_mutex);
+  req->complete = true;
+  pthread_mutex_unlock(&req->cond_mutex);
+  release_request(req);
+}
+
+/// @brief serve all customers that are still in the restaurant, then close the kitchen
+void drain_mcdonalds(void)
+{
+  int i;
+
+  stats_draining();
+
+  // Customers in the lobby may still order until their read deadline
+  pthread_mutex_lock(&server_ctx.lock);
+  if (server_ctx.total_queueing + server_ctx.total_waiting > 0) {
+    log_info("Serving %u remaining customer(s), %u waiting to order", server_ctx.total_queueing,
+             server_ctx.total_waiting);
+  }
+  while (server_ctx.total_queueing + server_ctx.total_waiting + server_ctx.total_seatless > 0) {
+    pthread_cond_wait(&server_ctx.drained, &server_ctx.lock);
+  }
+  pthread_mutex_unlock(&server_ctx.lock);
+
+  // Stop the scaler first so that the set of kitchens stays put
+  if (kitchens_min < kitchens_max) {
+    pthread_mutex_lock(&kitchen_mutex);
+    scale_stop = true;
+    pthread_cond_signal(&scale_cond);
+    pthread_mutex_unlock(&kitchen_mutex);
+    pthread_join(scale_thread, NULL);
+  }
+
+  for (i = 0; i < server_ctx.nlists; i++) {
+    close_orders(server_ctx.lists[i]);
+  }
+
+  if (pipelined) {
+    pipeline_join();
+    return;
+  }
+  for (i = 0; i < kitchens_max; i++) {
+    if (kitchen_state[i] != KITCHEN_FREE) pthread_join(kitchen_thread[i], NULL);
+  }
 }
 
 /// @brief prints overall statistics
 void print_statistics(void)
 {
+  unsigned int served;
+  RateStats rs;
+  IdemStats is;
+  char addr[INET6_ADDRSTRLEN];
   int i;
 
   printf("\n====== Statistics ======\n");
   printf("Number of customers visited: %u\n", server_ctx.total_customers);
-  for (i = 0; i < BURGER_TYPE_MAX; i++) {
-    printf("Number of %s burger made: %u\n", burger_names[i], server_ctx.total_burgers[i]);
+  printf("Number of customers timed out: %u\n", server_ctx.total_timeouts);
+  printf("Number of customers who left without ordering: %u\n", server_ctx.total_walkouts);
+  printf("Number of burgers skipped for customers who left: %u\n", server_ctx.total_skipped);
+  if (topo_nodes() > 1) {
+    printf("Number of burgers made on another NUMA node: %u\n", server_ctx.total_remote);
+    printf("Number of orders stolen from another kitchen pool: %u\n", server_ctx.total_stolen);
+  }
+  for (i = 0; i < menu->items; i++) {
+    printf("Number of %s burger made: %u\n", menu->item[i].name, server_ctx.total_burgers[i]);
+  }
+  if (pipelined) {
+    StationStats st[MENU_STATIONS];
+    int j;
+
+    pipeline_stats(st);
+    for (i = 0; i < menu->stations; i++) {
+      if (st[i].lane_ns == 0) continue;
+      printf("Station %s: %u lane(s) at exit, %lu burger(s), utilization", menu->station[i],
+             st[i].lanes, (unsigned long)st[i].burgers);
+      for (j = 0; j < STAGE_MAX; j++) {
+        printf(" %s %.1f%%", stage_names[j], 100.0 * st[i].busy_ns[j] / st[i].lane_ns);
+      }
+      printf("\n");
+    }
+  }
+  if (kitchens_min < kitchens_max) {
+    printf("Elastic kitchens: %u-%u, peak %u, scaled up %u time(s), down %u time(s)\n",
+           kitchens_min, kitchens_max, server_ctx.kitchens_peak, server_ctx.total_scale_ups,
+           server_ctx.total_scale_downs);
+  }
+  served = server_ctx.total_deadline_hits + server_ctx.total_deadline_misses;
+  if (served + server_ctx.total_rejected > 0) {
+    printf("Requests with a deadline: %u met, %u missed (%.1f%% met), %u rejected up front\n",
+           server_ctx.total_deadline_hits, server_ctx.total_deadline_misses,
+           served ? 100.0 * server_ctx.total_deadline_hits / served : 0.0,
+           server_ctx.total_rejected);
+  }
+  if (server_ctx.latency_count > 0) {
+    printf("Request latency: avg %.1f ms, p50 <%.0f ms, p99 <%.0f ms, max %.1f ms\n",
+           server_ctx.latency_sum_us / 1e3 / server_ctx.latency_count,
+           stats_percentile(server_ctx.latency_hist, server_ctx.latency_count, 50),
+           stats_percentile(server_ctx.latency_hist, server_ctx.latency_count, 99),
+           server_ctx.latency_max_us / 1e3);
+  }
+  rate_stats(&rs);
+  if (rs.rate > 0) {
+    printf("Rate limit: %u connection(s)/s per client, burst %u; %lu connection(s) refused, "
+           "%u client(s)\n", rs.rate, rs.burst, (unsigned long)rs.rejected, rs.clients);
+    for (i = 0; i < rs.ntop; i++) {
+      printf("  %-40s %lu admitted, %lu refused\n",
+             rate_format(&rs.top[i].client, addr, sizeof(addr)),
+             (unsigned long)rs.top[i].admitted, (unsigned long)rs.top[i].rejected);
+    }
+  }
+  idem_stats(&is);
+  if (is.hits + is.reattached + is.abandoned + is.keys > 0) {
+    printf("Idempotency keys: %lu kept, %lu retries collected burgers made (%lu while in the "
+           "making), %lu request(s) failed, %lu result(s) evicted\n", (unsigned long)is.keys,
+           (unsigned long)(is.hits + is.reattached), (unsigned long)is.reattached,
+           (unsigned long)is.abandoned, (unsigned long)is.evicted);
+  }
+  if (log_dropped() > 0) printf("Number of log records dropped: %lu\n", (unsigned long)log_dropped());
+  if (journal_dir) {
+    JournalStats js;
+    journal_stats(&js);
+    printf("Number of requests restored from the journal: %u\n", server_ctx.total_recovered);
+    printf("Journal: %lu record(s), %.0f record(s)/s, %lu commit(s), %.1f record(s)/commit\n",
+           (unsigned long)js.records, js.seconds > 0 ? js.records / js.seconds : 0.0,
+           (unsigned long)js.commits, js.commits ? (double)js.records / js.commits : 0.0);
+    printf("Journal fsync latency: avg %.3f ms, max %.3f ms\n",
+           js.commits ? js.sync_ns / 1e6 / js.commits : 0.0, js.sync_max_ns / 1e6);
   }
+  lockprof_dump(stdout);
   printf("\n");
 }
 
 /// @brief exit function
 void exit_mcdonalds(void)
 {
-  pthread_mutex_destroy(&server_ctx.lock);
-  close(listenfd);
+  stats_close();
+  lobby_close();
+  journal_close();
+  trace_close();
+  timer_close();
+  log_close();
+  if (listenfd >= 0) close(listenfd);
+  if (unixfd >= 0) unlink(unix_path);
+  if (handoff_fd >= 0) unlink(handoff_path);
   print_statistics();
 }
 
@@ -531,20 +1821,44 @@ void sigint_handler2(int sig)
   exit(EXIT_SUCCESS);
 }
 
-/// @brief First SIGINT handler function
+/// @brief First SIGINT handler function. Stops accepting customers; the main thread then serves
+///        the remaining customers and exits. A second SIGINT exits immediately.
 /// @param sig signal number
 void sigint_handler(int sig)
 {
   signal(SIGINT, sigint_handler2);
-  printf("****** I'm tired, closing McDonald's ******\n");
   keep_running = 0;
-  sleep(3);
-  exit(EXIT_SUCCESS);
+
+  // Wake up main thread waiting for customers
+  if (write(wake_pipe[1], "", 1) < 0) {}
+}
+
+/// @brief SIGUSR1 handler function. Makes logging more verbose.
+/// @param sig signal number
+void sigusr1_handler(int sig)
+{
+  log_set_level(log_level + 1);
+}
+
+/// @brief SIGUSR2 handler function. Makes logging less verbose.
+/// @param sig signal number
+void sigusr2_handler(int sig)
+{
+  log_set_level(log_level - 1);
+}
+
+/// @brief SIGHUP handler function. Re-reads the rate limits file.
+/// @param sig signal number
+void sighup_handler(int sig)
+{
+  reload_limits = 1;
+  if (write(wake_pipe[1], "", 1) < 0) {}
 }
 
 /// @brief init function initializes necessary variables and sets SIGINT handler
 void init_mcdonalds(void)
 {
+  struct rlimit nofile = { 0, 0 };
   int i;
 
   printf("@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@\n");
@@ -579,27 +1893,370 @@ void init_mcdonalds(void)
   printf("\n\n                          I'm lovin it! McDonald's\n\n");
 
   signal(SIGINT, sigint_handler);
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGUSR1, sigusr1_handler);
+  signal(SIGUSR2, sigusr2_handler);
+  if (limits_path) signal(SIGHUP, sighup_handler);
+  log_init(STDOUT_FILENO);
+  timer_init();
+
+  // Every customer takes a file descriptor; allow as many as the system lets us
+  if ((getrlimit(RLIMIT_NOFILE, &nofile) == 0) && (nofile.rlim_cur < nofile.rlim_max)) {
+    nofile.rlim_cur = nofile.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &nofile);
+  }
+  if (getrlimit(RLIMIT_NOFILE, &nofile) < 0) nofile.rlim_cur = RLIM_INFINITY;
+
+  // Idle customers wait in the lobby without a serving thread. Every one of them holds a file
+  // descriptor, so the lobby must leave room for the rest of the server within the limit.
+  if ((lobby_max > 0) && (lobby_max + LOBBY_FD_RESERVE > nofile.rlim_cur)) {
+    lobby_max = (nofile.rlim_cur > 2 * LOBBY_FD_RESERVE) ? nofile.rlim_cur - LOBBY_FD_RESERVE :
+                                                           nofile.rlim_cur / 2;
+    log_warn("Lobby limited to %u customer(s) by the limit on open files", lobby_max);
+  }
+  if (lobby_max > 0) {
+    if (lobby_open(lobby_max, read_timeout, leave_lobby) < 0) {
+      log_warn("Cannot open the lobby; every customer gets a thread right away");
+      lobby_max = 0;
+    } else {
+      log_info("Lobby: up to %u customer(s), %lu file descriptor(s)", lobby_max,
+               (unsigned long)nofile.rlim_cur);
+    }
+  }
+  if (pipe2(wake_pipe, O_CLOEXEC) < 0) perror("pipe2");
+
   pthread_mutex_init(&server_ctx.lock, NULL);
+  pthread_cond_init(&server_ctx.drained, NULL);
+  // One kitchen pool with its own order list per node, or a single pool. Lists are placed on
+  // the memory of their node.
+  topo_init();
+  topo_describe(topology, sizeof(topology));
+  log_info("Topology: %s, placement: %s", topology, placement_names[placement]);
+  if (net_init(io_backend) != io_backend) {
+    log_warn("%s not available, falling back to %s", net_backend_names[io_backend],
+             net_backend_names[net_backend()]);
+  }
+  log_info("I/O backend: %s", net_backend_names[net_backend()]);
+  log_rate_limit();
+  idem_setup(idem_keys, idem_ttl);
+  if (idem_keys > 0) {
+    log_info("Idempotency keys: up to %u, results kept for %u s", idem_keys, idem_ttl / 1000);
+  }
+  server_ctx.nlists = ((placement == PLACE_NODE) && !pipelined) ? topo_nodes() : 1;
+  for (i = 0; i < server_ctx.nlists; i++) {
+    server_ctx.lists[i] = (OrderList *)topo_alloc_node(sizeof(OrderList), i);
+    if (server_ctx.lists[i] == NULL) {
+      perror("order list");
+      exit(EXIT_FAILURE);
+    }
+    init_orders(server_ctx.lists[i]);
+  }
 
   server_ctx.total_customers = 0;
   server_ctx.total_queueing = 0;
-  for (i = 0; i < BURGER_TYPE_MAX; i++) {
-    server_ctx.total_burgers[i] = 0;
+  server_ctx.total_waiting = 0;
+  server_ctx.total_seatless = 0;
+  server_ctx.seat_first = server_ctx.seat_last = NULL;
+  server_ctx.total_walkouts = 0;
+  server_ctx.total_timeouts = 0;
+  server_ctx.total_skipped = 0;
+  server_ctx.total_remote = 0;
+  server_ctx.total_stolen = 0;
+  server_ctx.total_recovered = 0;
+  server_ctx.total_rejected = 0;
+  server_ctx.total_deadline_hits = 0;
+  server_ctx.total_deadline_misses = 0;
+  server_ctx.kitchens = 0;
+  server_ctx.kitchens_peak = 0;
+  server_ctx.kitchen_ns = 0;
+  server_ctx.kitchens_since = monotonic_ns();
+  server_ctx.total_scale_ups = 0;
+  server_ctx.total_scale_downs = 0;
+  server_ctx.total_orders = 0;
+  memset(server_ctx.cooking_since, 0, sizeof(server_ctx.cooking_since));
+  server_ctx.busy_ns = 0;
+  memset(server_ctx.latency_hist, 0, sizeof(server_ctx.latency_hist));
+  server_ctx.latency_count = 0;
+  server_ctx.latency_sum_us = 0;
+  server_ctx.latency_max_us = 0;
+  memset(server_ctx.total_burgers, 0, sizeof(server_ctx.total_burgers));
+
+  // Restore the requests a crashed server left behind before the kitchens open
+  if (journal_dir) {
+    if (journal_open(journal_dir, recover_request, NULL) < 0) {
+      perror("journal");
+      exit(EXIT_FAILURE);
+    }
+    log_info("Journal: %s", journal_dir);
+  }
+
+  if (trace_path) {
+    if (trace_open(trace_path) < 0) {
+      perror(trace_path);
+      exit(EXIT_FAILURE);
+    }
+    log_info("Recording a trace of the requests in %s", trace_path);
   }
 
   pthread_mutex_init(&kitchen_mutex, NULL);
+  pthread_cond_init(&scale_cond, NULL);
+
+  // The pipelined kitchen runs as many threads as the kitchen at most
+  if (pipelined) {
+    if (placement != PLACE_NONE) log_warn("Placement is not supported by the pipelined kitchen");
+    if (kitchens_min < kitchens_max) {
+      log_warn("The pipelined kitchen does not scale; running %u thread(s)", kitchens_max);
+      kitchens_min = kitchens_max;
+    }
+    if (pipeline_start(server_ctx.lists[0], kitchens_max, pipeline_done) < 0) {
+      perror("pipeline");
+      exit(EXIT_FAILURE);
+    }
+    log_info("Kitchen: pipeline of %u lane(s)", kitchens_max / STAGE_MAX);
+    pthread_mutex_lock(&kitchen_mutex);
+    count_kitchens(kitchens_max);
+    pthread_mutex_unlock(&kitchen_mutex);
+    return;
+  }
 
-  for (i = 0; i < NUM_KITCHEN; i++) {
-    pthread_create(&kitchen_thread[i], NULL, kitchen_task, NULL);
-    pthread_detach(kitchen_thread[i]);
+  pthread_mutex_lock(&kitchen_mutex);
+  for (i = 0; i < kitchens_min; i++) {
+    if (start_kitchen() < 0) {
+      perror("kitchen");
+      exit(EXIT_FAILURE);
+    }
   }
+  pthread_mutex_unlock(&kitchen_mutex);
+
+  if (kitchens_min < kitchens_max) {
+    log_info("Kitchens: elastic, %u-%u", kitchens_min, kitchens_max);
+    if (pthread_create(&scale_thread, NULL, scale_task, NULL)) {
+      perror("scaler");
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+/// @brief print usage
+/// @param prog program name
+void usage(const char *prog)
+{
+  printf("usage %s [-T] [-H <path>] [-L <level>] [-r <sec>] [-w <sec>] [-d <sec>] [-A <policy>]\n"
+         "          [-I <backend>] [-u <path>] [-J <dir>] [-S <name>] [-p <port>] [-K <kitchen>]\n"
+         "          [-k <min>[:<max>]] [-W <max>] [-M <file>] [-R <file>] [-q <rate>[:<burst>]]\n"
+         "          [-Q <file>] [-b <backlog>] [-F <qlen>] [-D <sec>] [-C <keys>[:<sec>]]\n", prog);
+  printf("  -T         take over the listening socket of a running server (zero-downtime restart)\n");
+  printf("  -H <path>  handoff socket (default: %s)\n", HANDOFF_PATH);
+  printf("  -L <level> log level: error, warn, info, debug (default: %s). SIGUSR1/SIGUSR2 raise/lower\n"
+         "             the log level at runtime\n", log_level_names[LOG_INFO]);
+  printf("  -r <sec>   max. wait for request data (default: %g, 0: none)\n", READ_TIMEOUT_MS / 1000.0);
+  printf("  -w <sec>   max. wait to send a response (default: %g, 0: none)\n", WRITE_TIMEOUT_MS / 1000.0);
+  printf("  -d <sec>   max. duration of a request (default: %g, 0: none)\n", REQUEST_TIMEOUT_MS / 1000.0);
+  printf("  -A <policy> placement of threads: none, compact, spread, node (default: none)\n");
+  printf("  -u <path>  also listen on this Unix domain socket (default: %s, \"\": TCP only)\n",
+         UNIX_PATH);
+  printf("  -J <dir>   journal accepted requests and made burgers in <dir>; requests left\n"
+         "             unfinished by a crash are restored at startup\n");
+  printf("  -p <port>  listen on TCP port <port> (default: %d). The default handoff socket, Unix\n"
+         "             domain socket and statistics get the suffix .<port> for other ports\n", PORT);
+  printf("  -S <name>  publish live statistics in shared memory object <name> for mcstat\n"
+         "             (default: %s, \"\": none)\n", STATS_NAME);
+  printf("  -K <kitchen> classic: every kitchen makes whole burgers; pipeline: stations per burger\n"
+         "             type whose lanes pass burgers through prep, grill and assemble threads\n"
+         "             (default: classic)\n");
+  printf("  -k <min>[:<max>] number of kitchens (default: %d). With a range, the pool grows with\n"
+         "             the queue and arrival rate and sends idle kitchens home after %g s\n",
+         NUM_KITCHEN, SCALE_COOLDOWN_MS / 1000.0);
+  printf("  -W <max>   max. customers waiting in the lobby until they order (default: %d, 0: no\n"
+         "             lobby, every customer gets a serving thread right away)\n", LOBBY_MAX);
+  printf("  -M <file>  load the menu from <file>; one burger per line:\n"
+         "             <name> <cook_ms> [<station>] [<prep>:<grill>:<assemble>] (default: built-in)\n");
+  printf("  -R <file>  record the arrival, burgers and outcome of every request in the trace <file>\n"
+         "             for a replay with client -P\n");
+  printf("  -q <rate>[:<burst>] admit at most <rate> connections per second from every client\n"
+         "             address (Unix domain socket: user), <burst> at once (default: <rate>, 0: no\n"
+         "             limit). Connections over the limit are refused right after accept\n");
+  printf("  -Q <file>  read the limit <rate>[:<burst>] from <file>; re-read on SIGHUP\n");
+  printf("  -b <backlog> connections waiting to be accepted (default: %d, capped by\n"
+         "             net.core.somaxconn)\n", LISTEN_BACKLOG);
+  printf("  -F <qlen>  TCP Fast Open: up to <qlen> pending connections with data in the SYN\n"
+         "             (default: %d, 0: off)\n", LISTEN_FASTOPEN);
+  printf("  -D <sec>   accept TCP connections only once the request arrives, or after <sec>\n"
+         "             seconds (default: 0, off). For clients that order without waiting for the\n"
+         "             welcome, like client -f\n");
+  printf("  -C <keys>[:<sec>] keep up to <keys> idempotency keys (key=<key>) and the burgers made\n"
+         "             for them for <sec> seconds, for retries (default: %d:%g, 0: none)\n",
+         IDEM_KEYS, IDEM_TTL_MS / 1000.0);
+  printf("  -I <backend> socket I/O: posix, io_uring (default: posix). io_uring falls back to posix\n"
+         "             if the kernel does not support it\n");
+}
+
+/// @brief parse a timeout given in seconds
+/// @param arg timeout in seconds
+/// @param ms timeout in milliseconds. Out parameter.
+/// @retval 0 on success
+/// @retval -1 if @a arg is not a valid timeout
+int parse_timeout(const char *arg, unsigned int *ms)
+{
+  char *end;
+  double sec = strtod(arg, &end);
+
+  if ((end == arg) || (*end != '\0') || (sec < 0) || (sec > 4000000)) return -1;
+
+  *ms = (unsigned int)(sec * 1000 + 0.5);
+  return 0;
+}
+
+/// @brief give a default path or name the suffix .<port> when the server listens on another
+///        port than PORT, so that servers of a franchise on one host do not share them
+/// @param name path or name. In/out parameter.
+/// @param def default of @a name
+void port_default(char **name, const char *def)
+{
+  if ((port == PORT) || (strcmp(*name, def) != 0)) return;
+  if (asprintf(name, "%s.%u", def, port) < 0) perror("asprintf");
 }
 
 /// @brief program entry point
 int main(int argc, char *argv[])
 {
+  int opt, level;
+  unsigned int rate, burst;
+  long num;
+  char *end;
+
+  while ((opt = getopt(argc, argv, "TH:L:r:w:d:A:I:u:J:S:p:K:k:W:M:R:q:Q:b:F:D:C:")) != -1) {
+    switch (opt) {
+      case 'T': takeover = true; break;
+      case 'H': handoff_path = optarg; break;
+      case 'u': unix_path = optarg; break;
+      case 'J': journal_dir = optarg; break;
+      case 'S': stats_name = optarg; break;
+      case 'M': menu_path = optarg; break;
+      case 'R': trace_path = optarg; break;
+      case 'W':
+        num = strtol(optarg, &end, 10);
+        if ((end == optarg) || (*end != '\0') || (num < 0) || (num > 100000000)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        lobby_max = num;
+        break;
+      case 'k':
+        num = strtol(optarg, &end, 10);
+        kitchens_min = kitchens_max = (unsigned int)num;
+        if ((end != optarg) && (*end == ':')) {
+          optarg = end + 1;
+          num = strtol(optarg, &end, 10);
+          kitchens_max = (unsigned int)num;
+        }
+        if ((end == optarg) || (*end != '\0') || (num <= 0) || (kitchens_min == 0) ||
+            (kitchens_min > kitchens_max) || (kitchens_max > KITCHEN_MAX)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'q':
+        if (rate_parse(optarg, &rate, &burst) < 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        rate_set(rate, burst);
+        break;
+      case 'Q': limits_path = optarg; break;
+      case 'C':
+        num = strtol(optarg, &end, 10);
+        if ((end != optarg) && (*end == ':')) {
+          if (parse_timeout(end + 1, &idem_ttl) < 0) end = optarg;
+          else end += strlen(end);
+        }
+        if ((end == optarg) || (*end != '\0') || (num < 0) || (num > 100000000)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        idem_keys = num;
+        break;
+      case 'b':
+      case 'F':
+      case 'D':
+        num = strtol(optarg, &end, 10);
+        if ((end == optarg) || (*end != '\0') || (num < (opt == 'b')) || (num > 1000000)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        if (opt == 'b') backlog = num;
+        else if (opt == 'F') fastopen = num;
+        else defer_accept = num;
+        break;
+      case 'K':
+        if (strcmp(optarg, "pipeline") == 0) pipelined = true;
+        else if (strcmp(optarg, "classic") == 0) pipelined = false;
+        else {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'p':
+        num = strtol(optarg, &end, 10);
+        if ((end == optarg) || (*end != '\0') || (num <= 0) || (num > 65535)) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        port = num;
+        break;
+      case 'L':
+        if ((level = log_parse_level(optarg)) < 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        log_set_level(level);
+        break;
+      case 'A':
+        if ((level = topo_parse_placement(optarg)) < 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        placement = level;
+        break;
+      case 'I':
+        if ((level = net_parse_backend(optarg)) < 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        io_backend = level;
+        break;
+      case 'r':
+      case 'w':
+      case 'd':
+        if (parse_timeout(optarg, (opt == 'r') ? &read_timeout :
+                                  (opt == 'w') ? &write_timeout : &request_timeout) < 0) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+
+  port_default(&handoff_path, HANDOFF_PATH);
+  port_default(&unix_path, UNIX_PATH);
+  port_default(&stats_name, STATS_NAME);
+
+  // Requests, statistics and the journal refer to burgers by their index on the menu
+  if (menu_load(menu_path) < 0) {
+    perror(menu_path ? menu_path : "menu");
+    return EXIT_FAILURE;
+  }
+  if (limits_path && (rate_load(limits_path) < 0)) {
+    perror(limits_path);
+    return EXIT_FAILURE;
+  }
+
   init_mcdonalds();
   start_server();
+  drain_mcdonalds();
   exit_mcdonalds();
 
   return 0;
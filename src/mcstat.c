@@ -0,0 +1,311 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  mcstat.c
+/// @brief Live statistics of a running McDonald's server, like vmstat
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab deadline hits and misses
+/// 2026/10/19 ARC lab station metrics of the pipelined kitchen
+/// 2026/10/19 ARC lab elastic kitchen pool
+/// 2026/10/19 ARC lab lobby and connection memory
+/// 2026/10/19 ARC lab burgers and stations of the server's menu
+/// 2026/10/19 ARC lab rate limit and top talkers
+/// 2026/10/19 ARC lab most contended locks (LOCKPROF)
+/// 2026/10/19 ARC lab idempotency keys
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "burger.h"
+#include "stats.h"
+#include "ratelimit.h"
+
+/// @name Macro definitions
+/// @{
+
+#define HEADER_EVERY 20                                   ///< rows between repeated headers
+
+/// @}
+
+/// @name Global variables
+/// @{
+
+const char *state_names[] = { "?", "running", "draining", "closed" };  ///< enum stats_state
+
+/// @}
+
+
+/// @brief name of a server state
+/// @param state enum stats_state
+/// @retval name
+const char* state_name(uint64_t state)
+{
+  return (state <= STATS_CLOSED) ? state_names[state] : state_names[0];
+}
+
+/// @brief sum of the burgers made of all types
+/// @param s snapshot
+/// @retval number of burgers
+uint64_t burgers(const StatsSnapshot *s)
+{
+  uint64_t sum = 0;
+  int i;
+
+  for (i = 0; i < MENU_MAX; i++) sum += s->burgers[i];
+  return sum;
+}
+
+/// @brief print the totals of a snapshot
+/// @param s snapshot
+/// @param l names of the burgers and stations
+void print_totals(const StatsSnapshot *s, const StatsLabels *l)
+{
+  double sec = s->uptime_ns / 1e9;
+  unsigned int items = (l->items < MENU_MAX) ? l->items : MENU_MAX;
+  unsigned int stations = (l->stations < MENU_STATIONS) ? l->stations : MENU_STATIONS;
+  unsigned int i;
+
+  printf("pid %lu, %s, up %.1f s\n", (unsigned long)s->pid, state_name(s->state), sec);
+  printf("%12lu customers visited\n", (unsigned long)s->customers);
+  printf("%12lu customers in the restaurant\n", (unsigned long)s->queueing);
+  printf("%12lu customers waiting in the lobby\n", (unsigned long)s->waiting);
+  printf("%12lu customers who left without ordering\n", (unsigned long)s->walkouts);
+  printf("%12lu connections, %lu bytes of receive buffers (%lu lent)\n", (unsigned long)s->conns,
+         (unsigned long)s->pool_bytes, (unsigned long)s->pool_used);
+  printf("%12lu customers timed out\n", (unsigned long)s->timeouts);
+  if (s->rate_limit > 0) {
+    printf("%12lu connections/s per client, burst %lu\n", (unsigned long)s->rate_limit,
+           (unsigned long)s->rate_burst);
+  }
+  printf("%12lu connections refused by the rate limit\n", (unsigned long)s->rate_rejected);
+  for (i = 0; i < s->talkers && i < STATS_TALKERS; i++) {
+    RateClient c = { .family = s->talker_family[i] };
+    char addr[64];
+
+    memcpy(c.addr, s->talker_addr[i], sizeof(c.addr));
+    printf("%12lu connections from %s, %lu refused\n",
+           (unsigned long)(s->talker_admitted[i] + s->talker_rejected[i]),
+           rate_format(&c, addr, sizeof(addr)), (unsigned long)s->talker_rejected[i]);
+  }
+  printf("%12lu requests restored from the journal\n", (unsigned long)s->recovered);
+  printf("%12lu orders waiting for a kitchen\n", (unsigned long)s->queued);
+  for (i = 0; i < items; i++) {
+    printf("%12lu %.*s burgers made\n", (unsigned long)s->burgers[i], TOKEN_MAX, l->item[i]);
+  }
+  printf("%12lu burgers skipped for customers who left\n", (unsigned long)s->skipped);
+  printf("%12lu burgers made on another NUMA node\n", (unsigned long)s->remote);
+  printf("%12lu orders stolen from another kitchen pool\n", (unsigned long)s->stolen);
+  printf("%12lu of %lu kitchens cooking\n", (unsigned long)s->kitchens_busy,
+         (unsigned long)s->kitchens);
+  if (s->kitchens_min < s->kitchens_max) {
+    printf("%12lu kitchens at peak, elastic %lu-%lu\n", (unsigned long)s->kitchens_peak,
+           (unsigned long)s->kitchens_min, (unsigned long)s->kitchens_max);
+    printf("%12lu times kitchens were added\n", (unsigned long)s->scale_ups);
+    printf("%12lu times kitchens were sent home\n", (unsigned long)s->scale_downs);
+  }
+  printf("%12lu orders handed to the kitchen\n", (unsigned long)s->orders);
+  printf("%12.1f %% kitchen utilization\n",
+         s->kitchen_ns ? 100.0 * s->busy_ns / s->kitchen_ns : 0.0);
+  printf("%12lu requests finished\n", (unsigned long)s->latency_count);
+  printf("%12lu requests met their deadline\n", (unsigned long)s->deadline_hits);
+  printf("%12lu requests missed their deadline\n", (unsigned long)s->deadline_misses);
+  printf("%12lu requests rejected for their deadline\n", (unsigned long)s->rejected);
+  if (s->latency_count > 0) {
+    printf("%12.1f ms avg. request latency\n", s->latency_sum_us / 1e3 / s->latency_count);
+    printf("%12.0f ms p50 request latency (upper bound)\n",
+           stats_percentile(s->latency_hist, s->latency_count, 50));
+    printf("%12.0f ms p99 request latency (upper bound)\n",
+           stats_percentile(s->latency_hist, s->latency_count, 99));
+    printf("%12.1f ms max. request latency\n", s->latency_max_us / 1e3);
+  }
+  for (i = 0; i < stations; i++) {
+    const uint64_t *busy = s->station_busy_ns[i];
+    uint64_t lane_ns = s->station_lane_ns[i];
+
+    if (lane_ns == 0) continue;
+    printf("%12lu lanes at the %.*s station, %lu orders, utilization prep %.0f%% grill %.0f%% "
+           "assemble %.0f%%\n", (unsigned long)s->station_lanes[i], TOKEN_MAX, l->station[i],
+           (unsigned long)s->station_backlog[i], 100.0 * busy[0] / lane_ns,
+           100.0 * busy[1] / lane_ns, 100.0 * busy[2] / lane_ns);
+  }
+  printf("%12lu journal records\n", (unsigned long)s->journal_records);
+  printf("%12lu journal commits\n", (unsigned long)s->journal_commits);
+  printf("%12lu log records dropped\n", (unsigned long)s->log_dropped);
+  printf("%12lu idempotency keys kept, %lu in the making\n", (unsigned long)s->idem_keys,
+         (unsigned long)s->idem_inflight);
+  printf("%12lu retries collected burgers made, %lu while in the making\n",
+         (unsigned long)(s->idem_hits + s->idem_reattached), (unsigned long)s->idem_reattached);
+  printf("%12lu requests with a key failed, %lu results evicted\n",
+         (unsigned long)s->idem_abandoned, (unsigned long)s->idem_evicted);
+  for (i = 0; i < s->locks && i < STATS_LOCKS; i++) {
+    printf("%12lu acquisitions of %.*s, %.1f%% contended, %.1f ms waited (max %.1f us), "
+           "%.1f ms held\n", (unsigned long)s->lock_acquired[i], STATS_LOCK_NAME,
+           (const char*)s->lock_name[i], 100.0 * s->lock_contended[i] / s->lock_acquired[i],
+           s->lock_wait_ns[i] / 1e6, s->lock_wait_max_ns[i] / 1e3, s->lock_hold_ns[i] / 1e6);
+  }
+}
+
+/// @brief print the header of the rate table
+void print_header(void)
+{
+  printf("  cust/s   wait   in queued burger/s  util  kit busy  tmo/s skip/s  ref/s   avg_ms   p50_ms"
+         "   p99_ms  jrnl/s state\n");
+}
+
+/// @brief print the rates between two snapshots of the same server
+/// @param a earlier snapshot
+/// @param b later snapshot
+void print_rates(const StatsSnapshot *a, const StatsSnapshot *b)
+{
+  double sec = (b->uptime_ns - a->uptime_ns) / 1e9;
+  uint64_t hist[STATS_BUCKETS];
+  uint64_t count = b->latency_count - a->latency_count;
+  int i;
+
+  if (sec <= 0) return;
+
+  for (i = 0; i < STATS_BUCKETS; i++) hist[i] = b->latency_hist[i] - a->latency_hist[i];
+
+  printf("%8.1f %6lu %4lu %6lu %9.1f %4.0f%% %4lu %4lu %6.1f %6.1f %6.1f ",
+         (b->customers - a->customers) / sec, (unsigned long)b->waiting, (unsigned long)b->queueing,
+         (unsigned long)b->queued, (burgers(b) - burgers(a)) / sec,
+         b->kitchen_ns > a->kitchen_ns ?
+           100.0 * (b->busy_ns - a->busy_ns) / (b->kitchen_ns - a->kitchen_ns) : 0.0,
+         (unsigned long)b->kitchens, (unsigned long)b->kitchens_busy,
+         (b->timeouts - a->timeouts) / sec,
+         (b->skipped - a->skipped) / sec,
+         (b->rate_rejected - a->rate_rejected) / sec);
+  if (count > 0) {
+    printf("%8.1f %8.0f %8.0f ", (b->latency_sum_us - a->latency_sum_us) / 1e3 / count,
+           stats_percentile(hist, count, 50), stats_percentile(hist, count, 99));
+  } else {
+    printf("%8s %8s %8s ", "-", "-", "-");
+  }
+  printf("%7.1f %s\n", (b->journal_records - a->journal_records) / sec, state_name(b->state));
+  fflush(stdout);
+}
+
+/// @brief print usage
+/// @param prog program name
+void usage(const char *prog)
+{
+  printf("usage %s [-n <name>] [-s] [<interval> [<count>]]\n", prog);
+  printf("  -n <name>  shared memory object of the server (default: %s)\n", STATS_NAME);
+  printf("  -s         print the totals once and exit\n");
+  printf("  <interval> seconds between rows (default: 1)\n");
+  printf("  <count>    number of rows (default: unlimited)\n");
+}
+
+/// @brief program entry point
+int main(int argc, char *argv[])
+{
+  const char *name = STATS_NAME;
+  const StatsShm *shm = NULL;
+  StatsSnapshot prev, cur;
+  struct timespec interval;
+  double sec = 1;
+  long count = -1, rows = 0;
+  uint64_t ino = 0, pid = 0;
+  bool totals = false, waiting = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:s")) != -1) {
+    switch (opt) {
+      case 'n': name = optarg; break;
+      case 's': totals = true; break;
+      default:
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+  }
+  if (optind < argc) sec = atof(argv[optind++]);
+  if (optind < argc) count = atol(argv[optind++]);
+  if ((sec <= 0) || (optind < argc)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  interval.tv_sec = (time_t)sec;
+  interval.tv_nsec = (long)((sec - interval.tv_sec) * 1e9);
+
+  if (totals) {
+    if ((shm = stats_attach(name, NULL)) == NULL) {
+      fprintf(stderr, "Cannot map %s: %s\n", name, strerror(errno));
+      return EXIT_FAILURE;
+    }
+    stats_read(shm, &cur);
+    print_totals(&cur, &shm->labels);
+    stats_detach(shm);
+    return EXIT_SUCCESS;
+  }
+
+  // Reading costs the server nothing: no syscalls or locks on its side. Between rows, a new
+  // server that took over or restarted under the same name is picked up.
+  while ((count < 0) || (rows < count)) {
+    if ((shm != NULL) && (stats_ino(name) != ino)) {
+      stats_detach(shm);
+      shm = NULL;
+    }
+
+    if (shm == NULL) {
+      if ((shm = stats_attach(name, &ino)) == NULL) {
+        if (!waiting) fprintf(stderr, "Waiting for McDonald's at %s...\n", name);
+        waiting = true;
+        nanosleep(&interval, NULL);
+        continue;
+      }
+      waiting = false;
+
+      stats_read(shm, &prev);
+      if (pid != 0) printf("--- server pid %lu replaced pid %lu\n", (unsigned long)prev.pid,
+                           (unsigned long)pid);
+      pid = prev.pid;
+      print_header();
+      nanosleep(&interval, NULL);
+      continue;
+    }
+
+    stats_read(shm, &cur);
+    if ((rows > 0) && (rows % HEADER_EVERY == 0)) print_header();
+    print_rates(&prev, &cur);
+    prev = cur;
+    rows++;
+
+    if ((count < 0) || (rows < count)) nanosleep(&interval, NULL);
+  }
+
+  if (shm) stats_detach(shm);
+
+  return EXIT_SUCCESS;
+}
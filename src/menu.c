@@ -0,0 +1,331 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  menu.c
+/// @brief Menu: burgers, their cook times and stations, loaded at startup
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "menu.h"
+
+/// @name Macro definitions
+/// @{
+
+#define MENU_FIELDS 4                                     ///< max. fields of a menu line
+#define MENU_STATION "kitchen"                            ///< station of burgers that name none
+
+/// @}
+
+const char *stage_names[STAGE_MAX] = { "prep", "grill", "assemble" };
+
+const Menu *menu = NULL;
+
+static const unsigned int default_weights[STAGE_MAX] = { 30, 40, 30 };
+
+/// @brief FNV-1a hash of a name
+/// @param name name
+/// @param len length of @a name
+/// @retval hash
+static uint32_t hash_name(const char *name, size_t len)
+{
+  uint32_t h = 2166136261U;
+
+  while (len-- > 0) h = (h ^ (unsigned char)*name++) * 16777619U;
+  return h;
+}
+
+unsigned int menu_lookup(const char *name, size_t len)
+{
+  uint32_t h = hash_name(name, len) & (MENU_SLOTS - 1);
+  const MenuItem *it;
+  uint16_t s;
+
+  // The table is at most half full, so probes are short and always reach a free slot
+  while ((s = menu->slot[h]) != 0) {
+    it = &menu->item[s - 1];
+    if ((it->len == len) && (memcmp(it->name, name, len) == 0)) return s - 1;
+    h = (h + 1) & (MENU_SLOTS - 1);
+  }
+  return MENU_MAX;
+}
+
+/// @brief check a name of a burger or station. Names appear as tokens in requests, so they may
+///        not contain whitespace, '=' (options) or ':' (stage weights).
+/// @param name name
+/// @param len length of @a name
+/// @retval true if the name is valid
+static bool valid_name(const char *name, size_t len)
+{
+  size_t i;
+
+  if ((len == 0) || (len > TOKEN_MAX)) return false;
+  for (i = 0; i < len; i++) {
+    if ((name[i] <= ' ') || (name[i] > '~') || (name[i] == '=') || (name[i] == ':')) return false;
+  }
+  return true;
+}
+
+/// @brief parse a decimal number
+/// @param s digits (not NUL-terminated)
+/// @param len length of @a s
+/// @param max largest valid value
+/// @param value number. Out parameter.
+/// @retval 0 on success
+/// @retval -1 if @a s is not a number up to @a max
+static int parse_number(const char *s, size_t len, unsigned int max, unsigned int *value)
+{
+  unsigned long v = 0;
+  size_t i;
+
+  if (len == 0) return -1;
+  for (i = 0; i < len; i++) {
+    if ((s[i] < '0') || (s[i] > '9')) return -1;
+    v = v * 10 + (s[i] - '0');
+    if (v > max) return -1;
+  }
+  *value = (unsigned int)v;
+  return 0;
+}
+
+/// @brief parse stage weights <prep>:<grill>:<assemble>
+/// @param s field (not NUL-terminated)
+/// @param len length of @a s
+/// @param w weights. Out parameter.
+/// @retval 0 on success
+/// @retval -1 if the field is invalid
+static int parse_weights(const char *s, size_t len, unsigned int *w)
+{
+  const char *end = s + len, *colon;
+  unsigned int i, sum = 0;
+
+  for (i = 0; i < STAGE_MAX; i++) {
+    colon = memchr(s, ':', end - s);
+    if ((colon == NULL) != (i == STAGE_MAX - 1)) return -1;
+    if (colon == NULL) colon = end;
+    if (parse_number(s, colon - s, 100, &w[i]) < 0) return -1;
+    sum += w[i];
+    s = colon + 1;
+  }
+  return (sum > 0) ? 0 : -1;
+}
+
+/// @brief find or add a station
+/// @param m menu being built
+/// @param name station name
+/// @param len length of @a name
+/// @retval station index
+/// @retval MENU_STATIONS if there are too many stations
+static unsigned int add_station(Menu *m, const char *name, size_t len)
+{
+  unsigned int s;
+
+  for (s = 0; s < m->stations; s++) {
+    if ((strlen(m->station[s]) == len) && (memcmp(m->station[s], name, len) == 0)) return s;
+  }
+  if (m->stations == MENU_STATIONS) return MENU_STATIONS;
+  memcpy(m->station[s], name, len);
+  m->station[s][len] = '\0';
+  return m->stations++;
+}
+
+/// @brief parse and validate a menu, and build its lookup table
+/// @param m menu. Out parameter.
+/// @param text menu text (not NUL-terminated)
+/// @param len length of @a text
+/// @param path name of the menu in error messages
+/// @retval 0 on success
+/// @retval -1 if the menu is invalid
+static int build_menu(Menu *m, const char *text, size_t len, const char *path)
+{
+  const char *p = text, *end = text + len, *eol, *field[MENU_FIELDS];
+  size_t flen[MENU_FIELDS];
+  unsigned int line = 0, n, i, w[STAGE_MAX], sum, done, total = 0;
+  const char *error;
+  MenuItem *it;
+  uint32_t h;
+
+  memset(m, 0, sizeof(*m));
+
+  for (; p < end; p = eol + 1) {
+    line++;
+    if ((eol = memchr(p, '\n', end - p)) == NULL) eol = end;
+
+    // Split the line into fields
+    for (n = 0; ; n++) {
+      while ((p < eol) && ((*p == ' ') || (*p == '\t') || (*p == '\r'))) p++;
+      if ((p == eol) || (*p == '#')) break;
+      if (n == MENU_FIELDS) {
+        error = "too many fields";
+        goto invalid;
+      }
+      field[n] = p;
+      while ((p < eol) && (*p != ' ') && (*p != '\t') && (*p != '\r')) p++;
+      flen[n] = p - field[n];
+    }
+    if (n == 0) continue;
+
+    error = "expected <name> <cook_ms> [<station>] [<prep>:<grill>:<assemble>]";
+    if (n < 2) goto invalid;
+    if (m->items == MENU_MAX) {
+      error = "too many burgers";
+      goto invalid;
+    }
+    it = &m->item[m->items];
+
+    if (!valid_name(field[0], flen[0])) {
+      error = "invalid burger name";
+      goto invalid;
+    }
+    memcpy(it->name, field[0], flen[0]);
+    it->len = flen[0];
+    if (parse_number(field[1], flen[1], MENU_COOK_MAX_MS, &it->cook_ms) < 0) {
+      error = "invalid cook time";
+      goto invalid;
+    }
+
+    // Station and stage weights are optional and come in this order
+    i = 2;
+    it->station = MENU_STATIONS;
+    if ((i < n) && (memchr(field[i], ':', flen[i]) == NULL)) {
+      if (!valid_name(field[i], flen[i])) {
+        error = "invalid station name";
+        goto invalid;
+      }
+      it->station = add_station(m, field[i], flen[i]);
+      i++;
+    } else {
+      it->station = add_station(m, MENU_STATION, strlen(MENU_STATION));
+    }
+    if (it->station == MENU_STATIONS) {
+      error = "too many stations";
+      goto invalid;
+    }
+    memcpy(w, default_weights, sizeof(w));
+    if (i < n) {
+      if (parse_weights(field[i], flen[i], w) < 0) {
+        error = "invalid stage weights";
+        goto invalid;
+      }
+      i++;
+    }
+    if (i < n) goto invalid;
+
+    // Split the cook time; the last stage takes the rounding error
+    for (sum = 0, i = 0; i < STAGE_MAX; i++) sum += w[i];
+    for (done = 0, i = 0; i + 1 < STAGE_MAX; i++) {
+      it->stage_ms[i] = it->cook_ms * w[i] / sum;
+      done += it->stage_ms[i];
+    }
+    it->stage_ms[STAGE_MAX - 1] = it->cook_ms - done;
+    for (i = 0; i < STAGE_MAX; i++) {
+      if (it->stage_ms[i] > m->station_ms[it->station]) m->station_ms[it->station] = it->stage_ms[i];
+    }
+
+    // Insert into the hash table
+    h = hash_name(it->name, it->len) & (MENU_SLOTS - 1);
+    while (m->slot[h] != 0) {
+      if ((m->item[m->slot[h] - 1].len == it->len) &&
+          (memcmp(m->item[m->slot[h] - 1].name, it->name, it->len) == 0)) {
+        error = "duplicate burger";
+        goto invalid;
+      }
+      h = (h + 1) & (MENU_SLOTS - 1);
+    }
+    m->slot[h] = ++m->items;
+
+    total += it->cook_ms;
+    if (it->cook_ms > m->max_ms) m->max_ms = it->cook_ms;
+  }
+
+  if (m->items == 0) {
+    fprintf(stderr, "%s: no burgers on the menu\n", path);
+    errno = EINVAL;
+    return -1;
+  }
+  m->mean_ms = (total + m->items / 2) / m->items;
+  return 0;
+
+invalid:
+  fprintf(stderr, "%s:%u: %s\n", path, line, error);
+  errno = EINVAL;
+  return -1;
+}
+
+int menu_load(const char *path)
+{
+  Menu *m;
+  struct stat sb;
+  void *text;
+  int fd, res;
+
+  if ((m = (Menu *)malloc(sizeof(Menu))) == NULL) return -1;
+
+  if (path == NULL) {
+    res = build_menu(m, menu_builtin, strlen(menu_builtin), "built-in menu");
+  } else {
+    // Map the file and check it in one pass; the menu keeps copies of the names
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) goto error;
+    if (fstat(fd, &sb) < 0) {
+      close(fd);
+      goto error;
+    }
+    if ((sb.st_size == 0) || (sb.st_size > MENU_FILE_MAX)) {
+      fprintf(stderr, "%s: %s\n", path, sb.st_size ? "menu too large" : "no burgers on the menu");
+      close(fd);
+      errno = sb.st_size ? EFBIG : EINVAL;
+      goto error;
+    }
+    text = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) goto error;
+    res = build_menu(m, (const char *)text, sb.st_size, path);
+    munmap(text, sb.st_size);
+  }
+  if (res < 0) goto error;
+
+  // An earlier menu is never freed: its names may still wait in the log
+  menu = m;
+  return 0;
+
+error:
+  res = errno;
+  free(m);
+  errno = res;
+  return -1;
+}
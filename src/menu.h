@@ -0,0 +1,114 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  menu.h
+/// @brief Menu: burgers, their cook times and stations, loaded at startup
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __MENU_H__
+#define __MENU_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "burger.h"
+
+/// @name Macro definitions
+/// @{
+
+#define MENU_SLOTS (2 * MENU_MAX)                         ///< slots of the name hash table
+#define MENU_FILE_MAX (1024 * 1024)                       ///< max. size of a menu file
+#define MENU_COOK_MAX_MS 600000                           ///< max. cook time of a burger
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief stages of making a burger
+enum stage {
+  STAGE_PREP,                                               ///< prepare the ingredients
+  STAGE_GRILL,                                              ///< grill the patty
+  STAGE_ASSEMBLE,                                           ///< assemble and wrap the burger
+  STAGE_MAX
+};
+
+extern const char *stage_names[STAGE_MAX];                  ///< names of the stages
+
+/// @brief a burger on the menu
+typedef struct __menu_item {
+  char name[TOKEN_MAX + 1];                                 ///< name in requests and responses
+  unsigned int len;                                         ///< length of name
+  unsigned int cook_ms;                                     ///< time to make the burger
+  unsigned int stage_ms[STAGE_MAX];                         ///< time of every stage (pipelined)
+  unsigned int station;                                     ///< station of the pipelined kitchen
+} MenuItem;
+
+/// @brief the menu. Built once at startup and never changed afterwards, so it is read without
+///        locks. Item names stay valid until the process exits and may be logged.
+typedef struct __menu {
+  unsigned int items;                                       ///< number of items
+  unsigned int stations;                                    ///< number of stations
+  MenuItem item[MENU_MAX];                                  ///< items; the index is the burger type
+  char station[MENU_STATIONS][TOKEN_MAX + 1];               ///< names of the stations
+  unsigned int station_ms[MENU_STATIONS];                   ///< slowest stage of every station
+  unsigned int mean_ms;                                     ///< mean cook time of the items
+  unsigned int max_ms;                                      ///< longest cook time of the items
+  uint16_t slot[MENU_SLOTS];                                ///< hash table: item index + 1, 0 free
+} Menu;
+
+extern const Menu *menu;                                    ///< the menu; NULL until menu_load()
+
+/// @}
+
+/// @name Menu
+/// @{
+
+/// @brief load the menu from the file @a path, or the built-in menu of burger.c if @a path is
+///        NULL. Every line of a menu file names one burger:
+///          <name> <cook_ms> [<station>] [<prep>:<grill>:<assemble>]
+///        The stage weights split cook_ms among the stages of the pipelined kitchen (default
+///        30:40:30). Burgers without a station share the station "kitchen". Empty lines and
+///        lines starting with '#' are ignored. The file is validated as a whole; errors are
+///        printed with their line number.
+/// @param path menu file or NULL
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code (EINVAL for an invalid menu)
+int menu_load(const char *path);
+
+/// @brief look up a burger by name
+/// @param name burger name (not necessarily NUL-terminated)
+/// @param len length of @a name
+/// @retval burger type
+/// @retval MENU_MAX if the burger is not on the menu
+unsigned int menu_lookup(const char *name, size_t len);
+
+/// @}
+
+#endif // __MENU_H__
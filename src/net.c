@@ -10,6 +10,13 @@
 /// 2017/11/24 Bernhard Egger added put/get_line functions
 /// 2017/12/06 Bernhard Egger added getsocklist() & cleanup
 /// 2020/11/25 Bernhard Egger cleanup & minor bugfixes
+/// 2026/10/19 ARC lab add get_some() for streamed requests
+/// 2026/10/19 ARC lab add send_fds()/recv_fds() for socket handoff
+/// 2026/10/19 ARC lab add io_uring backend, put_get(), registered buffers and acceptors
+/// 2026/10/19 ARC lab Unix domain sockets in getsocklist(), acceptors with several sockets
+/// 2026/10/19 ARC lab listen_socket() with backlog, TCP Fast Open and deferred accept; drain accepts
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+/// 2026/10/19 ARC lab acceptors back off when out of file descriptors
 ///
 /// @section license_section License
 /// Copyright (c) 2016-2023, Computer Systems and Platforms Laboratory, SNU
@@ -35,16 +42,31 @@
 /// DAMAGE.
 //--------------------------------------------------------------------------------------------------
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <poll.h>
+#include <time.h>
 
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 
 #include "net.h"
+#include "uring.h"
+#include "lockprof.h"
+
+const char *net_backend_names[NET_BACKEND_MAX] = { "posix", "io_uring" };
 
 struct addrinfo *getsocklist(const char *host, unsigned short port, int family, int type, 
                              int listening, int *res)
@@ -53,6 +75,34 @@ struct addrinfo *getsocklist(const char *host, unsigned short port, int family,
   struct addrinfo hints, *ai;
   int r;
 
+  // Unix domain socket: @a host is the path. Address and addrinfo live in one allocation.
+  if (family == AF_UNIX) {
+    struct {
+      struct addrinfo ai;
+      struct sockaddr_un sa;
+    } *u;
+
+    if ((host == NULL) || (host[0] == '\0') || (strlen(host) >= sizeof(u->sa.sun_path))) {
+      if (res) *res = EAI_NONAME;
+      return NULL;
+    }
+    u = calloc(1, sizeof(*u));
+    if (u == NULL) {
+      if (res) *res = EAI_MEMORY;
+      return NULL;
+    }
+
+    u->sa.sun_family = AF_UNIX;
+    strcpy(u->sa.sun_path, host);
+    u->ai.ai_family = AF_UNIX;
+    u->ai.ai_socktype = type;
+    u->ai.ai_addr = (struct sockaddr *)&u->sa;
+    u->ai.ai_addrlen = sizeof(u->sa);
+
+    if (res) *res = 0;
+    return &u->ai;
+  }
+
   memset(&hints, 0, sizeof(hints));
   hints.ai_family   = family;
   hints.ai_socktype = type;
@@ -68,6 +118,39 @@ struct addrinfo *getsocklist(const char *host, unsigned short port, int family,
   else return ai;
 }
 
+void freesocklist(struct addrinfo *ai)
+{
+  if (ai == NULL) return;
+  if (ai->ai_family == AF_UNIX) free(ai);
+  else freeaddrinfo(ai);
+}
+
+int listen_socket(int fd, int backlog, int fastopen, int defer)
+{
+  int domain;
+  socklen_t len = sizeof(domain);
+
+  // Options of the listening socket are inherited by every accepted connection; set them first
+  if ((getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &len) == 0) &&
+      ((domain == AF_INET) || (domain == AF_INET6))) {
+    if (fastopen > 0) setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &fastopen, sizeof(fastopen));
+    if (defer > 0) setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer, sizeof(defer));
+  }
+
+  return listen(fd, backlog);
+}
+
+int listen_backlog_max(void)
+{
+  FILE *f = fopen("/proc/sys/net/core/somaxconn", "r");
+  int max = -1;
+
+  if (f == NULL) return -1;
+  if (fscanf(f, "%d", &max) != 1) max = -1;
+  fclose(f);
+  return max;
+}
+
 void dump_sockaddr(struct sockaddr *sa)
 {
   char adrstr[40];
@@ -88,6 +171,9 @@ void dump_sockaddr(struct sockaddr *sa)
     } else {
       printf("%s:%d (IPv6)", adrstr, ntohs(sa6->sin6_port));
     }
+  } else if (sa->sa_family == AF_UNIX) {
+    // Unix domain socket
+    printf("%s (Unix)", ((struct sockaddr_un *)sa)->sun_path);
   } else {
     // unsupported
     printf("unknown protocol family (neither IPv4 nor IPv6)\n");
@@ -99,15 +185,147 @@ void dump_sockaddr(struct sockaddr *sa)
 #define NET_RECV 0
 #define NET_SEND 1
 
+/// @brief io_uring of a thread with its registered buffer. Rings are created on first use and
+///        returned to a pool when the thread exits, so short-lived serving threads reuse them.
+typedef struct __net_ring {
+  Uring ring;                                               ///< io_uring instance
+  char *buf;                                                ///< registered buffer (or NULL)
+  bool buf_used;                                            ///< buffer handed out
+  struct __net_ring *next;                                  ///< next ring in the pool
+} NetRing;
+
+static int backend = NET_POSIX;                             ///< backend in use
+static pthread_key_t ring_key;                              ///< returns rings to the pool
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER; ///< protects pool
+static NetRing *pool = NULL;                                ///< rings of exited threads
+static __thread NetRing *my_ring = NULL;                    ///< ring of this thread
+static __thread bool no_ring = false;                       ///< ring setup failed; use syscalls
+
+/// @brief create a ring and register its fixed buffer. A failed registration only costs the
+///        zero-copy receive; the ring is used anyway.
+static NetRing* new_ring(void)
+{
+  NetRing *r = (NetRing *)calloc(1, sizeof(NetRing));
+  struct iovec iov;
+
+  if (r == NULL) return NULL;
+  if (uring_init(&r->ring, NET_RING_ENTRIES) < 0) {
+    free(r);
+    return NULL;
+  }
+
+  r->buf = (char *)mmap(NULL, NET_FIXED_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (r->buf == MAP_FAILED) {
+    r->buf = NULL;
+  } else {
+    iov.iov_base = r->buf;
+    iov.iov_len = NET_FIXED_SIZE;
+    if (uring_register_buffers(&r->ring, &iov, 1) < 0) {
+      munmap(r->buf, NET_FIXED_SIZE);
+      r->buf = NULL;
+    }
+  }
+
+  return r;
+}
+
+/// @brief thread exit: return the ring of the thread to the pool
+static void put_ring(void *data)
+{
+  NetRing *r = (NetRing *)data;
+
+  r->buf_used = false;
+  pthread_mutex_lock(&pool_lock);
+  r->next = pool;
+  pool = r;
+  pthread_mutex_unlock(&pool_lock);
+}
+
+/// @brief get the ring of the calling thread
+/// @retval NULL if the posix backend is in use or the thread cannot get a ring
+static NetRing* get_ring(void)
+{
+  if ((backend != NET_URING) || no_ring) return NULL;
+  if (my_ring != NULL) return my_ring;
+
+  pthread_mutex_lock(&pool_lock);
+  my_ring = pool;
+  if (my_ring != NULL) pool = my_ring->next;
+  pthread_mutex_unlock(&pool_lock);
+
+  if (my_ring == NULL) my_ring = new_ring();
+  if (my_ring == NULL) {
+    no_ring = true;
+    return NULL;
+  }
+  pthread_setspecific(ring_key, my_ring);
+
+  return my_ring;
+}
+
+/// @brief true if [@a buf, @a buf + @a len) lies in the registered buffer of @a r
+static bool is_fixed(NetRing *r, const char *buf, size_t len)
+{
+  return (r->buf != NULL) && (buf >= r->buf) && (buf + len <= r->buf + NET_FIXED_SIZE);
+}
+
+/// @brief queue a receive or send of @a buf on the ring. Uses the registered buffer if possible.
+static void prep_io(NetRing *r, struct io_uring_sqe *sqe, int mode, int sock, char *buf,
+                    size_t len, int flags)
+{
+  if (is_fixed(r, buf, len)) {
+    if (mode == NET_RECV) uring_prep_read_fixed(sqe, sock, buf, len, 0);
+    else uring_prep_write_fixed(sqe, sock, buf, len, 0);
+  } else {
+    if (mode == NET_RECV) uring_prep_recv(sqe, sock, buf, len, flags);
+    else uring_prep_send(sqe, sock, buf, len, flags);
+  }
+}
+
+/// @brief wait for the next completion on the ring of the thread
+/// @retval result of the operation (-errno on error)
+static int ring_result(NetRing *r, uint64_t *user_data)
+{
+  struct io_uring_cqe *cqe;
+  int res;
+
+  if (uring_submit_and_wait(&r->ring, 1) < 0) return -errno;
+
+  cqe = uring_peek_cqe(&r->ring);
+  res = cqe->res;
+  if (user_data) *user_data = cqe->user_data;
+  uring_cqe_seen(&r->ring);
+
+  return res;
+}
+
+/// @brief one receive or send through the ring; behaves like recv()/send()
+static int ring_io(NetRing *r, int mode, int sock, char *buf, size_t len)
+{
+  int res;
+
+  prep_io(r, uring_get_sqe(&r->ring), mode, sock, buf, len, 0);
+  res = ring_result(r, NULL);
+  if (res < 0) {
+    errno = -res;
+    return -1;
+  }
+
+  return res;
+}
+
 static int transfer_data(int mode, int sock, char *buf, size_t len)
 {
   if (!((mode == NET_RECV) || (mode == NET_SEND)) || (buf == NULL)) return -2;
 
+  NetRing *ring = get_ring();
   int res = 0;
 
   while (len > 0) {
     int r;
-    if (mode == NET_RECV) r = recv(sock, buf, len, 0);
+    if (ring != NULL) r = ring_io(ring, mode, sock, buf, len);
+    else if (mode == NET_RECV) r = recv(sock, buf, len, 0);
     else r = send(sock, buf, len, 0);
 
     if (r > 0) {
@@ -132,6 +350,57 @@ static int transfer_data(int mode, int sock, char *buf, size_t len)
 }
 /// @endinternal
 
+int net_init(int b)
+{
+  NetRing *r;
+
+  if ((b != NET_URING) || (backend == NET_URING)) return backend;
+
+  // Probe io_uring with the first ring of the pool
+  if (pthread_key_create(&ring_key, put_ring) != 0) return backend;
+  r = new_ring();
+  if (r == NULL) {
+    pthread_key_delete(ring_key);
+    return backend;
+  }
+  put_ring(r);
+  backend = NET_URING;
+
+  return backend;
+}
+
+int net_backend(void)
+{
+  return backend;
+}
+
+int net_parse_backend(const char *name)
+{
+  for (int i = 0; i < NET_BACKEND_MAX; i++) {
+    if (strcmp(name, net_backend_names[i]) == 0) return i;
+  }
+  return -1;
+}
+
+char* net_alloc_buffer(size_t len)
+{
+  NetRing *r = get_ring();
+
+  if ((r != NULL) && (r->buf != NULL) && !r->buf_used && (len <= NET_FIXED_SIZE)) {
+    r->buf_used = true;
+    return r->buf;
+  }
+  return (char *)malloc(len);
+}
+
+void net_free_buffer(char *buf)
+{
+  NetRing *r = my_ring;
+
+  if ((r != NULL) && (buf == r->buf) && (buf != NULL)) r->buf_used = false;
+  else free(buf);
+}
+
 int get_data(int sock, char *buf, size_t len)
 {
   return transfer_data(NET_RECV, sock, buf, len);
@@ -142,6 +411,67 @@ int put_data(int sock, char *buf, size_t len)
   return transfer_data(NET_SEND, sock, buf, len);
 }
 
+int get_some(int sock, char *buf, size_t len)
+{
+  if ((buf == NULL) || (len == 0)) return -2;
+
+  NetRing *ring = get_ring();
+  int r;
+
+  do {
+    if (ring != NULL) r = ring_io(ring, NET_RECV, sock, buf, len);
+    else r = recv(sock, buf, len, 0);
+  } while ((r < 0) && (errno == EINTR));
+
+  return r;
+}
+
+int put_get(int sock, char *out, size_t outlen, char *in, size_t inlen)
+{
+  if ((out == NULL) || (outlen == 0) || (in == NULL) || (inlen == 0)) return -2;
+
+  NetRing *ring = get_ring();
+  struct io_uring_sqe *sqe;
+  uint64_t user_data = 0;
+  int res, sent = 0, got = 0;
+
+  if (ring == NULL) {
+    if (put_data(sock, out, outlen) <= 0) return -1;
+    return get_some(sock, in, inlen);
+  }
+
+  // Link the receive to the send: both are submitted with one system call, and the receive is
+  // cancelled if the send fails
+  sqe = uring_get_sqe(&ring->ring);
+  prep_io(ring, sqe, NET_SEND, sock, out, outlen, MSG_WAITALL);
+  sqe->flags |= IOSQE_IO_LINK;
+  sqe->user_data = NET_SEND;
+  sqe = uring_get_sqe(&ring->ring);
+  prep_io(ring, sqe, NET_RECV, sock, in, inlen, 0);
+  sqe->user_data = NET_RECV;
+
+  for (int i = 0; i < 2; i++) {
+    res = ring_result(ring, &user_data);
+    if (user_data == NET_SEND) sent = res;
+    else got = res;
+  }
+
+  // A short send (signal) breaks the link: finish the send, and receive again if the receive
+  // was cancelled
+  if (sent < 0) {
+    errno = -sent;
+    return -1;
+  }
+  if (((size_t)sent < outlen) && (put_data(sock, out + sent, outlen - sent) <= 0)) return -1;
+  if ((got == -ECANCELED) || (got == -EINTR)) return get_some(sock, in, inlen);
+  if (got < 0) {
+    errno = -got;
+    return -1;
+  }
+
+  return got;
+}
+
 int get_line(int sock, char **buf, size_t *cur_len)
 {
   if (*cur_len == 0) return -2;
@@ -176,13 +506,39 @@ int put_line(int sock, char *buf, size_t len)
 {
   if (len == 0) return -2;
 
-  char c;
+  NetRing *ring = get_ring();
+  char c = '\n';
   int res = 1, res2;
   size_t pos = 0;
 
   // find end of string (terminating '\0')
   while ((pos < len) && (buf[pos] != '\0')) pos++;
 
+  // io_uring: send the line and the missing '\n' with a single sendmsg
+  if ((ring != NULL) && (pos > 0) && (buf[pos-1] != '\n')) {
+    struct iovec iov[2] = { { .iov_base = buf, .iov_len = pos }, { .iov_base = &c, .iov_len = 1 } };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+
+    uring_prep_sendmsg(uring_get_sqe(&ring->ring), sock, &msg, MSG_WAITALL);
+    res = ring_result(ring, NULL);
+    if (res == (int)pos + 1) return res;
+    if (res < 0) {
+      if (res != -EINTR) {
+        errno = -res;
+        return -1;
+      }
+      res = 0;
+    }
+    // short send: send the rest below
+    if ((size_t)res < pos) {
+      res2 = put_data(sock, buf + res, pos - res);
+      if (res2 < 0) return res2;
+      res += res2;
+    }
+    res2 = put_data(sock, &c, 1);
+    return (res2 < 0) ? res2 : res + res2;
+  }
+
   // there was some data (not just a '\0'), send it (exclude terminating '\0')
   if (pos > 0) {
     res = put_data(sock, buf, pos);
@@ -190,7 +546,6 @@ int put_line(int sock, char *buf, size_t len)
 
   // send '\n' if string wasn't ended by it
   if ((res > 0) && (buf[pos-1] != '\n')) {
-    c = '\n';
     res2 = put_data(sock, &c, 1);
     if (res2 < 0) res = res2;
     else res += res2;
@@ -200,3 +555,269 @@ int put_line(int sock, char *buf, size_t len)
   return res;
 }
 
+/// @internal
+#define MAX_FDS 16
+/// @endinternal
+
+int send_fds(int sock, int *fds, int n)
+{
+  if ((fds == NULL) || (n <= 0) || (n > MAX_FDS)) return -2;
+
+  char tag = 'F';
+  struct iovec iov = { .iov_base = &tag, .iov_len = 1 };
+  union {
+    char buf[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+    struct cmsghdr align;
+  } ctrl;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  int r;
+
+  // at least one byte of regular data must accompany the ancillary data
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * n);
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * n);
+
+  do {
+    r = sendmsg(sock, &msg, 0);
+  } while ((r < 0) && (errno == EINTR));
+
+  return r;
+}
+
+int recv_fds(int sock, int *fds, int max)
+{
+  if ((fds == NULL) || (max <= 0) || (max > MAX_FDS)) return -2;
+
+  char tag;
+  struct iovec iov = { .iov_base = &tag, .iov_len = 1 };
+  union {
+    char buf[CMSG_SPACE(sizeof(int) * MAX_FDS)];
+    struct cmsghdr align;
+  } ctrl;
+  struct msghdr msg;
+  struct cmsghdr *cmsg;
+  int r, n = 0;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = ctrl.buf;
+  msg.msg_controllen = sizeof(ctrl.buf);
+
+  do {
+    r = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+  } while ((r < 0) && (errno == EINTR));
+  if (r <= 0) return r;
+
+  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)) {
+      int cnt = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      if (cnt > max) cnt = max;
+      memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * cnt);
+      n = cnt;
+    }
+  }
+
+  return n;
+}
+
+/// @internal
+#define ACCEPT_TAG   0x100                                  ///< user data of the accept on listenfd[0]
+#define CANCEL_TAG   0xffff                                 ///< user data of the cancels
+
+/// @brief acceptor: waits for connections on a listening socket and events on watched fds
+struct __acceptor {
+  int nlisten;                                              ///< number of listening sockets
+  int listenfd[ACCEPT_LISTEN_MAX];                          ///< listening sockets
+  int nwatch;                                               ///< number of watched fds
+  int watch[ACCEPT_WATCH_MAX];                              ///< watched fds
+  bool use_ring;                                            ///< io_uring or poll()
+  Uring ring;                                               ///< io_uring of the acceptor
+  bool multishot;                                           ///< multishot accept supported
+  bool accepting[ACCEPT_LISTEN_MAX];                        ///< accept on listenfd[i] submitted
+  int naccepting;                                           ///< number of accepts submitted
+  bool polling[ACCEPT_WATCH_MAX];                           ///< poll of watch[i] submitted
+  unsigned int events;                                      ///< events seen while stopping
+  bool exhausted;                                           ///< an accept ran out of fds
+};
+
+/// @brief collect the completions of the acceptor ring
+static int harvest(Acceptor *a, int *fds, int max, unsigned int *events)
+{
+  struct io_uring_cqe *cqe;
+  int n = 0;
+
+  while ((n < max) && ((cqe = uring_peek_cqe(&a->ring)) != NULL)) {
+    uint64_t user_data = cqe->user_data;
+    int res = cqe->res;
+    unsigned int flags = cqe->flags;
+
+    uring_cqe_seen(&a->ring);
+
+    if ((user_data >= ACCEPT_TAG) && (user_data < ACCEPT_TAG + (uint64_t)a->nlisten)) {
+      // a multishot accept stays armed as long as the kernel says there is more to come
+      if (!(flags & IORING_CQE_F_MORE)) {
+        a->accepting[user_data - ACCEPT_TAG] = false;
+        a->naccepting--;
+      }
+      if (res >= 0) fds[n++] = res;
+      else if ((res == -EINVAL) && a->multishot) a->multishot = false;
+      else if ((res == -EMFILE) || (res == -ENFILE)) a->exhausted = true;
+    } else if (user_data <= (uint64_t)a->nwatch) {
+      a->polling[user_data - 1] = false;
+      if (res > 0) *events |= 1u << (user_data - 1);
+    }
+  }
+
+  return n;
+}
+/// @endinternal
+
+Acceptor* new_acceptor(int *listenfds, int nlisten, int *watch, int nwatch)
+{
+  if ((nlisten <= 0) || (nlisten > ACCEPT_LISTEN_MAX)) return NULL;
+  if ((nwatch < 0) || (nwatch > ACCEPT_WATCH_MAX)) return NULL;
+
+  Acceptor *a = (Acceptor *)calloc(1, sizeof(Acceptor));
+  if (a == NULL) return NULL;
+
+  a->nlisten = nlisten;
+  for (int i = 0; i < nlisten; i++) a->listenfd[i] = listenfds[i];
+  a->nwatch = nwatch;
+  for (int i = 0; i < nwatch; i++) a->watch[i] = watch[i];
+
+  // Fall back to poll() if the acceptor cannot get its own ring
+  a->use_ring = (backend == NET_URING) && (uring_init(&a->ring, ACCEPT_RING_ENTRIES) == 0);
+  a->multishot = true;
+
+  // poll() drains non-blocking sockets. An accept of io_uring fails right away on them instead of
+  // waiting; a socket taken over from a server with another backend may have either mode.
+  for (int i = 0; i < nlisten; i++) {
+    int flags = fcntl(listenfds[i], F_GETFL);
+
+    if (flags < 0) continue;
+    flags = a->use_ring ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+    fcntl(listenfds[i], F_SETFL, flags);
+  }
+
+  return a;
+}
+
+void free_acceptor(Acceptor *a)
+{
+  if (a == NULL) return;
+  if (a->use_ring) uring_exit(&a->ring);
+  free(a);
+}
+
+int accept_some(Acceptor *a, int *fds, int max, unsigned int *events)
+{
+  if ((a == NULL) || (fds == NULL) || (max <= 0) || (events == NULL)) return -2;
+
+  struct pollfd pfd[ACCEPT_LISTEN_MAX + ACCEPT_WATCH_MAX];
+  struct io_uring_sqe *sqe;
+  struct timespec backoff = { 0, ACCEPT_BACKOFF_MS * 1000000L };
+  unsigned int wait_nr = 1;
+  int i, fd, n = 0, l = a->nlisten, timeout = -1;
+  bool exhausted = a->exhausted;
+
+  *events = 0;
+  a->exhausted = false;
+
+  if (!a->use_ring) {
+    // Out of fds, the listening sockets stay readable; skip them (poll ignores fd -1) for a while
+    for (i = 0; i < l; i++) {
+      pfd[i].fd = exhausted ? -1 : a->listenfd[i];
+      pfd[i].events = POLLIN;
+    }
+    for (i = 0; i < a->nwatch; i++) {
+      pfd[l + i].fd = a->watch[i];
+      pfd[l + i].events = POLLIN;
+    }
+    if (exhausted) timeout = ACCEPT_BACKOFF_MS;
+
+    if (poll(pfd, l + a->nwatch, timeout) < 0) return (errno == EINTR) ? 0 : -1;
+
+    for (i = 0; i < a->nwatch; i++) {
+      if (pfd[l + i].revents & (POLLIN | POLLHUP)) *events |= 1u << i;
+    }
+    // Take every connection that is waiting, so a storm empties the backlog before it overflows
+    for (i = 0; (i < l) && (n < max); i++) {
+      if (!(pfd[i].revents & POLLIN)) continue;
+      while (n < max) {
+        fd = accept4(a->listenfd[i], NULL, NULL, SOCK_CLOEXEC);
+        if (fd >= 0) fds[n++] = fd;
+        else if ((errno == EMFILE) || (errno == ENFILE)) {
+          a->exhausted = true;
+          break;
+        } else if (errno != EINTR) break;
+      }
+    }
+    return n;
+  }
+
+  // Out of fds, wait before the accepts are armed again
+  if (exhausted) nanosleep(&backoff, NULL);
+
+  // (Re-)arm the accepts and the polls of the watched fds that fired
+  for (i = 0; i < l; i++) {
+    if (a->accepting[i]) continue;
+    sqe = uring_get_sqe(&a->ring);
+    uring_prep_accept(sqe, a->listenfd[i], SOCK_CLOEXEC, a->multishot);
+    sqe->user_data = ACCEPT_TAG + i;
+    a->accepting[i] = true;
+    a->naccepting++;
+  }
+  for (i = 0; i < a->nwatch; i++) {
+    if (!a->polling[i] && (a->watch[i] >= 0)) {
+      sqe = uring_get_sqe(&a->ring);
+      uring_prep_poll(sqe, a->watch[i], POLLIN);
+      sqe->user_data = i + 1;
+      a->polling[i] = true;
+    }
+  }
+
+  // Report events seen while stopping right away
+  if (a->events) {
+    *events = a->events;
+    a->events = 0;
+    wait_nr = 0;
+  }
+
+  if (uring_submit_and_wait(&a->ring, wait_nr) < 0) return -1;
+
+  return harvest(a, fds, max, events);
+}
+
+int stop_accepting(Acceptor *a, int *fds, int max)
+{
+  if ((a == NULL) || (fds == NULL) || (max <= 0)) return -2;
+  if (!a->use_ring || (a->naccepting == 0)) return 0;
+
+  struct io_uring_sqe *sqe;
+  int i, n = 0;
+
+  for (i = 0; i < a->nlisten; i++) {
+    if (!a->accepting[i]) continue;
+    sqe = uring_get_sqe(&a->ring);
+    uring_prep_cancel(sqe, ACCEPT_TAG + i);
+    sqe->user_data = CANCEL_TAG;
+  }
+
+  // Connections accepted before the cancels took effect belong to us
+  while ((a->naccepting > 0) && (n < max)) {
+    if (uring_submit_and_wait(&a->ring, 1) < 0) return (n > 0) ? n : -1;
+    n += harvest(a, fds + n, max - n, &a->events);
+  }
+
+  return n;
+}
@@ -10,6 +10,12 @@
 /// 2017/11/24 Bernhard Egger added put/get_line functions
 /// 2017/12/06 Bernhard Egger added getsocklist() & cleanup
 /// 2020/11/25 Bernhard Egger cleanup & minor bugfixes
+/// 2026/10/19 ARC lab add get_some() for streamed requests
+/// 2026/10/19 ARC lab add send_fds()/recv_fds() for socket handoff
+/// 2026/10/19 ARC lab add io_uring backend, put_get(), registered buffers and acceptors
+/// 2026/10/19 ARC lab Unix domain sockets in getsocklist(), acceptors with several sockets
+/// 2026/10/19 ARC lab listen_socket() with backlog, TCP Fast Open and deferred accept; drain accepts
+/// 2026/10/19 ARC lab acceptors back off when out of file descriptors
 ///
 /// @section license_section License
 /// Copyright (c) 2016-2023, Computer Systems and Platforms Laboratory, SNU
@@ -36,16 +42,72 @@
 //--------------------------------------------------------------------------------------------------
 
 #ifndef __NET_H__
+#define __NET_H__
 
 #include <sys/socket.h>
 
+/// @name I/O backends
+/// @{
+
+/// @brief how sockets are read and written
+enum net_backend {
+  NET_POSIX,                                                ///< one system call per operation
+  NET_URING,                                                ///< io_uring
+  NET_BACKEND_MAX
+};
+
+extern const char *net_backend_names[NET_BACKEND_MAX];      ///< names of the backends
+
+#define NET_RING_ENTRIES    8                               ///< SQ entries of a thread's ring
+#define NET_FIXED_SIZE      65536                           ///< registered buffer per ring
+#define ACCEPT_RING_ENTRIES 64                              ///< SQ entries of an acceptor ring
+#define ACCEPT_LISTEN_MAX   4                               ///< max. sockets of an acceptor
+#define ACCEPT_WATCH_MAX    4                               ///< max. fds watched by an acceptor
+#define ACCEPT_BACKOFF_MS   100                             ///< pause of accepts without free fds
+#define LISTEN_BACKLOG      4096                            ///< default backlog of listening sockets
+#define LISTEN_FASTOPEN     256                             ///< default TCP Fast Open queue
+
+/// @brief select the I/O backend of all threads. With NET_URING, every thread gets its own ring
+///        with a registered buffer on first use; rings of exited threads are reused. A thread
+///        that cannot set up a ring falls back to system calls.
+/// @param backend requested backend
+/// @retval backend in use: NET_POSIX if io_uring is not available
+int net_init(int backend);
+
+/// @brief get the I/O backend in use
+/// @retval backend
+int net_backend(void);
+
+/// @brief parse the name of a backend
+/// @param name name of the backend
+/// @retval backend
+/// @retval -1 if @a name is not a known backend
+int net_parse_backend(const char *name);
+
+/// @brief allocate a receive buffer. With io_uring, the calling thread gets its registered
+///        buffer if it is large enough and not in use, and data is received into it without
+///        copying. Free the buffer with net_free_buffer() in the same thread.
+/// @param len size of the buffer
+/// @retval buffer
+/// @retval NULL on error
+char* net_alloc_buffer(size_t len);
+
+/// @brief free a buffer allocated with net_alloc_buffer()
+/// @param buf buffer
+void net_free_buffer(char *buf);
+
+/// @}
+
 /// @name network helper functions
 /// @{
 
-/// @brief wrapper for getaddrinfo(). Make sure to free the returned structure with freeaddrinfo().
-/// @param host   host string (URL or IP in decimal dotted notation)
+/// @brief wrapper for getaddrinfo(). Make sure to free the returned structure with freesocklist().
+///        For AF_UNIX, @a host is the path of the socket (also for listening sockets), and
+///        @a port is ignored.
+/// @param host   host string (URL or IP in decimal dotted notation), or path for AF_UNIX
 /// @param port   port
-/// @param family network family (AF_INET: IPv4, AF_INET6: IPv6, AF_UNSPEC: IPv4/6)
+/// @param family network family (AF_INET: IPv4, AF_INET6: IPv6, AF_UNSPEC: IPv4/6,
+///               AF_UNIX: Unix domain socket)
 /// @param type   socket type (SOCK_STREAM: TCP, SOCK_DGRAM: UDP)
 /// @param listening >0 for listening sockets, ==0 for connecting sockets
 /// @param res    if not NULL, holds result of getaddrinfo() call.
@@ -55,6 +117,28 @@
 struct addrinfo *getsocklist(const char *host, unsigned short port, int family, int type, 
                              int listening, int *res);
 
+/// @brief free a list returned by getsocklist()
+/// @param ai list of addrinfos
+void freesocklist(struct addrinfo *ai);
+
+/// @brief start listening on a bound socket. For TCP sockets, TCP Fast Open lets clients send
+///        their first data in the SYN (the system must allow it, net.ipv4.tcp_fastopen & 2), and
+///        a deferred accept hands a connection to accept() only once data has arrived.
+///        Both are ignored for other sockets.
+/// @param fd bound socket
+/// @param backlog max. connections waiting to be accepted; the kernel caps it at
+///        net.core.somaxconn
+/// @param fastopen max. pending Fast Open connections (0: no Fast Open)
+/// @param defer seconds to wait for data before a connection is accepted anyway (0: don't wait)
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code
+int listen_socket(int fd, int backlog, int fastopen, int defer);
+
+/// @brief get the max. backlog of listening sockets (net.core.somaxconn)
+/// @retval max. backlog
+/// @retval -1 if unknown
+int listen_backlog_max(void);
+
 /// @brief dump a sockaddr structure to stdout in human readable form.
 /// @param sa pointer to sockaddr struct
 void dump_sockaddr(struct sockaddr *sa);
@@ -86,6 +170,32 @@ int get_data(int sock, char *buf, size_t len);
 /// @retval -2 invalid arguments
 int put_data(int sock, char *buf, size_t len);
 
+/// @brief read up to @a len bytes from @a sock into @a buf. Blocks until at least one byte is
+///        available, and survives interrupts caused by signals. Use this to consume a stream
+///        incrementally whose total length is unknown.
+/// @param sock socket to read from
+/// @param buf pointer to data buffer
+/// @param len size of data buffer
+/// @retval >0 number of bytes read
+/// @retval == 0 nothing read (socket closed by peer)
+/// @retval -1 error, errno contains error code
+/// @retval -2 invalid arguments
+int get_some(int sock, char *buf, size_t len);
+
+/// @brief write @a outlen bytes from @a out to @a sock, then read up to @a inlen bytes into @a in
+///        like get_some(). With io_uring, the send and the receive are submitted together with
+///        one system call. Use this for a greeting that is answered by the peer.
+/// @param sock socket
+/// @param out data to send
+/// @param outlen number of bytes to send
+/// @param in receive buffer
+/// @param inlen size of receive buffer
+/// @retval >0 number of bytes read
+/// @retval == 0 nothing read (socket closed by peer)
+/// @retval -1 error sending or receiving, errno contains error code
+/// @retval -2 invalid arguments
+int put_get(int sock, char *out, size_t outlen, char *in, size_t inlen);
+
 /// @}
 
 /// @name sending/receiving of '\n'-terminated strings
@@ -116,5 +226,80 @@ int put_line(int sock, char *buf, size_t len);
 
 /// @}
 
+/// @name passing of file descriptors over Unix domain sockets
+/// @{
+
+/// @brief send the file descriptors @a fds to the process at the other end of the Unix domain
+///        socket @a sock (SCM_RIGHTS). The receiver gets duplicates that refer to the same open
+///        files/sockets.
+/// @param sock connected AF_UNIX socket
+/// @param fds file descriptors to send
+/// @param n number of file descriptors (at most 16)
+/// @retval >0 success
+/// @retval -1 error, errno contains error code
+/// @retval -2 invalid arguments
+int send_fds(int sock, int *fds, int n);
+
+/// @brief receive file descriptors sent with send_fds() from @a sock.
+/// @param sock connected AF_UNIX socket
+/// @param fds array receiving the file descriptors
+/// @param max size of @a fds (at most 16)
+/// @retval >0 number of file descriptors received
+/// @retval == 0 nothing received (socket closed by peer)
+/// @retval -1 error, errno contains error code
+/// @retval -2 invalid arguments
+int recv_fds(int sock, int *fds, int max);
+
+/// @}
+
+/// @name accepting connections
+/// @{
+
+/// @brief acceptor (opaque)
+typedef struct __acceptor Acceptor;
+
+/// @brief create an acceptor for up to four listening sockets that also watches up to four fds for
+///        input. With io_uring, multishot accepts keep accepting connections in the kernel, and
+///        one system call harvests all of them. Otherwise, the listening sockets are made
+///        non-blocking, and every wakeup of poll() drains them with accept4() until they are
+///        empty. Accepted connections are close-on-exec and blocking.
+/// @param listenfds listening sockets
+/// @param nlisten number of sockets in @a listenfds
+/// @param watch fds to watch for input (negative fds are ignored)
+/// @param nwatch number of fds in @a watch
+/// @retval acceptor
+/// @retval NULL on error
+Acceptor* new_acceptor(int *listenfds, int nlisten, int *watch, int nwatch);
+
+/// @brief free an acceptor. Does not close any fd.
+/// @param a acceptor
+void free_acceptor(Acceptor *a);
+
+/// @brief wait until connections arrive or a watched fd becomes readable. Out of file
+///        descriptors (EMFILE, ENFILE), the acceptor leaves its listening sockets alone for
+///        ACCEPT_BACKOFF_MS, so that a pending connection does not keep it spinning; watched fds
+///        are still reported.
+/// @param a acceptor
+/// @param fds receives the accepted connections
+/// @param max size of @a fds
+/// @param events bit i is set if watch[i] is readable. Out parameter.
+/// @retval >=0 number of accepted connections (0: only events or interrupted by a signal)
+/// @retval -1 error, errno contains error code
+/// @retval -2 invalid arguments
+int accept_some(Acceptor *a, int *fds, int max, unsigned int *events);
+
+/// @brief stop accepting, e.g., before handing the listening socket over. With io_uring, the
+///        kernel may have accepted connections that were not harvested yet; they are returned
+///        and must be served by the caller. Call until it returns 0. accept_some() resumes.
+/// @param a acceptor
+/// @param fds receives the accepted connections
+/// @param max size of @a fds
+/// @retval >=0 number of accepted connections
+/// @retval -1 error, errno contains error code
+/// @retval -2 invalid arguments
+int stop_accepting(Acceptor *a, int *fds, int max);
+
+/// @}
+
 
 #endif // __NET_H__
@@ -0,0 +1,474 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  order.c
+/// @brief Requests, order queue and request parser
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab split off from mcdonalds.c
+/// 2026/10/19 ARC lab earliest-deadline-first order queue
+/// 2026/10/19 ARC lab dismiss idle kitchens
+/// 2026/10/19 ARC lab burgers from the menu, looked up by hash
+/// 2026/10/19 ARC lab static tracepoints
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+/// 2026/10/19 ARC lab key=<key> option
+/// 2026/10/19 ARC lab a request has one key
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "order.h"
+#include "menu.h"
+#include "probe.h"
+#include "lockprof.h"
+
+Request* new_request(unsigned int customerID, int clientfd)
+{
+  Request *req = (Request *)calloc(1, sizeof(Request));
+
+  req->customerID = customerID;
+  req->clientfd = clientfd;
+  req->wake_fd = -1;
+  pthread_cond_init(&req->cond, NULL);
+  pthread_mutex_init(&req->cond_mutex, NULL);
+
+  return req;
+}
+
+void free_request(Request *req)
+{
+  pthread_cond_destroy(&req->cond);
+  pthread_mutex_destroy(&req->cond_mutex);
+  free(req->order_str);
+  free(req->ready_str);
+  if (req->wake_fd >= 0) close(req->wake_fd);
+  free(req);
+}
+
+void release_request(Request *req)
+{
+  pthread_mutex_lock(&req->cond_mutex);
+  if (req->remain_count > 0) {
+    req->orphaned = true;
+    pthread_mutex_unlock(&req->cond_mutex);
+    return;
+  }
+  pthread_mutex_unlock(&req->cond_mutex);
+
+  free_request(req);
+}
+
+void wake_request(Request *req)
+{
+  uint64_t one = 1;
+
+  PROBE2(wakeup, req->customerID, req->remain_count);
+  pthread_cond_signal(&req->cond);
+  if (req->polling && (write(req->wake_fd, &one, sizeof(one)) < 0)) {}
+}
+
+int parse_option(Request *req, char *option)
+{
+  char *value = strchr(option, '=');
+
+  *value++ = '\0';
+
+  if (strcmp(option, "stream") == 0) {
+    req->stream = (atoi(value) != 0);
+    return 0;
+  }
+
+  // deadline=<sec>: the customer must be served within <sec> seconds of arriving
+  if (strcmp(option, "deadline") == 0) {
+    char *end;
+    double sec = strtod(value, &end);
+
+    if ((end == value) || (*end != '\0') || !(sec > 0) || (sec > 4000000)) return -1;
+    req->deadline_ns = req->arrived_ns + (uint64_t)(sec * 1e9);
+    return 0;
+  }
+
+  // key=<key>: a retry with the same key collects the burgers of the first request. A request
+  // has one key; the first one may have been claimed already.
+  if (strcmp(option, "key") == 0) {
+    size_t i, len = strlen(value);
+
+    if ((len == 0) || req->key[0]) return -1;
+    for (i = 0; i < len; i++) {
+      if (!isalnum((unsigned char)value[i]) && !strchr("-_.:", value[i])) return -1;
+    }
+    memcpy(req->key, value, len + 1);
+    return 0;
+  }
+
+  return -1;
+}
+
+/// @brief true if order @a a is made before order @a b
+static inline bool node_before(const Node *a, const Node *b)
+{
+  return (a->deadline < b->deadline) || ((a->deadline == b->deadline) && (a->seq < b->seq));
+}
+
+/// @brief add an order to the heap. The list lock must be held and the heap large enough.
+static void heap_push(OrderList *list, Node *node)
+{
+  unsigned int i = list->nheap++, parent;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (!node_before(node, list->heap[parent])) break;
+    list->heap[i] = list->heap[parent];
+    i = parent;
+  }
+  list->heap[i] = node;
+}
+
+/// @brief remove the order with the earliest deadline from the heap. The list lock must be held
+///        and the heap not empty.
+static Node* heap_pop(OrderList *list)
+{
+  Node *top = list->heap[0], *node;
+  unsigned int i = 0, child;
+
+  if (--list->nheap > 0) {
+    node = list->heap[list->nheap];
+    while ((child = 2 * i + 1) < list->nheap) {
+      if ((child + 1 < list->nheap) && node_before(list->heap[child + 1], list->heap[child])) child++;
+      if (!node_before(list->heap[child], node)) break;
+      list->heap[i] = list->heap[child];
+      i = child;
+    }
+    list->heap[i] = node;
+  }
+
+  return top;
+}
+
+void init_orders(OrderList *list)
+{
+  memset(list, 0, sizeof(*list));
+  pthread_mutex_init(&list->lock, NULL);
+  pthread_cond_init(&list->cond, NULL);
+}
+
+void issue_orders(OrderList *list, Request *req, enum burger_type *types,
+                  unsigned int burger_count)
+{
+  Node *head = NULL, *tail = NULL, *node, **heap;
+  unsigned int cap;
+
+  if (burger_count == 0) return;
+
+  // Build the chain of Nodes outside of the lock
+  for (int i=0; i<burger_count; i++){
+    Node *new_node = malloc(sizeof(Node));
+
+    new_node->customerID = req->customerID;
+    new_node->type = types[i];
+    new_node->next = NULL;
+    new_node->deadline = req->deadline_ns;
+    new_node->req = req;
+
+    if (tail == NULL) head = new_node;
+    else tail->next = new_node;
+    tail = new_node;
+  }
+
+  // Account for the orders before a kitchen can possibly make them
+  pthread_mutex_lock(&req->cond_mutex);
+  req->total_count += burger_count;
+  req->remain_count += burger_count;
+  pthread_mutex_unlock(&req->cond_mutex);
+  PROBE3(enqueue, req->customerID, burger_count, req->deadline_ns);
+
+  // Add the whole chain to the list at once, or its Nodes to the heap if they have a deadline,
+  // and wake up as many idle kitchens as needed
+  pthread_mutex_lock(&list->lock);
+  if (req->deadline_ns == 0) {
+    if (list->tail == NULL) {
+      list->head = head;
+    } else {
+      list->tail->next = head;
+    }
+    list->tail = tail;
+  } else {
+    if (list->nheap + burger_count > list->cap) {
+      cap = list->cap ? list->cap : 64;
+      while (list->nheap + burger_count > cap) cap <<= 1;
+      heap = (Node **)realloc(list->heap, cap * sizeof(Node *));
+      if (heap == NULL) {
+        perror("issue_orders");
+        exit(EXIT_FAILURE);
+      }
+      list->heap = heap;
+      list->cap = cap;
+    }
+    for (node = head; node != NULL; node = node->next) {
+      node->seq = list->seq++;
+      heap_push(list, node);
+    }
+  }
+  list->count += burger_count;
+
+  if (burger_count >= list->idle) {
+    pthread_cond_broadcast(&list->cond);
+  } else {
+    for (int i=0; i<burger_count; i++) pthread_cond_signal(&list->cond);
+  }
+  pthread_mutex_unlock(&list->lock);
+}
+
+/// @brief Remove the next order from the OrderList: the one with the earliest deadline, or the
+///        head of the list if no order has a deadline. The list lock must be held.
+/// @param list order list
+/// @retval Node* next order
+/// @retval NULL if the list is empty
+static Node* pop_order(OrderList *list)
+{
+  Node *target_node;
+
+  if (list->nheap > 0) {
+    target_node = heap_pop(list);
+  } else {
+    target_node = list->head;
+    if (target_node == NULL) return NULL;
+    list->head = target_node->next;
+    if (list->head == NULL) list->tail = NULL;
+  }
+  list->count--;
+  PROBE2(dequeue, target_node->customerID, target_node->type);
+
+  return target_node;
+}
+
+Node* get_order(OrderList *list)
+{
+  Node *target_node;
+
+  pthread_mutex_lock(&list->lock);
+  target_node = pop_order(list);
+  pthread_mutex_unlock(&list->lock);
+
+  return target_node;
+}
+
+Node* wait_order(OrderList *list)
+{
+  Node *target_node;
+
+  pthread_mutex_lock(&list->lock);
+  while ((list->count == 0) && !list->closing && (list->dismiss == 0)) {
+    list->idle++;
+    pthread_cond_wait(&list->cond, &list->lock);
+    list->idle--;
+  }
+  target_node = pop_order(list);
+  if ((target_node == NULL) && !list->closing) list->dismiss--;
+  pthread_mutex_unlock(&list->lock);
+
+  return target_node;
+}
+
+Node* wait_order_for(OrderList *list, unsigned int ms, bool *closed)
+{
+  Node *target_node;
+  struct timespec until;
+  int ret;
+
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_sec += ms / 1000;
+  until.tv_nsec += (ms % 1000) * 1000000L;
+  if (until.tv_nsec >= 1000000000L) {
+    until.tv_sec++;
+    until.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&list->lock);
+  while ((list->count == 0) && !list->closing && (list->dismiss == 0)) {
+    list->idle++;
+    ret = pthread_cond_timedwait(&list->cond, &list->lock, &until);
+    list->idle--;
+    if (ret == ETIMEDOUT) break;
+  }
+  target_node = pop_order(list);
+  *closed = (target_node == NULL) && (list->closing || (list->dismiss > 0));
+  if ((target_node == NULL) && !list->closing && (list->dismiss > 0)) list->dismiss--;
+  pthread_mutex_unlock(&list->lock);
+
+  return target_node;
+}
+
+unsigned int order_left(OrderList *list)
+{
+  int ret;
+
+  pthread_mutex_lock(&list->lock);
+  ret = list->count;
+  pthread_mutex_unlock(&list->lock);
+
+  return ret;
+}
+
+/// @brief count the orders in the subheap at @a i that are made before an order with deadline
+///        @a deadline. Subheaps whose top is later are skipped; orders without a deadline come
+///        after all others anyway. The list lock must be held.
+static unsigned int count_before(OrderList *list, unsigned int i, uint64_t deadline)
+{
+  if ((i >= list->nheap) || (list->heap[i]->deadline > deadline)) return 0;
+
+  return 1 + count_before(list, 2 * i + 1, deadline) + count_before(list, 2 * i + 2, deadline);
+}
+
+unsigned int orders_before(OrderList *list, uint64_t deadline, unsigned int *idle)
+{
+  unsigned int ret;
+
+  pthread_mutex_lock(&list->lock);
+  ret = count_before(list, 0, deadline);
+  *idle = list->idle;
+  pthread_mutex_unlock(&list->lock);
+
+  return ret;
+}
+
+void dismiss_waiters(OrderList *list, unsigned int n)
+{
+  pthread_mutex_lock(&list->lock);
+  list->dismiss = n;
+  if (n > 0) pthread_cond_broadcast(&list->cond);
+  pthread_mutex_unlock(&list->lock);
+}
+
+void close_orders(OrderList *list)
+{
+  pthread_mutex_lock(&list->lock);
+  list->closing = true;
+  pthread_cond_broadcast(&list->cond);
+  pthread_mutex_unlock(&list->lock);
+}
+
+void append_str(char **str, size_t *str_len, size_t *str_cap, const char *s, size_t len)
+{
+  if (*str_len + len + 1 > *str_cap) {
+    size_t cap = *str_cap ? *str_cap : 64;
+    while (*str_len + len + 1 > cap) cap <<= 1;
+    *str = (char *)realloc(*str, cap);
+    *str_cap = cap;
+  }
+  memcpy(*str + *str_len, s, len);
+  *str_len += len;
+  (*str)[*str_len] = '\0';
+}
+
+void add_burger(Request *req, enum burger_type type)
+{
+  const char *name = menu->item[type].name;
+  size_t len = menu->item[type].len;
+
+  pthread_mutex_lock(&req->cond_mutex);
+  if (req->stream) {
+    // Wake up serving thread for the first burger not yet sent; it coalesces the following ones
+    if (req->ready_len == 0) wake_request(req);
+    append_str(&req->ready_str, &req->ready_len, &req->ready_cap, "ready: ", 7);
+    append_str(&req->ready_str, &req->ready_len, &req->ready_cap, name, len);
+    append_str(&req->ready_str, &req->ready_len, &req->ready_cap, "\n", 1);
+  }
+  // A request with an idempotency key keeps the list for a retry even when streamed
+  if (!req->stream || req->keyed) {
+    if (req->order_len > 0) append_str(&req->order_str, &req->order_len, &req->order_cap, " ", 1);
+    append_str(&req->order_str, &req->order_len, &req->order_cap, name, len);
+  }
+  pthread_mutex_unlock(&req->cond_mutex);
+}
+
+void make_burger(Node *order)
+{
+  usleep(menu->item[order->type].cook_ms * 1000);
+  add_burger(order->req, order->type);
+}
+
+void init_parser(Parser *p, Request *req)
+{
+  p->req = req;
+  p->token_len = 0;
+  p->count = 0;
+  p->total = 0;
+}
+
+enum parse_result parse_request(Parser *p, const char *buf, size_t len, size_t *pos)
+{
+  size_t i;
+
+  for (i = *pos; i < len; i++) {
+    char c = buf[i];
+
+    if (!isspace((unsigned char)c)) {
+      if (p->token_len == TOKEN_MAX) return PARSE_ERROR;
+      p->token[p->token_len++] = c;
+      continue;
+    }
+
+    if (p->token_len > 0) {
+      unsigned int len = p->token_len;
+
+      p->token[p->token_len] = '\0';
+      p->token_len = 0;
+
+      if (memchr(p->token, '=', len) != NULL) {
+        // options must precede the first burger
+        if ((p->total > 0) || (parse_option(p->req, p->token) < 0)) return PARSE_ERROR;
+      } else {
+        unsigned int type = menu_lookup(p->token, len);
+        if (type == MENU_MAX) return PARSE_ERROR;
+
+        p->types[p->count++] = type;
+        p->total++;
+      }
+    }
+
+    if (c == '\n') {
+      *pos = i + 1;
+      return PARSE_DONE;
+    }
+
+    if (p->count == ORDER_CHUNK) {
+      *pos = i + 1;
+      return PARSE_CHUNK;
+    }
+  }
+
+  *pos = i;
+  return PARSE_MORE;
+}
@@ -0,0 +1,279 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  order.h
+/// @brief Requests, order queue and request parser
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab split off from mcdonalds.c
+/// 2026/10/19 ARC lab deadlines of requests
+/// 2026/10/19 ARC lab cancel requests of customers who left
+/// 2026/10/19 ARC lab NUMA node of requests
+/// 2026/10/19 ARC lab requests restored from the journal
+/// 2026/10/19 ARC lab request arrival time for latency statistics
+/// 2026/10/19 ARC lab earliest-deadline-first order queue
+/// 2026/10/19 ARC lab dismiss idle kitchens
+/// 2026/10/19 ARC lab burgers from the menu, looked up by hash
+/// 2026/10/19 ARC lab idempotency key of a request
+/// 2026/10/19 ARC lab a request has one key
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __ORDER_H__
+#define __ORDER_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "burger.h"
+#include "timer.h"
+
+/// @name Structures
+/// @{
+
+/// @brief request of a single customer, shared by all of its order Nodes
+typedef struct __request {
+  unsigned int customerID;                                  ///< customer ID that requested
+  int clientfd;                                             ///< socket of the customer
+  pthread_cond_t cond;                                      ///< conditional variable
+  pthread_mutex_t cond_mutex;                               ///< mutex variable for conditional variable
+  char *order_str;                                          ///< string to be made by kitchen
+  size_t order_len;                                         ///< length of order_str
+  size_t order_cap;                                         ///< allocated size of order_str
+  char *ready_str;                                          ///< made but not yet sent burgers
+  size_t ready_len;                                         ///< length of ready_str
+  size_t ready_cap;                                         ///< allocated size of ready_str
+  unsigned int total_count;                                 ///< number of issued burgers
+  unsigned int remain_count;                                ///< number of remaining burgers
+  bool complete;                                            ///< all orders have been issued
+  bool throttled;                                           ///< serving thread waits for kitchen
+  bool stream;                                              ///< send burgers as soon as made
+  bool lost;                                                ///< connection to customer lost
+  bool expired;                                             ///< a deadline of the request expired
+  bool cancelled;                                           ///< nobody collects the burgers anymore
+  bool orphaned;                                            ///< serving thread left; freed by kitchen
+  bool recovered;                                           ///< restored from the journal
+  bool polling;                                             ///< serving thread waits on wake_fd
+  bool keyed;                                               ///< owns its idempotency key
+  int wake_fd;                                              ///< eventfd waking up the serving thread
+  int node;                                                 ///< NUMA node of the serving thread
+  uint64_t journal_lsn;                                     ///< journal position of the last order
+  uint64_t arrived_ns;                                      ///< time the customer arrived
+  uint64_t deadline_ns;                                     ///< time to be served by (0: none)
+  char key[TOKEN_MAX + 1];                                  ///< idempotency key ("": none)
+  Timer io_timer;                                           ///< deadline of a single receive/send
+  Timer deadline;                                           ///< deadline of the whole request
+} Request;
+
+/// @brief general node element to implement a singly-linked list
+typedef struct __node {
+  struct __node *next;                                      ///< pointer to next node
+  uint64_t deadline;                                        ///< deadline of the request (0: none)
+  uint64_t seq;                                             ///< issue order, breaks deadline ties
+  unsigned int customerID;                                  ///< customer ID that requested
+  enum burger_type type;                                    ///< requested burger type
+  Request *req;                                             ///< request the order belongs to
+} Node;
+
+/// @brief order data. Orders with a deadline are kept in a binary min-heap and made earliest
+///        deadline first, before all orders without a deadline. Those stay in a FIFO list.
+typedef struct __order_list {
+  Node *head;                                               ///< head of order list
+  Node *tail;                                               ///< tail of order list
+  unsigned int count;                                       ///< number of nodes in list and heap
+  Node **heap;                                              ///< orders with a deadline
+  unsigned int nheap;                                       ///< number of nodes in heap
+  unsigned int cap;                                         ///< allocated size of heap
+  uint64_t seq;                                             ///< sequence number of the next order
+  pthread_mutex_t lock;                                     ///< lock variable for order list
+  pthread_cond_t cond;                                      ///< signals new orders to the kitchen
+  unsigned int idle;                                        ///< kitchens waiting for orders
+  unsigned int dismiss;                                     ///< idle kitchens to send home
+  bool closing;                                             ///< kitchens stop once list is empty
+} OrderList;
+
+/// @brief result of parse_request()
+enum parse_result {
+  PARSE_MORE,                                               ///< data used up, request continues
+  PARSE_CHUNK,                                              ///< parsed a full chunk of burgers
+  PARSE_DONE,                                               ///< reached end of request
+  PARSE_ERROR                                               ///< unknown burger or invalid option
+};
+
+/// @brief incremental parser for requests that arrive in pieces
+typedef struct __parser {
+  Request *req;                                             ///< request receiving the options
+  char token[TOKEN_MAX + 1];                                ///< token, possibly split across pieces
+  unsigned int token_len;                                   ///< length of token
+  enum burger_type types[ORDER_CHUNK];                      ///< parsed burgers not yet issued
+  unsigned int count;                                       ///< number of burgers in types
+  unsigned int total;                                       ///< number of burgers parsed so far
+} Parser;
+
+/// @}
+
+/// @name Requests
+/// @{
+
+/// @brief Allocate and initialize the shared state of a request
+/// @param customerID customer ID
+/// @param clientfd socket of the customer
+/// @retval Request* new request without any orders
+Request* new_request(unsigned int customerID, int clientfd);
+
+/// @brief Release a request. Every order of the request must have been made.
+/// @param req request
+void free_request(Request *req);
+
+/// @brief Release a request whose orders may still be queued. If orders are left, the request
+///        is orphaned and the kitchen that finishes the last order releases it.
+/// @param req request
+void release_request(Request *req);
+
+/// @brief Wake up the serving thread of a request. Must be called with the cond_mutex of the
+///        request held.
+/// @param req request
+void wake_request(Request *req);
+
+/// @brief apply a request option (a `key=value` token) to a request
+/// @param req request
+/// @param option option token. Modified.
+/// @retval 0 on success
+/// @retval -1 unknown option, invalid value or a second key
+int parse_option(Request *req, char *option);
+
+/// @}
+
+/// @name Order queue
+/// @{
+
+/// @brief Initialize an empty OrderList
+/// @param list order list
+void init_orders(OrderList *list);
+
+/// @brief Enqueue elements in the OrderList. They are scheduled by the deadline of @a req.
+/// @param list order list
+/// @param req request the orders belong to
+/// @param types list of burger types
+/// @param burger_count number of burgers
+void issue_orders(OrderList *list, Request *req, enum burger_type *types,
+                  unsigned int burger_count);
+
+/// @brief Dequeue the order with the earliest deadline from the OrderList
+/// @param list order list
+/// @retval Node* Node from head of the list
+/// @retval NULL if the list is empty
+Node* get_order(OrderList *list);
+
+/// @brief Dequeue element from the OrderList, waiting for one if the list is empty
+/// @param list order list
+/// @retval Node* Node from head of the list
+/// @retval NULL if the list is closed and empty, or the caller is dismissed
+Node* wait_order(OrderList *list);
+
+/// @brief Dequeue element from the OrderList, waiting at most @a ms milliseconds for one
+/// @param list order list
+/// @param ms max. time to wait
+/// @param closed set if the list is closed and empty, or the caller is dismissed. Out parameter.
+/// @retval Node* Node from head of the list
+/// @retval NULL if no order arrived in time or the list is closed and empty
+Node* wait_order_for(OrderList *list, unsigned int ms, bool *closed);
+
+/// @brief Returns number of element left in OrderList
+/// @param list order list
+/// @retval number of element(s) in OrderList
+unsigned int order_left(OrderList *list);
+
+/// @brief Returns number of orders in OrderList that are made before an order with deadline
+///        @a deadline; O(number of such orders)
+/// @param list order list
+/// @param deadline deadline
+/// @param idle number of kitchens waiting for orders. Out parameter.
+/// @retval number of orders with a deadline not later than @a deadline
+unsigned int orders_before(OrderList *list, uint64_t deadline, unsigned int *idle);
+
+/// @brief Send @a n idle kitchens home: the next @a n callers that find the list empty in
+///        wait_order() or wait_order_for() return as if it was closed. Replaces any dismissals
+///        not taken yet; 0 cancels them.
+/// @param list order list
+/// @param n number of kitchens
+void dismiss_waiters(OrderList *list, unsigned int n);
+
+/// @brief Close the OrderList. Waiting kitchens return once the list is empty.
+/// @param list order list
+void close_orders(OrderList *list);
+
+/// @}
+
+/// @name Burgers
+/// @{
+
+/// @brief append @a len characters of @a s to a growable string. The string grows geometrically
+///        so that large requests do not copy the whole string for every burger.
+/// @param str string. In/out parameter.
+/// @param str_len length of string. In/out parameter.
+/// @param str_cap allocated size of string. In/out parameter.
+/// @param s characters to append
+/// @param len number of characters to append
+void append_str(char **str, size_t *str_len, size_t *str_cap, const char *s, size_t len);
+
+/// @brief hand a made burger to its request: append the burger name to order_str. Streamed
+///        requests instead queue a "ready: <burger>" line for the serving thread.
+/// @param req request
+/// @param type burger type
+void add_burger(Request *req, enum burger_type type);
+
+/// @brief "cook" burger of an order and add it to its request
+/// @param order Order Node
+void make_burger(Node *order);
+
+/// @}
+
+/// @name Request parser
+/// @{
+
+/// @brief Initialize a parser for a new request
+/// @param p parser
+/// @param req request receiving the options of the request
+void init_parser(Parser *p, Request *req);
+
+/// @brief parse the next piece of a request. The request is a '\n'-terminated line of burger
+///        names, optionally preceded by `key=value` options. Burger names may be split across
+///        pieces. Parsed burgers are collected in @a p->types; the caller hands them to the
+///        kitchen and resets @a p->count.
+/// @param p parser
+/// @param buf piece of the request
+/// @param len length of @a buf
+/// @param pos position in @a buf to continue at. In/out parameter.
+/// @retval PARSE_MORE  @a buf is used up and the request continues
+/// @retval PARSE_CHUNK ORDER_CHUNK burgers have been parsed; call again to continue at @a pos
+/// @retval PARSE_DONE  end of request reached
+/// @retval PARSE_ERROR unknown burger type or invalid option
+enum parse_result parse_request(Parser *p, const char *buf, size_t len, size_t *pos);
+
+/// @}
+
+#endif // __ORDER_H__
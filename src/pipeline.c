@@ -0,0 +1,454 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  pipeline.c
+/// @brief Pipelined kitchen: per-type stations of prep, grill and assemble stages
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab stations and stage times from the menu
+/// 2026/10/19 ARC lab static tracepoints and thread names for profiling
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "pipeline.h"
+#include "probe.h"
+
+/// @name Structures
+/// @{
+
+/// @brief single-producer single-consumer ring of orders. The consumer sleeps on tail while the
+///        ring is empty; the producer wakes it up only if it announced so in waiting.
+typedef struct __spsc {
+  Node *slots[PIPELINE_RING_SIZE];                          ///< orders
+  uint32_t head __attribute__((aligned(64)));               ///< next slot to pop (consumer)
+  uint32_t waiting;                                         ///< consumer sleeps or is about to
+  uint32_t tail __attribute__((aligned(64)));               ///< next slot to push (producer)
+  uint32_t closed;                                          ///< no more orders will be pushed
+} Spsc;
+
+/// @brief lane: a chain of one thread per stage. ring[s] feeds the thread of stage s.
+typedef struct __lane {
+  Spsc ring[STAGE_MAX];                                     ///< input of every stage
+  unsigned int inflight;                                    ///< orders in the lane
+  unsigned int station;                                     ///< station the lane serves
+  pthread_t thread[STAGE_MAX];                              ///< stage threads
+} Lane;
+
+/// @brief station: orders waiting for one of its lanes and their metrics
+typedef struct __station {
+  Node *head;                                               ///< first waiting order
+  Node *tail;                                               ///< last waiting order
+  unsigned int count;                                       ///< number of waiting orders
+  StationStats stats;                                       ///< metrics
+} Station;
+
+/// @brief argument of a stage thread
+typedef struct __stage_arg {
+  Lane *lane;                                               ///< lane of the thread
+  enum stage stage;                                         ///< stage of the thread
+} StageArg;
+
+/// @brief pipelined kitchen. Stations and the lane assignment belong to the dispatcher thread,
+///        which also runs the controller; metrics are read with atomics.
+struct pipeline {
+  OrderList *list;                                          ///< order list
+  pipeline_done_fn done;                                    ///< completion function
+  Lane *lanes;                                              ///< lanes
+  StageArg *args;                                           ///< arguments of the stage threads
+  unsigned int nlanes;                                      ///< number of lanes
+  Station stations[MENU_STATIONS];                          ///< stations of the menu
+  unsigned int pending;                                     ///< orders waiting in all stations
+  uint64_t balanced_ns;                                     ///< last run of the controller
+  pthread_t dispatcher;                                     ///< dispatcher thread
+};
+
+/// @}
+
+static struct pipeline pl;
+
+/// @brief current time
+/// @retval nanoseconds on CLOCK_MONOTONIC
+static uint64_t now_ns(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/// @brief wake up a thread sleeping on a futex word
+/// @param addr futex word
+static void futex_wake(uint32_t *addr)
+{
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/// @brief push an order into a ring. The caller makes sure the ring has room.
+/// @param r ring
+/// @param order order
+static void ring_push(Spsc *r, Node *order)
+{
+  uint32_t tail = r->tail;
+
+  r->slots[tail & (PIPELINE_RING_SIZE - 1)] = order;
+  __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+
+  // Pairs with the fence in ring_pop(): either the consumer sees the new tail, or we see that
+  // it waits
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&r->waiting, __ATOMIC_RELAXED)) futex_wake(&r->tail);
+}
+
+/// @brief close a ring; its consumer returns once the ring is empty
+/// @param r ring
+static void ring_close(Spsc *r)
+{
+  __atomic_store_n(&r->closed, 1, __ATOMIC_RELEASE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  futex_wake(&r->tail);
+}
+
+/// @brief pop an order from a ring; sleep while it is empty
+/// @param r ring
+/// @retval Node* order
+/// @retval NULL if the ring is empty and closed
+static Node* ring_pop(Spsc *r)
+{
+  uint32_t head = r->head, tail;
+  Node *order;
+
+  while (1) {
+    tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if (tail != head) {
+      order = r->slots[head & (PIPELINE_RING_SIZE - 1)];
+      __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+      return order;
+    }
+    if (__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) return NULL;
+
+    __atomic_store_n(&r->waiting, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if ((__atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == head) &&
+        !__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) {
+      syscall(SYS_futex, &r->tail, FUTEX_WAIT_PRIVATE, head, NULL, NULL, 0);
+    }
+    __atomic_store_n(&r->waiting, 0, __ATOMIC_RELAXED);
+  }
+}
+
+/// @brief stage thread: run one stage for every order of its input ring and pass the order on.
+///        The assemble stage, or any stage that finds the request cancelled, completes it.
+/// @param arg StageArg
+static void* stage_task(void *arg)
+{
+  StageArg *a = (StageArg *)arg;
+  Lane *lane = a->lane;
+  enum stage stage = a->stage;
+  Station *st;
+  Node *order;
+  uint64_t start;
+  bool skip;
+
+  pthread_setname_np(pthread_self(), stage == STAGE_PREP ? "mcd-prep" :
+                                     stage == STAGE_GRILL ? "mcd-grill" : "mcd-assemble");
+  while ((order = ring_pop(&lane->ring[stage])) != NULL) {
+    st = &pl.stations[menu->item[order->type].station];
+    skip = __atomic_load_n(&order->req->cancelled, __ATOMIC_ACQUIRE);
+    if (!skip) {
+      if (stage == STAGE_PREP) PROBE3(cook_start, order->customerID, order->type, -1);
+      PROBE3(stage_start, order->customerID, order->type, stage);
+      start = now_ns();
+      usleep(menu->item[order->type].stage_ms[stage] * 1000);
+      __atomic_add_fetch(&st->stats.busy_ns[stage], now_ns() - start, __ATOMIC_RELAXED);
+      PROBE3(stage_end, order->customerID, order->type, stage);
+
+      if (stage + 1 < STAGE_MAX) {
+        // Never full: a lane holds at most PIPELINE_LANE_DEPTH orders
+        ring_push(&lane->ring[stage + 1], order);
+        continue;
+      }
+      add_burger(order->req, order->type);
+      PROBE3(cook_end, order->customerID, order->type, -1);
+      __atomic_add_fetch(&st->stats.burgers, 1, __ATOMIC_RELAXED);
+    }
+
+    pl.done(order, skip);
+    __atomic_sub_fetch(&lane->inflight, 1, __ATOMIC_RELEASE);
+  }
+
+  if (stage + 1 < STAGE_MAX) ring_close(&lane->ring[stage + 1]);
+  return NULL;
+}
+
+/// @brief queue an order at the station of its burger
+/// @param order order
+static void queue_order(Node *order)
+{
+  Station *st = &pl.stations[menu->item[order->type].station];
+
+  order->next = NULL;
+  if (st->tail) st->tail->next = order;
+  else st->head = order;
+  st->tail = order;
+  st->count++;
+  pl.pending++;
+}
+
+/// @brief hand waiting orders to the least loaded lane of their station while lanes have room
+static void dispatch(void)
+{
+  Station *st;
+  Lane *best, *lane;
+  Node *order;
+  unsigned int s, i, load, best_load;
+
+  for (s = 0; s < menu->stations; s++) {
+    st = &pl.stations[s];
+    while (st->head) {
+      best = NULL;
+      best_load = PIPELINE_LANE_DEPTH;
+      for (i = 0; i < pl.nlanes; i++) {
+        lane = &pl.lanes[i];
+        if (lane->station != s) continue;
+        load = __atomic_load_n(&lane->inflight, __ATOMIC_ACQUIRE);
+        if (load < best_load) {
+          best = lane;
+          best_load = load;
+        }
+      }
+      if (best == NULL) break;
+
+      order = st->head;
+      st->head = order->next;
+      if (st->head == NULL) st->tail = NULL;
+      st->count--;
+      pl.pending--;
+      __atomic_add_fetch(&best->inflight, 1, __ATOMIC_RELAXED);
+      ring_push(&best->ring[STAGE_PREP], order);
+    }
+  }
+}
+
+/// @brief work of a station per lane: its backlog weighed by its slowest stage
+/// @param s station
+/// @param backlog orders waiting or in the lanes of the station
+/// @param lanes lanes of the station
+/// @retval work in ms per lane; DBL_MAX if the station has a backlog but no lane
+static double pressure(unsigned int s, unsigned int backlog, unsigned int lanes)
+{
+  if (backlog == 0) return 0;
+  if (lanes == 0) return DBL_MAX;
+  return (double)backlog * menu->station_ms[s] / lanes;
+}
+
+/// @brief controller: account lane time and move idle lanes from the station with the least
+///        work per lane to the one with the most, as long as that evens out the work
+static void balance(void)
+{
+  unsigned int backlog[MENU_STATIONS] = { 0 }, lanes[MENU_STATIONS] = { 0 };
+  unsigned int s, i, to, moves;
+  uint64_t now = now_ns();
+  double p, most, least, after;
+  Lane *lane, *donor;
+
+  for (s = 0; s < menu->stations; s++) backlog[s] = pl.stations[s].count;
+  for (i = 0; i < pl.nlanes; i++) {
+    lane = &pl.lanes[i];
+    backlog[lane->station] += __atomic_load_n(&lane->inflight, __ATOMIC_ACQUIRE);
+    lanes[lane->station]++;
+  }
+  for (s = 0; s < menu->stations; s++) {
+    __atomic_add_fetch(&pl.stations[s].stats.lane_ns, (now - pl.balanced_ns) * lanes[s],
+                       __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&pl.balanced_ns, now, __ATOMIC_RELAXED);
+
+  for (moves = 0; moves < pl.nlanes; moves++) {
+    // Station with the most work per lane
+    to = MENU_STATIONS;
+    most = 0;
+    for (s = 0; s < menu->stations; s++) {
+      p = pressure(s, backlog[s], lanes[s]);
+      if (p > most) {
+        to = s;
+        most = p;
+      }
+    }
+    if (to == MENU_STATIONS) break;
+
+    // Idle lane of the station that would have the least work per lane without it
+    donor = NULL;
+    least = DBL_MAX;
+    for (i = 0; i < pl.nlanes; i++) {
+      lane = &pl.lanes[i];
+      if ((lane->station == to) || (__atomic_load_n(&lane->inflight, __ATOMIC_ACQUIRE) > 0)) {
+        continue;
+      }
+      after = pressure(lane->station, backlog[lane->station], lanes[lane->station] - 1);
+      if (after < least) {
+        donor = lane;
+        least = after;
+      }
+    }
+    if ((donor == NULL) || (least >= pressure(to, backlog[to], lanes[to] + 1))) break;
+
+    lanes[donor->station]--;
+    lanes[to]++;
+    donor->station = to;
+  }
+
+  for (s = 0; s < menu->stations; s++) {
+    __atomic_store_n(&pl.stations[s].stats.lanes, lanes[s], __ATOMIC_RELAXED);
+    __atomic_store_n(&pl.stations[s].stats.backlog, backlog[s], __ATOMIC_RELAXED);
+  }
+}
+
+/// @brief dispatcher thread: move orders from the order list to the stations and from the
+///        stations to the lanes, and run the controller every PIPELINE_BALANCE_MS. While the
+///        stations back up, it polls every PIPELINE_POLL_MS for room in the lanes.
+/// @param dummy unused
+static void* dispatcher_task(void *dummy)
+{
+  struct timespec poll = { 0, PIPELINE_POLL_MS * 1000000L };
+  Node *order;
+  bool closed = false;
+  unsigned int i;
+
+  pthread_setname_np(pthread_self(), "mcd-dispatch");
+  while (!closed || (pl.pending > 0)) {
+    if (closed || (pl.pending >= PIPELINE_PENDING_MAX)) {
+      nanosleep(&poll, NULL);
+    } else if (pl.pending == 0) {
+      if ((order = wait_order(pl.list)) != NULL) queue_order(order);
+      else closed = true;
+    } else if ((order = wait_order_for(pl.list, PIPELINE_POLL_MS, &closed)) != NULL) {
+      queue_order(order);
+    }
+
+    // Take whatever else is ready without waiting
+    while (!closed && (pl.pending < PIPELINE_PENDING_MAX)) {
+      if ((order = get_order(pl.list)) == NULL) break;
+      queue_order(order);
+    }
+
+    if (now_ns() - pl.balanced_ns >= PIPELINE_BALANCE_MS * 1000000ULL) balance();
+    dispatch();
+  }
+
+  balance();
+  for (i = 0; i < pl.nlanes; i++) ring_close(&pl.lanes[i].ring[STAGE_PREP]);
+  return NULL;
+}
+
+int pipeline_start(OrderList *list, unsigned int threads, pipeline_done_fn done)
+{
+  unsigned int i, s;
+
+  memset(&pl, 0, sizeof(pl));
+  pl.list = list;
+  pl.done = done;
+  pl.nlanes = threads / STAGE_MAX;
+  if (pl.nlanes == 0) pl.nlanes = 1;
+  pl.lanes = (Lane *)aligned_alloc(64, sizeof(Lane) * pl.nlanes);
+  pl.args = (StageArg *)calloc(pl.nlanes * STAGE_MAX, sizeof(StageArg));
+  if ((pl.lanes == NULL) || (pl.args == NULL)) {
+    free(pl.lanes);
+    free(pl.args);
+    return -1;
+  }
+  memset(pl.lanes, 0, sizeof(Lane) * pl.nlanes);
+  pl.balanced_ns = now_ns();
+
+  // Spread the lanes evenly over the stations; the controller moves them where they are needed
+  for (i = 0; i < pl.nlanes; i++) {
+    pl.lanes[i].station = i % menu->stations;
+    pl.stations[i % menu->stations].stats.lanes++;
+    for (s = 0; s < STAGE_MAX; s++) {
+      pl.args[i * STAGE_MAX + s].lane = &pl.lanes[i];
+      pl.args[i * STAGE_MAX + s].stage = s;
+      if (pthread_create(&pl.lanes[i].thread[s], NULL, stage_task, &pl.args[i * STAGE_MAX + s])) {
+        perror("pthread_create");
+        exit(EXIT_FAILURE);
+      }
+    }
+  }
+
+  if (pthread_create(&pl.dispatcher, NULL, dispatcher_task, NULL)) {
+    perror("pthread_create");
+    exit(EXIT_FAILURE);
+  }
+
+  return 0;
+}
+
+void pipeline_join(void)
+{
+  unsigned int i, s;
+
+  pthread_join(pl.dispatcher, NULL);
+  for (i = 0; i < pl.nlanes; i++) {
+    for (s = 0; s < STAGE_MAX; s++) pthread_join(pl.lanes[i].thread[s], NULL);
+  }
+  free(pl.lanes);
+  free(pl.args);
+  pl.lanes = NULL;
+  pl.args = NULL;
+  pl.nlanes = 0;
+}
+
+void pipeline_stats(StationStats *s)
+{
+  unsigned int i, j;
+  uint64_t since = now_ns() - __atomic_load_n(&pl.balanced_ns, __ATOMIC_RELAXED);
+
+  // Lane time is accounted by the controller, which does not run while the dispatcher waits for
+  // orders; add the time since its last run
+  for (i = 0; i < menu->stations; i++) {
+    StationStats *st = &pl.stations[i].stats;
+
+    s[i].burgers = __atomic_load_n(&st->burgers, __ATOMIC_RELAXED);
+    for (j = 0; j < STAGE_MAX; j++) {
+      s[i].busy_ns[j] = __atomic_load_n(&st->busy_ns[j], __ATOMIC_RELAXED);
+    }
+    s[i].lanes = __atomic_load_n(&st->lanes, __ATOMIC_RELAXED);
+    s[i].lane_ns = __atomic_load_n(&st->lane_ns, __ATOMIC_RELAXED);
+    if (pl.nlanes > 0) s[i].lane_ns += since * s[i].lanes;
+    s[i].backlog = __atomic_load_n(&st->backlog, __ATOMIC_RELAXED);
+  }
+}
@@ -0,0 +1,94 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  pipeline.h
+/// @brief Pipelined kitchen: per-type stations of prep, grill and assemble stages
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab stations and stage times from the menu
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "burger.h"
+#include "menu.h"
+#include "order.h"
+
+/// @name Macro definitions
+/// @{
+
+#define PIPELINE_RING_SIZE 8                              ///< slots of a ring between stages
+#define PIPELINE_LANE_DEPTH 4                             ///< max. orders in a lane
+#define PIPELINE_PENDING_MAX 64                           ///< max. orders waiting in stations
+#define PIPELINE_POLL_MS 5                                ///< dispatcher interval while backed up
+#define PIPELINE_BALANCE_MS 100                           ///< controller interval
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief metrics of a station
+typedef struct __station_stats {
+  uint64_t burgers;                                         ///< burgers made
+  uint64_t busy_ns[STAGE_MAX];                              ///< time spent in every stage
+  uint64_t lane_ns;                                         ///< time lanes were assigned
+  unsigned int lanes;                                       ///< lanes assigned right now
+  unsigned int backlog;                                     ///< orders waiting or in its lanes
+} StationStats;
+
+/// @brief called for every order once it is made or skipped, on a stage thread
+/// @param order order. The function takes ownership.
+/// @param skip the order was dropped because its request was cancelled
+typedef void (*pipeline_done_fn)(Node *order, bool skip);
+
+/// @}
+
+/// @brief start the pipelined kitchen. A dispatcher takes orders from @a list in order and queues
+///        them at the station of their burger on the menu. A station owns lanes, each a chain of one
+///        thread per stage connected by single-producer single-consumer rings. Every
+///        PIPELINE_BALANCE_MS, a controller moves idle lanes to the station with the most work
+///        per lane.
+/// @param list order list
+/// @param threads number of stage threads; one lane takes STAGE_MAX of them
+/// @param done completion function
+/// @retval 0 on success
+/// @retval -1 on error
+int pipeline_start(OrderList *list, unsigned int threads, pipeline_done_fn done);
+
+/// @brief wait until the pipelined kitchen made all orders of the closed order list, and stop it
+void pipeline_join(void);
+
+/// @brief get the metrics of the stations
+/// @param s metrics, one per station of the menu. Out parameter.
+void pipeline_stats(StationStats *s);
+
+#endif // __PIPELINE_H__
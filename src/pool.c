@@ -0,0 +1,140 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  pool.c
+/// @brief Slab allocator and size-classed buffer pool
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+#include "lockprof.h"
+
+static Slab classes[POOL_CLASSES];                          ///< slab of every buffer class
+static pthread_once_t classes_once = PTHREAD_ONCE_INIT;
+
+void slab_init(Slab *s, size_t size)
+{
+  memset(s, 0, sizeof(*s));
+  // Every object must hold the link of the free list and keep its successor aligned
+  if (size < sizeof(void *)) size = sizeof(void *);
+  s->size = (size + 15) & ~(size_t)15;
+  pthread_mutex_init(&s->lock, NULL);
+}
+
+void* slab_alloc(Slab *s)
+{
+  size_t chunk, n, i;
+  char *p;
+
+  pthread_mutex_lock(&s->lock);
+  if (s->free == NULL) {
+    // Carve a new chunk into objects and put all of them on the free list
+    chunk = (s->size > SLAB_CHUNK) ? s->size : SLAB_CHUNK;
+    if ((p = (char *)malloc(chunk)) == NULL) {
+      pthread_mutex_unlock(&s->lock);
+      return NULL;
+    }
+    n = chunk / s->size;
+    for (i = 0; i < n; i++) {
+      *(void **)(p + i * s->size) = s->free;
+      s->free = p + i * s->size;
+    }
+    s->objects += n;
+  }
+  p = (char *)s->free;
+  s->free = *(void **)p;
+  s->used++;
+  pthread_mutex_unlock(&s->lock);
+
+  return p;
+}
+
+void slab_free(Slab *s, void *p)
+{
+  pthread_mutex_lock(&s->lock);
+  *(void **)p = s->free;
+  s->free = p;
+  s->used--;
+  pthread_mutex_unlock(&s->lock);
+}
+
+/// @brief set up the slabs of the buffer classes
+static void init_classes(void)
+{
+  int i;
+
+  for (i = 0; i < POOL_CLASSES; i++) slab_init(&classes[i], (size_t)1 << (POOL_MIN_SHIFT + i));
+}
+
+char* pool_alloc(size_t len, size_t *cap)
+{
+  int i;
+
+  pthread_once(&classes_once, init_classes);
+  for (i = 0; i < POOL_CLASSES; i++) {
+    if (len <= classes[i].size) {
+      *cap = classes[i].size;
+      return (char *)slab_alloc(&classes[i]);
+    }
+  }
+  *cap = len;
+  return (char *)malloc(len);
+}
+
+void pool_free(char *buf, size_t cap)
+{
+  int i;
+
+  if (buf == NULL) return;
+  for (i = 0; i < POOL_CLASSES; i++) {
+    if (cap == classes[i].size) {
+      slab_free(&classes[i], buf);
+      return;
+    }
+  }
+  free(buf);
+}
+
+void pool_stats(PoolStats *ps)
+{
+  int i;
+
+  pthread_once(&classes_once, init_classes);
+  ps->bytes = ps->used = 0;
+  for (i = 0; i < POOL_CLASSES; i++) {
+    pthread_mutex_lock(&classes[i].lock);
+    ps->bytes += classes[i].objects * classes[i].size;
+    ps->used += classes[i].used * classes[i].size;
+    pthread_mutex_unlock(&classes[i].lock);
+  }
+}
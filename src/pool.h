@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  pool.h
+/// @brief Slab allocator and size-classed buffer pool
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+#include <pthread.h>
+
+/// @name Macro definitions
+/// @{
+
+#define SLAB_CHUNK (64 * 1024)                            ///< bytes a slab grows by
+#define POOL_MIN_SHIFT 8                                  ///< smallest buffer class: 256 bytes
+#define POOL_CLASSES 9                                    ///< buffer classes: 256 bytes to 64 KB
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief slab of objects of a single size. Objects are carved from chunks of SLAB_CHUNK bytes
+///        and recycled through a free list; chunks are never returned to the system.
+typedef struct __slab {
+  size_t size;                                              ///< object size
+  void *free;                                               ///< free objects
+  size_t objects;                                           ///< objects carved so far
+  size_t used;                                              ///< objects handed out
+  pthread_mutex_t lock;                                     ///< lock variable for the slab
+} Slab;
+
+/// @brief memory use of the buffer pool
+typedef struct __pool_stats {
+  size_t bytes;                                             ///< bytes carved from chunks
+  size_t used;                                              ///< bytes lent out
+} PoolStats;
+
+/// @}
+
+/// @brief initialize a slab
+/// @param s slab
+/// @param size object size
+void slab_init(Slab *s, size_t size);
+
+/// @brief allocate an object from a slab
+/// @param s slab
+/// @retval void* uninitialized object
+/// @retval NULL if out of memory
+void* slab_alloc(Slab *s);
+
+/// @brief return an object to its slab
+/// @param s slab
+/// @param p object
+void slab_free(Slab *s, void *p);
+
+/// @brief lend a buffer of the smallest class that holds @a len bytes. Longer buffers than the
+///        largest class come from malloc().
+/// @param len min. size
+/// @param cap size of the buffer. Out parameter.
+/// @retval char* buffer
+/// @retval NULL if out of memory
+char* pool_alloc(size_t len, size_t *cap);
+
+/// @brief return a buffer lent by pool_alloc()
+/// @param buf buffer
+/// @param cap size of the buffer as returned by pool_alloc()
+void pool_free(char *buf, size_t cap);
+
+/// @brief get the memory use of the buffer pool
+/// @param ps memory use. Out parameter.
+void pool_stats(PoolStats *ps);
+
+#endif // __POOL_H__
@@ -0,0 +1,121 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  probe.h
+/// @brief Static tracepoints (USDT) for perf and bpftrace
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+#include <stdint.h>
+
+/// @name Static tracepoints
+/// PROBEn(name, args...) marks a point in the life of a customer or an order. The probe is a
+/// single nop plus a .note.stapsdt ELF note that tells perf and bpftrace where the nop is and
+/// where its arguments live, so a probe costs nothing until a tracer attaches to it:
+///
+///     perf probe -x ./mcdonalds sdt_mcdonalds:accept
+///     bpftrace -e 'usdt:./mcdonalds:mcdonalds:cook_end { @[arg1] = count(); }'
+///
+/// The provider is "mcdonalds"; every argument is passed as a signed 64-bit integer.
+/// systemtap's <sys/sdt.h> is used if it is installed. Otherwise, the note is emitted here in the
+/// same format on x86-64, and the probes vanish on other architectures or with -DNO_PROBES.
+/// @{
+#if !defined(NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define PROBE_SDT
+#endif
+#endif
+
+#if defined(NO_PROBES)
+
+#define PROBE0(name)             do {} while (0)
+#define PROBE1(name, a)          do { (void)(a); } while (0)
+#define PROBE2(name, a, b)       do { (void)(a); (void)(b); } while (0)
+#define PROBE3(name, a, b, c)    do { (void)(a); (void)(b); (void)(c); } while (0)
+
+#elif defined(PROBE_SDT)
+
+#include <sys/sdt.h>
+
+#define PROBE0(name)             DTRACE_PROBE(mcdonalds, name)
+#define PROBE1(name, a)          DTRACE_PROBE1(mcdonalds, name, (int64_t)(a))
+#define PROBE2(name, a, b)       DTRACE_PROBE2(mcdonalds, name, (int64_t)(a), (int64_t)(b))
+#define PROBE3(name, a, b, c)    DTRACE_PROBE3(mcdonalds, name, (int64_t)(a), (int64_t)(b), \
+                                               (int64_t)(c))
+
+#elif defined(__x86_64__)
+
+// Layout of the note as defined by systemtap: probe address, base address (to detect prelink
+// relocation), semaphore address (0: none), provider, name, and the argument locations in the
+// form "-8@<operand>" (signed, 8 bytes).
+#define PROBE_ASM(name, args, ...)                                                           \
+  __asm__ __volatile__("990: nop\n"                                                          \
+                       ".pushsection .note.stapsdt,\"\",\"note\"\n"                          \
+                       ".balign 4\n"                                                         \
+                       ".4byte 992f-991f, 994f-993f, 3\n"                                    \
+                       "991: .asciz \"stapsdt\"\n"                                           \
+                       "992: .balign 4\n"                                                    \
+                       "993: .8byte 990b\n"                                                  \
+                       ".8byte _.stapsdt.base\n"                                             \
+                       ".8byte 0\n"                                                          \
+                       ".asciz \"mcdonalds\"\n"                                              \
+                       ".asciz \"" #name "\"\n"                                              \
+                       ".asciz \"" args "\"\n"                                               \
+                       "994: .balign 4\n"                                                    \
+                       ".popsection\n"                                                       \
+                       ".ifndef _.stapsdt.base\n"                                            \
+                       ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+                       ".weak _.stapsdt.base\n"                                              \
+                       ".hidden _.stapsdt.base\n"                                            \
+                       "_.stapsdt.base: .space 1\n"                                          \
+                       ".size _.stapsdt.base, 1\n"                                           \
+                       ".popsection\n"                                                       \
+                       ".endif\n"                                                            \
+                       :: __VA_ARGS__)
+
+#define PROBE0(name)             PROBE_ASM(name, "")
+#define PROBE1(name, a)          PROBE_ASM(name, "-8@%0", "nor"((int64_t)(a)))
+#define PROBE2(name, a, b)       PROBE_ASM(name, "-8@%0 -8@%1", "nor"((int64_t)(a)), \
+                                           "nor"((int64_t)(b)))
+#define PROBE3(name, a, b, c)    PROBE_ASM(name, "-8@%0 -8@%1 -8@%2", "nor"((int64_t)(a)), \
+                                           "nor"((int64_t)(b)), "nor"((int64_t)(c)))
+
+#else
+
+#define PROBE0(name)             do {} while (0)
+#define PROBE1(name, a)          do { (void)(a); } while (0)
+#define PROBE2(name, a, b)       do { (void)(a); (void)(b); } while (0)
+#define PROBE3(name, a, b, c)    do { (void)(a); (void)(b); (void)(c); } while (0)
+
+#endif
+/// @}
+
+#endif // __PROBE_H__
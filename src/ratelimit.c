@@ -0,0 +1,365 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  ratelimit.c
+/// @brief Per-client token buckets for the admission of customers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab take no token from a bucket taken over for another client
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ratelimit.h"
+
+/// @name Macro definitions
+/// @{
+
+#define TOKEN 256                                           ///< fixed-point unit of a token
+#define TOKEN_BITS 24                                       ///< bits of the tokens in a bucket
+#define TOKEN_MASK ((1ULL << TOKEN_BITS) - 1)
+
+/// @}
+
+/// @brief bucket of a client. The claimer publishes the tag first and the client last (ready);
+///        a lookup racing with a claim may create a second bucket for the same client, which
+///        only splits its tokens.
+typedef struct __rate_slot {
+  uint64_t tag;                                             ///< hash of the client (0: free)
+  uint64_t bucket;                                          ///< last refill (ms) << TOKEN_BITS | tokens
+  uint64_t admitted;                                        ///< connections admitted
+  uint64_t rejected;                                        ///< connections over the limit
+  uint32_t ready;                                           ///< client is valid
+  RateClient client;                                        ///< client
+} RateSlot;
+
+static RateSlot table[RATE_SLOTS];                          ///< buckets, open addressing
+static uint64_t limit;                                      ///< rate << 32 | burst (0: no limit)
+static uint64_t rejected;                                   ///< connections over the limit
+static uint64_t untracked;                                  ///< admitted without a free bucket
+
+/// @brief milliseconds of the monotonic clock
+/// @retval milliseconds
+static uint64_t now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// @brief FNV-1a hash of a client, never 0
+/// @param c client
+/// @retval hash
+static uint64_t hash_client(const RateClient *c)
+{
+  const uint8_t *p = (const uint8_t *)c;
+  uint64_t h = 14695981039346656037ULL;
+  size_t i;
+
+  for (i = 0; i < sizeof(*c); i++) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h ? h : 1;
+}
+
+/// @brief identify the peer of a connection
+/// @param fd connected socket
+/// @param c client. Out parameter.
+/// @retval 0 on success
+/// @retval -1 if the peer cannot be identified
+static int peer_client(int fd, RateClient *c)
+{
+  struct sockaddr_storage ss;
+  socklen_t len = sizeof(ss);
+  struct ucred cred;
+  socklen_t clen = sizeof(cred);
+
+  memset(c, 0, sizeof(*c));
+  if (getpeername(fd, (struct sockaddr *)&ss, &len) < 0) return -1;
+
+  switch (ss.ss_family) {
+    case AF_INET:
+      memcpy(c->addr, &((struct sockaddr_in *)&ss)->sin_addr, 4);
+      break;
+    case AF_INET6:
+      memcpy(c->addr, &((struct sockaddr_in6 *)&ss)->sin6_addr, 16);
+      break;
+    case AF_UNIX:
+      // Local peers have no address; whoever runs them is the client
+      if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &clen) < 0) return -1;
+      memcpy(c->addr, &cred.uid, sizeof(cred.uid));
+      break;
+    default:
+      return -1;
+  }
+  c->family = ss.ss_family;
+  return 0;
+}
+
+/// @brief refill a bucket for the time since its last refill
+/// @param bucket bucket
+/// @param now current time (ms)
+/// @param rate tokens per second
+/// @param burst max. tokens
+/// @retval refilled bucket
+static uint64_t refill(uint64_t bucket, uint64_t now, uint64_t rate, uint64_t burst)
+{
+  uint64_t last = bucket >> TOKEN_BITS, tokens = bucket & TOKEN_MASK;
+  uint64_t full = burst * TOKEN, add;
+
+  if (now <= last) return (last << TOKEN_BITS) | ((tokens < full) ? tokens : full);
+
+  // Time is only used up as far as it turned into whole fractions of a token, so slow rates
+  // still refill when connections arrive more often than a fraction takes
+  add = ((now - last) >= RATE_BURST_MAX * 1000ULL) ? full : (now - last) * rate * TOKEN / 1000;
+  if (add == 0) return bucket;
+  tokens = (tokens + add < full) ? tokens + add : full;
+  return (now << TOKEN_BITS) | tokens;
+}
+
+/// @brief check that a bucket belongs to a client
+/// @param s bucket
+/// @param c client
+/// @param h hash of @a c
+/// @retval true if @a s is the bucket of @a c
+static bool owns(RateSlot *s, const RateClient *c, uint64_t h)
+{
+  return (__atomic_load_n(&s->tag, __ATOMIC_ACQUIRE) == h) &&
+         __atomic_load_n(&s->ready, __ATOMIC_ACQUIRE) && (memcmp(&s->client, c, sizeof(*c)) == 0);
+}
+
+/// @brief find the bucket of a client, or claim a free or idle one. Another thread may take the
+///        bucket over for another client at any time after it is returned.
+/// @param c client
+/// @param now current time (ms)
+/// @param rate tokens per second
+/// @param burst max. tokens
+/// @retval RateSlot* bucket
+/// @retval NULL if every probed bucket is in use
+static RateSlot* find_slot(const RateClient *c, uint64_t now, uint64_t rate, uint64_t burst)
+{
+  uint64_t h = hash_client(c), tag, bucket;
+  RateSlot *s, *idle = NULL;
+  unsigned int i;
+
+  for (i = 0; i < RATE_PROBE; i++) {
+    s = &table[(h + i) & (RATE_SLOTS - 1)];
+    tag = __atomic_load_n(&s->tag, __ATOMIC_ACQUIRE);
+    if (tag == h) {
+      if (owns(s, c, h)) return s;
+    } else if (tag == 0) {
+      if (!__atomic_compare_exchange_n(&s->tag, &tag, h, false, __ATOMIC_ACQ_REL,
+                                       __ATOMIC_ACQUIRE)) {
+        i--;                                                // claimed meanwhile: look again
+        continue;
+      }
+      goto claimed;
+    } else if ((idle == NULL) && __atomic_load_n(&s->ready, __ATOMIC_ACQUIRE)) {
+      // A bucket that refilled completely is as good as a new one
+      bucket = __atomic_load_n(&s->bucket, __ATOMIC_RELAXED);
+      if ((refill(bucket, now, rate, burst) & TOKEN_MASK) == burst * TOKEN) idle = s;
+    }
+  }
+
+  if (idle == NULL) return NULL;
+  s = idle;
+  tag = __atomic_load_n(&s->tag, __ATOMIC_ACQUIRE);
+  if (!__atomic_compare_exchange_n(&s->tag, &tag, h, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    return NULL;
+  }
+
+claimed:
+  __atomic_store_n(&s->ready, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&s->bucket, (now << TOKEN_BITS) | (burst * TOKEN), __ATOMIC_RELAXED);
+  __atomic_store_n(&s->admitted, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&s->rejected, 0, __ATOMIC_RELAXED);
+  s->client = *c;
+  __atomic_store_n(&s->ready, 1, __ATOMIC_RELEASE);
+  return s;
+}
+
+void rate_set(unsigned int rate, unsigned int burst)
+{
+  if (rate > RATE_MAX) rate = RATE_MAX;
+  if (burst == 0) burst = rate;
+  if (burst > RATE_BURST_MAX) burst = RATE_BURST_MAX;
+  __atomic_store_n(&limit, rate ? ((uint64_t)rate << 32) | burst : 0, __ATOMIC_RELEASE);
+}
+
+int rate_parse(const char *s, unsigned int *rate, unsigned int *burst)
+{
+  char *end;
+  long num;
+
+  num = strtol(s, &end, 10);
+  if ((end == s) || (num < 0) || (num > RATE_MAX)) return -1;
+  *rate = (unsigned int)num;
+  *burst = 0;
+  if (*end == ':') {
+    s = end + 1;
+    num = strtol(s, &end, 10);
+    if ((end == s) || (num <= 0) || (num > RATE_BURST_MAX)) return -1;
+    *burst = (unsigned int)num;
+  }
+  while ((*end == ' ') || (*end == '\t') || (*end == '\n') || (*end == '\r')) end++;
+  return (*end == '\0') ? 0 : -1;
+}
+
+int rate_load(const char *path)
+{
+  char line[128], *p;
+  unsigned int rate, burst;
+  FILE *f;
+  int ret = -1;
+
+  if ((f = fopen(path, "r")) == NULL) return -1;
+  errno = EINVAL;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    for (p = line; (*p == ' ') || (*p == '\t'); p++);
+    if ((*p == '#') || (*p == '\n') || (*p == '\0')) continue;
+    if (rate_parse(p, &rate, &burst) == 0) {
+      rate_set(rate, burst);
+      ret = 0;
+    }
+    break;
+  }
+  fclose(f);
+  return ret;
+}
+
+bool rate_admit(int fd)
+{
+  uint64_t l = __atomic_load_n(&limit, __ATOMIC_ACQUIRE), rate = l >> 32, burst = l & 0xffffffff;
+  uint64_t now, bucket, next, h, tokens;
+  RateClient c;
+  RateSlot *s;
+  bool taken;
+
+  if (l == 0) return true;
+  if (peer_client(fd, &c) < 0) return true;
+
+  now = now_ms();
+  h = hash_client(&c);
+
+  // An idle bucket may be taken over for another client between finding it and taking a token;
+  // the token then goes back and the client is looked up again
+  while (1) {
+    if ((s = find_slot(&c, now, rate, burst)) == NULL) {
+      __atomic_add_fetch(&untracked, 1, __ATOMIC_RELAXED);
+      return true;
+    }
+
+    bucket = __atomic_load_n(&s->bucket, __ATOMIC_RELAXED);
+    do {
+      next = refill(bucket, now, rate, burst);
+      if ((taken = ((next & TOKEN_MASK) >= TOKEN))) next -= TOKEN;
+    } while (taken && !__atomic_compare_exchange_n(&s->bucket, &bucket, next, true,
+                                                   __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    if (owns(s, &c, h)) break;
+    if (!taken) continue;
+
+    bucket = __atomic_load_n(&s->bucket, __ATOMIC_RELAXED);
+    do {
+      tokens = (bucket & TOKEN_MASK) + TOKEN;
+      next = (bucket & ~TOKEN_MASK) | ((tokens < burst * TOKEN) ? tokens : burst * TOKEN);
+    } while (!__atomic_compare_exchange_n(&s->bucket, &bucket, next, true, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+  }
+
+  if (!taken) {
+    __atomic_add_fetch(&s->rejected, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rejected, 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  __atomic_add_fetch(&s->admitted, 1, __ATOMIC_RELAXED);
+  return true;
+}
+
+void rate_stats(RateStats *rs)
+{
+  uint64_t l = __atomic_load_n(&limit, __ATOMIC_ACQUIRE), total;
+  RateTalker t;
+  RateSlot *s;
+  unsigned int i, j;
+
+  memset(rs, 0, sizeof(*rs));
+  rs->rate = l >> 32;
+  rs->burst = l & 0xffffffff;
+  rs->rejected = __atomic_load_n(&rejected, __ATOMIC_RELAXED);
+  rs->untracked = __atomic_load_n(&untracked, __ATOMIC_RELAXED);
+
+  // Keep the RATE_TOP clients with the most connections, most connections first
+  for (i = 0; i < RATE_SLOTS; i++) {
+    s = &table[i];
+    if (!__atomic_load_n(&s->ready, __ATOMIC_ACQUIRE)) continue;
+    rs->clients++;
+    t.client = s->client;
+    t.admitted = __atomic_load_n(&s->admitted, __ATOMIC_RELAXED);
+    t.rejected = __atomic_load_n(&s->rejected, __ATOMIC_RELAXED);
+    total = t.admitted + t.rejected;
+    if ((rs->ntop == RATE_TOP) &&
+        (total <= rs->top[RATE_TOP - 1].admitted + rs->top[RATE_TOP - 1].rejected)) continue;
+
+    j = (rs->ntop < RATE_TOP) ? rs->ntop++ : RATE_TOP - 1;
+    while ((j > 0) && (total > rs->top[j - 1].admitted + rs->top[j - 1].rejected)) {
+      rs->top[j] = rs->top[j - 1];
+      j--;
+    }
+    rs->top[j] = t;
+  }
+}
+
+char* rate_format(const RateClient *c, char *buf, unsigned int len)
+{
+  uint32_t uid;
+
+  switch (c->family) {
+    case AF_INET:
+    case AF_INET6:
+      if (inet_ntop(c->family, c->addr, buf, len) != NULL) break;
+      // fall through
+    default:
+      snprintf(buf, len, "?");
+      break;
+    case AF_UNIX:
+      memcpy(&uid, c->addr, sizeof(uid));
+      snprintf(buf, len, "uid %u", uid);
+      break;
+  }
+  return buf;
+}
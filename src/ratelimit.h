@@ -0,0 +1,120 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  ratelimit.h
+/// @brief Per-client token buckets for the admission of customers
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __RATELIMIT_H__
+#define __RATELIMIT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @name Macro definitions
+/// @{
+
+#define RATE_SLOTS 4096                                   ///< buckets in the table (power of 2)
+#define RATE_PROBE 16                                     ///< slots probed for a client
+#define RATE_MAX 1000000                                  ///< max. connections/s of a limit
+#define RATE_BURST_MAX 65535                              ///< max. burst of a limit
+#define RATE_TOP 8                                        ///< top talkers in the statistics
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief a client: the address of a TCP peer, or the user of a Unix domain socket peer
+typedef struct __rate_client {
+  uint32_t family;                                          ///< AF_INET, AF_INET6 or AF_UNIX
+  uint8_t addr[16];                                         ///< address; the uid for AF_UNIX
+} RateClient;
+
+/// @brief connections of one client
+typedef struct __rate_talker {
+  RateClient client;                                        ///< client
+  uint64_t admitted;                                        ///< connections admitted
+  uint64_t rejected;                                        ///< connections over the limit
+} RateTalker;
+
+/// @brief statistics of the rate limiter
+typedef struct __rate_stats {
+  unsigned int rate;                                        ///< connections/s per client (0: off)
+  unsigned int burst;                                       ///< bucket size
+  uint64_t rejected;                                        ///< connections over the limit
+  uint64_t untracked;                                       ///< admitted without a free bucket
+  unsigned int clients;                                     ///< clients in the table
+  unsigned int ntop;                                        ///< entries in top
+  RateTalker top[RATE_TOP];                                 ///< clients with most connections
+} RateStats;
+
+/// @}
+
+/// @brief set the limit of every client. Takes effect on the next connection; buckets keep their
+///        tokens, capped at the new burst.
+/// @param rate connections per second and client (0: no limit)
+/// @param burst connections a client may open at once (0: same as @a rate)
+void rate_set(unsigned int rate, unsigned int burst);
+
+/// @brief parse a limit of the form <rate>[:<burst>]
+/// @param s string
+/// @param rate connections per second. Out parameter.
+/// @param burst burst, 0 if not given. Out parameter.
+/// @retval 0 on success
+/// @retval -1 if @a s is not a valid limit
+int rate_parse(const char *s, unsigned int *rate, unsigned int *burst);
+
+/// @brief set the limit from a limits file: its first line that is neither empty nor a comment
+///        ('#') holds <rate>[:<burst>]
+/// @param path limits file
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code (EINVAL: invalid limit)
+int rate_load(const char *path);
+
+/// @brief take a token from the bucket of the peer of a connection. Without a limit, or for
+///        peers that are neither TCP nor Unix domain sockets, this costs no system call.
+///        Safe to call from several threads.
+/// @param fd connected socket
+/// @retval true if the connection is admitted
+/// @retval false if the peer is over its limit
+bool rate_admit(int fd);
+
+/// @brief get the statistics of the rate limiter and its top talkers
+/// @param rs statistics. Out parameter.
+void rate_stats(RateStats *rs);
+
+/// @brief format a client for printing
+/// @param c client
+/// @param buf buffer
+/// @param len size of @a buf (INET6_ADDRSTRLEN is enough)
+/// @retval buf
+char* rate_format(const RateClient *c, char *buf, unsigned int len);
+
+#endif // __RATELIMIT_H__
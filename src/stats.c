@@ -0,0 +1,314 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  stats.c
+/// @brief Live statistics in shared memory, published under a seqlock
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab names of burgers and stations
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stats.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief state of the publisher
+struct stats {
+  StatsShm *shm;                                            ///< mapped shared memory object
+  char name[256];                                           ///< name of the object
+  uint64_t ino;                                             ///< inode of the object
+  stats_gather_fn fn;                                       ///< gather function
+  void *data;                                               ///< user data for fn
+  enum stats_state state;                                   ///< published server state
+  struct timespec start;                                    ///< time the publisher started
+  pthread_mutex_t lock;                                     ///< lock variable for closing
+  pthread_cond_t wake;                                      ///< wakes up the publisher to close
+  pthread_t thread;                                         ///< publisher thread
+  bool started;                                             ///< publisher thread is running
+  bool closing;                                             ///< publisher thread stops
+};
+
+/// @}
+
+static struct stats st = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/// @brief gather a snapshot and publish it. Only the publisher thread, or the closing thread once
+///        the publisher stopped, writes; the seqlock needs no lock for a single writer.
+static void publish(void)
+{
+  StatsSnapshot s;
+  struct timespec now;
+  const uint64_t *src = (const uint64_t *)&s;
+  uint64_t *dst = (uint64_t *)&st.shm->snap;
+  uint64_t seq = st.shm->seq;
+  unsigned int i;
+
+  memset(&s, 0, sizeof(s));
+  s.pid = getpid();
+  s.state = __atomic_load_n(&st.state, __ATOMIC_RELAXED);
+  st.fn(&s, st.data);
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  s.uptime_ns = (now.tv_sec - st.start.tv_sec) * 1000000000ULL + now.tv_nsec - st.start.tv_nsec;
+
+  // Readers that see an odd sequence number, or a different one afterwards, retry
+  __atomic_store_n(&st.shm->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for (i = 0; i < sizeof(s) / sizeof(uint64_t); i++) __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+  __atomic_store_n(&st.shm->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/// @brief publisher thread: publish a snapshot every STATS_PUBLISH_MS until closing
+static void* stats_task(void *dummy)
+{
+  struct timespec next;
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+
+  pthread_mutex_lock(&st.lock);
+  while (!st.closing) {
+    pthread_mutex_unlock(&st.lock);
+    publish();
+    pthread_mutex_lock(&st.lock);
+
+    next.tv_nsec += STATS_PUBLISH_MS * 1000000L;
+    if (next.tv_nsec >= 1000000000L) {
+      next.tv_sec++;
+      next.tv_nsec -= 1000000000L;
+    }
+    while (!st.closing && (pthread_cond_timedwait(&st.wake, &st.lock, &next) != ETIMEDOUT));
+  }
+  pthread_mutex_unlock(&st.lock);
+
+  return NULL;
+}
+
+int stats_open(const char *name, const StatsLabels *labels, stats_gather_fn fn, void *data)
+{
+  pthread_condattr_t attr;
+  struct stat sb;
+  int fd;
+
+  if (st.shm != NULL) {
+    errno = EBUSY;
+    return -1;
+  }
+
+  // Replace the object of an earlier server; a server being taken over keeps its mapping
+  shm_unlink(name);
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) return -1;
+
+  if ((ftruncate(fd, sizeof(StatsShm)) < 0) || (fstat(fd, &sb) < 0)) goto error;
+  st.shm = mmap(NULL, sizeof(StatsShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (st.shm == MAP_FAILED) {
+    st.shm = NULL;
+    goto error;
+  }
+  close(fd);
+
+  strncpy(st.name, name, sizeof(st.name) - 1);
+  st.ino = sb.st_ino;
+  st.fn = fn;
+  st.data = data;
+  st.state = STATS_RUNNING;
+  st.closing = false;
+  clock_gettime(CLOCK_MONOTONIC, &st.start);
+
+  // Publish a first snapshot before readers can recognize the object
+  st.shm->size = sizeof(StatsShm);
+  memcpy(&st.shm->labels, labels, sizeof(StatsLabels));
+  publish();
+  __atomic_store_n(&st.shm->magic, STATS_MAGIC, __ATOMIC_RELEASE);
+
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&st.wake, &attr);
+  pthread_condattr_destroy(&attr);
+
+  if (pthread_create(&st.thread, NULL, stats_task, NULL) == 0) st.started = true;
+  else perror("stats thread");
+
+  return 0;
+
+error:
+  close(fd);
+  shm_unlink(name);
+  return -1;
+}
+
+void stats_draining(void)
+{
+  __atomic_store_n(&st.state, STATS_DRAINING, __ATOMIC_RELAXED);
+}
+
+void stats_close(void)
+{
+  if (st.shm == NULL) return;
+
+  if (st.started) {
+    pthread_mutex_lock(&st.lock);
+    st.closing = true;
+    pthread_cond_signal(&st.wake);
+    pthread_mutex_unlock(&st.lock);
+
+    pthread_join(st.thread, NULL);
+    st.started = false;
+  }
+
+  st.state = STATS_CLOSED;
+  publish();
+
+  // A new server that took over owns the name now
+  if (stats_ino(st.name) == st.ino) shm_unlink(st.name);
+  munmap(st.shm, sizeof(StatsShm));
+  st.shm = NULL;
+}
+
+const StatsShm* stats_attach(const char *name, uint64_t *ino)
+{
+  StatsShm *shm;
+  struct stat sb;
+  int fd, err;
+
+  fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) return NULL;
+
+  if (fstat(fd, &sb) < 0) {
+    close(fd);
+    return NULL;
+  }
+  if (sb.st_size < sizeof(StatsShm)) {
+    close(fd);
+    errno = EAGAIN;
+    return NULL;
+  }
+
+  shm = mmap(NULL, sizeof(StatsShm), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (shm == MAP_FAILED) return NULL;
+
+  // The server is still setting up the object, or it is of another layout
+  if ((__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != STATS_MAGIC) ||
+      (shm->size != sizeof(StatsShm))) {
+    err = (shm->magic == STATS_MAGIC) ? EPROTO : EAGAIN;
+    munmap(shm, sizeof(StatsShm));
+    errno = err;
+    return NULL;
+  }
+
+  if (ino) *ino = sb.st_ino;
+  return shm;
+}
+
+void stats_detach(const StatsShm *shm)
+{
+  munmap((void *)shm, sizeof(StatsShm));
+}
+
+uint64_t stats_ino(const char *name)
+{
+  struct stat sb;
+  int fd;
+
+  fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) return 0;
+  if (fstat(fd, &sb) < 0) sb.st_ino = 0;
+  close(fd);
+
+  return sb.st_ino;
+}
+
+void stats_read(const StatsShm *shm, StatsSnapshot *s)
+{
+  const uint64_t *src = (const uint64_t *)&shm->snap;
+  uint64_t *dst = (uint64_t *)s;
+  uint64_t seq;
+  unsigned int i;
+
+  while (1) {
+    seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) {
+      sched_yield();
+      continue;
+    }
+
+    for (i = 0; i < sizeof(*s) / sizeof(uint64_t); i++) {
+      dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == seq) break;
+  }
+}
+
+unsigned int stats_bucket(uint64_t us)
+{
+  uint64_t ms = us / 1000;
+  unsigned int b;
+
+  if (ms == 0) return 0;
+
+  b = 64 - __builtin_clzll(ms);
+  return (b < STATS_BUCKETS) ? b : STATS_BUCKETS - 1;
+}
+
+double stats_percentile(const uint64_t *hist, uint64_t count, double p)
+{
+  uint64_t rank, sum = 0;
+  unsigned int i;
+
+  if (count == 0) return 0;
+
+  rank = (uint64_t)(count * p / 100.0 + 0.999999);
+  if (rank == 0) rank = 1;
+
+  for (i = 0; i < STATS_BUCKETS - 1; i++) {
+    sum += hist[i];
+    if (sum >= rank) break;
+  }
+
+  return (double)(1ULL << i);
+}
@@ -0,0 +1,241 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  stats.h
+/// @brief Live statistics in shared memory, published under a seqlock
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab deadline hits and misses
+/// 2026/10/19 ARC lab station metrics of the pipelined kitchen
+/// 2026/10/19 ARC lab elastic kitchen pool
+/// 2026/10/19 ARC lab lobby and connection memory
+/// 2026/10/19 ARC lab counters per burger and station of the menu, with their names
+/// 2026/10/19 ARC lab rate limit and top talkers
+/// 2026/10/19 ARC lab most contended locks (LOCKPROF)
+/// 2026/10/19 ARC lab idempotency keys
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "burger.h"
+
+/// @name Macro definitions
+/// @{
+
+#define STATS_NAME "/mcdonalds.stats"                     ///< default shared memory object
+#define STATS_MAGIC 0x4d435354U                           ///< "MCST"
+#define STATS_PUBLISH_MS 100                              ///< publishing interval
+#define STATS_BUCKETS 24                                  ///< latency histogram buckets
+#define STATS_STAGES 3                                    ///< stages of the pipelined kitchen
+#define STATS_TALKERS 8                                   ///< top talkers of the rate limiter
+#define STATS_LOCKS 8                                     ///< most contended locks (LOCKPROF)
+#define STATS_LOCK_NAME 32                                ///< bytes of a lock name
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief state of the publishing server
+enum stats_state {
+  STATS_RUNNING = 1,                                        ///< accepting customers
+  STATS_DRAINING,                                           ///< serving the remaining customers
+  STATS_CLOSED                                              ///< server exited
+};
+
+/// @brief a snapshot of the server's counters. All fields are 64-bit words so that readers can
+///        copy the snapshot word by word without tearing a single field.
+///        Latency bucket 0 counts requests shorter than 1 ms, bucket i > 0 those of
+///        [2^(i-1), 2^i) ms; the last bucket takes everything longer.
+typedef struct __stats_snapshot {
+  uint64_t pid;                                             ///< process ID of the server
+  uint64_t state;                                           ///< enum stats_state
+  uint64_t uptime_ns;                                       ///< time since the server started
+  uint64_t customers;                                       ///< customers visited
+  uint64_t queueing;                                        ///< customers in the restaurant
+  uint64_t timeouts;                                        ///< customers timed out
+  uint64_t skipped;                                         ///< burgers not made for customers who left
+  uint64_t remote;                                          ///< orders made on another NUMA node
+  uint64_t stolen;                                          ///< orders taken from another pool
+  uint64_t recovered;                                       ///< requests restored from the journal
+  uint64_t burgers[MENU_MAX];                               ///< burgers made by types
+  uint64_t queued;                                          ///< orders waiting for a kitchen
+  uint64_t kitchens;                                        ///< number of kitchen threads
+  uint64_t kitchens_busy;                                   ///< kitchens making a burger right now
+  uint64_t busy_ns;                                         ///< total time kitchens spent cooking
+  uint64_t latency_count;                                   ///< finished requests
+  uint64_t latency_sum_us;                                  ///< total duration of finished requests
+  uint64_t latency_max_us;                                  ///< longest request
+  uint64_t latency_hist[STATS_BUCKETS];                     ///< request durations, log2 buckets
+  uint64_t journal_records;                                 ///< journal records appended
+  uint64_t journal_commits;                                 ///< journal group commits
+  uint64_t journal_sync_ns;                                 ///< time spent syncing the journal
+  uint64_t log_dropped;                                     ///< log records dropped
+  uint64_t rejected;                                        ///< requests whose deadline can't be met
+  uint64_t deadline_hits;                                   ///< requests served by their deadline
+  uint64_t deadline_misses;                                 ///< requests served after their deadline
+  uint64_t station_lanes[MENU_STATIONS];                    ///< lanes of every station (pipelined)
+  uint64_t station_backlog[MENU_STATIONS];                  ///< orders waiting or in a station's lanes
+  uint64_t station_lane_ns[MENU_STATIONS];                  ///< time lanes were assigned to a station
+  uint64_t station_busy_ns[MENU_STATIONS][STATS_STAGES];    ///< time a station spent in every stage
+  uint64_t kitchens_min;                                    ///< min. kitchens of the elastic pool
+  uint64_t kitchens_max;                                    ///< max. kitchens of the elastic pool
+  uint64_t kitchens_peak;                                   ///< max. kitchens running so far
+  uint64_t kitchen_ns;                                      ///< total time kitchens were running
+  uint64_t scale_ups;                                       ///< times the scaler added kitchens
+  uint64_t scale_downs;                                     ///< times the scaler dismissed kitchens
+  uint64_t orders;                                          ///< orders handed to the kitchen
+  uint64_t waiting;                                         ///< customers idle in the lobby
+  uint64_t walkouts;                                        ///< customers who left without ordering
+  uint64_t conns;                                           ///< connection structs in use
+  uint64_t pool_bytes;                                      ///< bytes of the receive buffer pool
+  uint64_t pool_used;                                       ///< bytes of receive buffers lent out
+  uint64_t rate_limit;                                      ///< connections/s per client (0: none)
+  uint64_t rate_burst;                                      ///< burst of the rate limit
+  uint64_t rate_rejected;                                   ///< connections over the rate limit
+  uint64_t rate_clients;                                    ///< clients with a token bucket
+  uint64_t talkers;                                         ///< top talkers in talker_*
+  uint64_t talker_family[STATS_TALKERS];                    ///< address family of a top talker
+  uint64_t talker_addr[STATS_TALKERS][2];                   ///< address of a top talker (RateClient)
+  uint64_t talker_admitted[STATS_TALKERS];                  ///< connections admitted of a top talker
+  uint64_t talker_rejected[STATS_TALKERS];                  ///< connections rejected of a top talker
+  uint64_t idem_keys;                                       ///< idempotency keys kept
+  uint64_t idem_inflight;                                   ///< keys of requests being made
+  uint64_t idem_hits;                                       ///< retries of a completed request
+  uint64_t idem_reattached;                                 ///< retries of a request in flight
+  uint64_t idem_abandoned;                                  ///< requests that failed with a key
+  uint64_t idem_evicted;                                    ///< results dropped before their TTL
+  uint64_t locks;                                           ///< profiled locks in lock_* (LOCKPROF)
+  uint64_t lock_name[STATS_LOCKS][STATS_LOCK_NAME / 8];     ///< name of a lock, NUL-padded
+  uint64_t lock_acquired[STATS_LOCKS];                      ///< acquisitions of a lock
+  uint64_t lock_contended[STATS_LOCKS];                     ///< acquisitions that had to wait
+  uint64_t lock_wait_ns[STATS_LOCKS];                       ///< total time waiting for a lock
+  uint64_t lock_wait_max_ns[STATS_LOCKS];                   ///< longest wait for a lock
+  uint64_t lock_hold_ns[STATS_LOCKS];                       ///< total time a lock was held (sampled)
+} StatsSnapshot;
+
+/// @brief names of the burgers and stations the counters refer to. They are written before the
+///        object is published and never change, so readers copy them without the seqlock.
+typedef struct __stats_labels {
+  uint32_t items;                                           ///< burgers on the menu
+  uint32_t stations;                                        ///< stations of the menu
+  char item[MENU_MAX][TOKEN_MAX + 1];                       ///< burger names
+  char station[MENU_STATIONS][TOKEN_MAX + 1];               ///< station names
+} StatsLabels;
+
+/// @brief layout of the shared memory object. The single writer makes seq odd, updates the
+///        snapshot and makes seq even again; readers retry until they copied the snapshot between
+///        two equal, even reads of seq.
+typedef struct __stats_shm {
+  uint32_t magic;                                           ///< STATS_MAGIC
+  uint32_t size;                                            ///< sizeof(StatsShm), checks the layout
+  uint64_t seq;                                             ///< sequence number of the seqlock
+  StatsSnapshot snap;                                       ///< published snapshot
+  StatsLabels labels;                                       ///< names of burgers and stations
+} StatsShm;
+
+/// @brief gather function: fills in a snapshot of the current counters
+/// @param s snapshot. pid and state are set already. Out parameter.
+/// @param data user data
+typedef void (*stats_gather_fn)(StatsSnapshot *s, void *data);
+
+/// @}
+
+/// @name Publisher
+/// @{
+
+/// @brief create the shared memory object @a name and start a publisher thread that calls @a fn
+///        every STATS_PUBLISH_MS and publishes the result. An object left by an earlier server is
+///        replaced; readers still mapping it keep the old one.
+/// @param name name of the shared memory object (see shm_open(3))
+/// @param labels names of the burgers and stations
+/// @param fn gather function
+/// @param data user data for @a fn
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code
+int stats_open(const char *name, const StatsLabels *labels, stats_gather_fn fn, void *data);
+
+/// @brief mark the server as draining in the published snapshots
+void stats_draining(void);
+
+/// @brief stop the publisher thread, publish a last snapshot marked closed and remove the shared
+///        memory object unless another server replaced it meanwhile
+void stats_close(void);
+
+/// @}
+
+/// @name Reader
+/// @{
+
+/// @brief map the shared memory object @a name read-only
+/// @param name name of the shared memory object
+/// @param ino inode of the object, to detect a replaced object. Out parameter (may be NULL).
+/// @retval StatsShm* mapped object
+/// @retval NULL on error, errno contains error code
+const StatsShm* stats_attach(const char *name, uint64_t *ino);
+
+/// @brief unmap an object mapped by stats_attach()
+/// @param shm mapped object
+void stats_detach(const StatsShm *shm);
+
+/// @brief get the inode of the shared memory object @a name
+/// @param name name of the shared memory object
+/// @retval inode
+/// @retval 0 if there is no such object
+uint64_t stats_ino(const char *name);
+
+/// @brief read a consistent snapshot. Never blocks the writer; retries while it publishes.
+/// @param shm mapped object
+/// @param s snapshot. Out parameter.
+void stats_read(const StatsShm *shm, StatsSnapshot *s);
+
+/// @}
+
+/// @name Latencies
+/// @{
+
+/// @brief latency histogram bucket of a duration
+/// @param us duration in microseconds
+/// @retval bucket index
+unsigned int stats_bucket(uint64_t us);
+
+/// @brief approximate percentile of a latency histogram: the upper bound of the bucket that holds
+///        it
+/// @param hist histogram
+/// @param count number of samples in @a hist
+/// @param p percentile (0-100)
+/// @retval latency in milliseconds
+/// @retval 0 if @a count is 0
+double stats_percentile(const uint64_t *hist, uint64_t count, double p);
+
+/// @}
+
+#endif // __STATS_H__
@@ -0,0 +1,266 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  timer.c
+/// @brief Hierarchical timer wheel
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "timer.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief timer wheel. Level l holds the timers that expire within TIMER_SLOTS^(l+1) ticks and
+///        is indexed by bits [l*TIMER_SLOT_BITS, (l+1)*TIMER_SLOT_BITS) of their expiry tick.
+///        Whenever level l wraps around, the next slot of level l+1 is cascaded down.
+struct timer_wheel {
+  Timer *slots[TIMER_LEVELS][TIMER_SLOTS];                  ///< timer lists
+  uint64_t now;                                             ///< next tick to process
+  unsigned int count;                                       ///< number of armed timers
+  Timer *running;                                           ///< timer whose function is running
+  struct timespec start;                                    ///< time of tick 0
+  pthread_mutex_t lock;                                     ///< lock variable for the wheel
+  pthread_cond_t armed;                                     ///< wakes up an idle timer thread
+  pthread_cond_t done;                                      ///< signals end of an expiry function
+  pthread_t thread;                                         ///< timer thread
+  bool started;                                             ///< timer thread has been started
+  bool closing;                                             ///< timer thread stops
+};
+
+/// @}
+
+static struct timer_wheel wheel = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .armed = PTHREAD_COND_INITIALIZER,
+  .done = PTHREAD_COND_INITIALIZER,
+};
+
+/// @brief number of ticks elapsed since the start of the wheel
+static uint64_t current_tick(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((ts.tv_sec - wheel.start.tv_sec) * 1000 + (ts.tv_nsec - wheel.start.tv_nsec) / 1000000)
+         / TIMER_TICK_MS;
+}
+
+/// @brief link a timer into the slot matching its expiry tick. Must be called with wheel.lock held.
+/// @param t timer
+static void link_timer(Timer *t)
+{
+  uint64_t delta = t->expires - wheel.now;
+  Timer **slot;
+  int level;
+
+  if ((int64_t)delta < 0) {
+    // Overdue; fire with the next tick
+    slot = &wheel.slots[0][wheel.now & (TIMER_SLOTS - 1)];
+  } else {
+    for (level = 0; level < TIMER_LEVELS - 1; level++) {
+      if (delta < (1ULL << ((level + 1) * TIMER_SLOT_BITS))) break;
+    }
+    if (delta >= (1ULL << (TIMER_LEVELS * TIMER_SLOT_BITS))) {
+      t->expires = wheel.now + (1ULL << (TIMER_LEVELS * TIMER_SLOT_BITS)) - 1;
+    }
+    slot = &wheel.slots[level][(t->expires >> (level * TIMER_SLOT_BITS)) & (TIMER_SLOTS - 1)];
+  }
+
+  t->next = *slot;
+  if (t->next) t->next->pprev = &t->next;
+  t->pprev = slot;
+  *slot = t;
+}
+
+/// @brief unlink a timer from its slot. Must be called with wheel.lock held.
+/// @param t timer
+static void unlink_timer(Timer *t)
+{
+  *t->pprev = t->next;
+  if (t->next) t->next->pprev = t->pprev;
+  t->next = NULL;
+  t->pprev = NULL;
+}
+
+/// @brief move the timers of a slot to lower levels
+/// @param level level of the slot
+/// @param index index of the slot
+/// @retval index of the slot
+static unsigned int cascade(int level, unsigned int index)
+{
+  Timer *t, *next;
+
+  t = wheel.slots[level][index];
+  wheel.slots[level][index] = NULL;
+  for (; t != NULL; t = next) {
+    next = t->next;
+    link_timer(t);
+  }
+
+  return index;
+}
+
+/// @brief process a single tick: cascade higher levels if level 0 wrapped around, then run the
+///        expiry functions of all timers of the current slot. Must be called with wheel.lock held;
+///        the lock is released while an expiry function runs.
+static void run_tick(void)
+{
+  unsigned int index = wheel.now & (TIMER_SLOTS - 1);
+  Timer *t;
+  int level;
+
+  for (level = 1; (level < TIMER_LEVELS) && (index == 0); level++) {
+    index = cascade(level, (wheel.now >> (level * TIMER_SLOT_BITS)) & (TIMER_SLOTS - 1));
+  }
+
+  index = wheel.now & (TIMER_SLOTS - 1);
+  wheel.now++;
+
+  while ((t = wheel.slots[0][index]) != NULL) {
+    unlink_timer(t);
+    t->pending = false;
+    wheel.count--;
+
+    wheel.running = t;
+    pthread_mutex_unlock(&wheel.lock);
+    t->fn(t);
+    pthread_mutex_lock(&wheel.lock);
+    wheel.running = NULL;
+    pthread_cond_broadcast(&wheel.done);
+  }
+}
+
+/// @brief timer thread: advance the wheel every tick while timers are armed
+static void* timer_task(void *dummy)
+{
+  struct timespec next;
+  uint64_t tick;
+
+  pthread_mutex_lock(&wheel.lock);
+  while (!wheel.closing) {
+    if (wheel.count == 0) {
+      pthread_cond_wait(&wheel.armed, &wheel.lock);
+      continue;
+    }
+
+    tick = current_tick();
+    while ((wheel.now <= tick) && !wheel.closing) run_tick();
+
+    // Sleep until the start of the next tick
+    next = wheel.start;
+    next.tv_sec += (wheel.now * TIMER_TICK_MS) / 1000;
+    next.tv_nsec += ((wheel.now * TIMER_TICK_MS) % 1000) * 1000000L;
+    if (next.tv_nsec >= 1000000000L) {
+      next.tv_sec++;
+      next.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_unlock(&wheel.lock);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+    pthread_mutex_lock(&wheel.lock);
+  }
+  pthread_mutex_unlock(&wheel.lock);
+
+  return NULL;
+}
+
+void timer_init(void)
+{
+  clock_gettime(CLOCK_MONOTONIC, &wheel.start);
+  wheel.now = 0;
+
+  if (pthread_create(&wheel.thread, NULL, timer_task, NULL) == 0) wheel.started = true;
+  else perror("timer thread");
+}
+
+void timer_close(void)
+{
+  if (!wheel.started) return;
+
+  pthread_mutex_lock(&wheel.lock);
+  wheel.closing = true;
+  pthread_cond_signal(&wheel.armed);
+  pthread_mutex_unlock(&wheel.lock);
+
+  pthread_join(wheel.thread, NULL);
+  wheel.started = false;
+}
+
+void timer_setup(Timer *t, timer_fn fn, void *data)
+{
+  memset(t, 0, sizeof(*t));
+  t->fn = fn;
+  t->data = data;
+}
+
+void timer_arm(Timer *t, unsigned int ms)
+{
+  pthread_mutex_lock(&wheel.lock);
+
+  if (t->pending) {
+    unlink_timer(t);
+    t->pending = false;
+    wheel.count--;
+  }
+
+  if (ms > 0) {
+    // The timer thread does not tick while the wheel is empty; catch up with the current time
+    if ((wheel.count == 0) && (current_tick() > wheel.now)) wheel.now = current_tick();
+
+    t->expires = wheel.now + (ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    link_timer(t);
+    t->pending = true;
+    if (wheel.count++ == 0) pthread_cond_signal(&wheel.armed);
+  }
+
+  pthread_mutex_unlock(&wheel.lock);
+}
+
+void timer_cancel(Timer *t)
+{
+  pthread_mutex_lock(&wheel.lock);
+
+  if (t->pending) {
+    unlink_timer(t);
+    t->pending = false;
+    wheel.count--;
+  }
+  while (wheel.running == t) pthread_cond_wait(&wheel.done, &wheel.lock);
+
+  pthread_mutex_unlock(&wheel.lock);
+}
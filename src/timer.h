@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  timer.h
+/// @brief Hierarchical timer wheel
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// @name Macro definitions
+/// @{
+
+#define TIMER_TICK_MS 10                                  ///< resolution of the timer wheel
+#define TIMER_LEVELS 4                                    ///< levels of the timer wheel
+#define TIMER_SLOT_BITS 6                                 ///< log2 of slots per level
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)                ///< slots per level
+
+/// @}
+
+/// @name Structures
+/// @{
+
+struct __timer;
+
+/// @brief expiry function of a timer; runs on the timer thread
+typedef void (*timer_fn)(struct __timer *t);
+
+/// @brief a timer. Embedded in the object it guards; the wheel allocates nothing.
+typedef struct __timer {
+  struct __timer *next;                                     ///< next timer in slot
+  struct __timer **pprev;                                   ///< link pointing to this timer
+  uint64_t expires;                                         ///< tick at which the timer fires
+  timer_fn fn;                                              ///< expiry function
+  void *data;                                               ///< user data for fn
+  bool pending;                                             ///< timer is armed
+} Timer;
+
+/// @}
+
+/// @brief start the timer thread
+void timer_init(void);
+
+/// @brief stop the timer thread. Pending timers do not fire anymore.
+void timer_close(void);
+
+/// @brief initialize a timer
+/// @param t timer
+/// @param fn expiry function
+/// @param data user data for @a fn
+void timer_setup(Timer *t, timer_fn fn, void *data);
+
+/// @brief (re-)arm a timer to fire in @a ms milliseconds. O(1).
+/// @param t timer
+/// @param ms time until expiry; 0 disarms the timer
+void timer_arm(Timer *t, unsigned int ms);
+
+/// @brief disarm a timer. O(1). If its expiry function is running, waits until it returned;
+///        afterwards the function is guaranteed not to run. Must not be called from within the
+///        expiry function of @a t.
+/// @param t timer
+void timer_cancel(Timer *t);
+
+#endif // __TIMER_H__
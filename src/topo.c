@@ -0,0 +1,365 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  topo.c
+/// @brief CPU/NUMA topology and thread placement
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <dirent.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+
+#include "topo.h"
+
+/// @name Structures
+/// @{
+
+/// @brief a usable CPU
+typedef struct __cpu {
+  int id;                                                   ///< CPU number
+  int node;                                                 ///< NUMA node index
+  int package;                                              ///< physical package (socket)
+  int core;                                                 ///< core within the package
+  int rank;                                                 ///< SMT sibling index within the core
+  int slot;                                                 ///< index among CPUs of equal node/rank
+} Cpu;
+
+/// @brief CPU and NUMA layout
+struct topology {
+  Cpu cpu[TOPO_CPU_MAX];                                    ///< usable CPUs in compact order
+  int ncpus;                                                ///< number of usable CPUs
+  int spread[TOPO_CPU_MAX];                                 ///< CPU numbers in spread order
+  int node_of[TOPO_CPU_MAX];                                ///< node index of every CPU number
+  cpu_set_t node_cpus[TOPO_NODE_MAX];                       ///< usable CPUs of every node
+  int node_id[TOPO_NODE_MAX];                               ///< sysfs node number of every node
+  int nnodes;                                               ///< number of nodes with usable CPUs
+};
+
+/// @}
+
+const char *placement_names[] = { "none", "compact", "spread", "node" };
+
+static struct topology topo = { .ncpus = 0, .nnodes = 0 };
+
+/// @brief read the first line of a sysfs file
+/// @param path file path
+/// @param buf output buffer
+/// @param len size of @a buf
+/// @retval 0 on success
+/// @retval -1 if the file cannot be read
+static int read_line(const char *path, char *buf, size_t len)
+{
+  FILE *f = fopen(path, "r");
+  int ret = -1;
+
+  if (f == NULL) return -1;
+  if (fgets(buf, len, f) != NULL) {
+    buf[strcspn(buf, "\n")] = '\0';
+    ret = 0;
+  }
+  fclose(f);
+
+  return ret;
+}
+
+/// @brief read an integer from a sysfs file
+/// @param path file path
+/// @param fallback value if the file cannot be read
+/// @retval integer
+static int read_int(const char *path, int fallback)
+{
+  char buf[32];
+
+  if (read_line(path, buf, sizeof(buf)) < 0) return fallback;
+  return atoi(buf);
+}
+
+/// @brief parse a CPU list ("0-3,8,10-11")
+/// @param list CPU list
+/// @param set parsed CPUs. Out parameter.
+static void parse_cpulist(const char *list, cpu_set_t *set)
+{
+  char *end;
+  long first, last;
+
+  CPU_ZERO(set);
+  while (*list) {
+    first = strtol(list, &end, 10);
+    if (end == list) break;
+    last = first;
+    if (*end == '-') {
+      list = end + 1;
+      last = strtol(list, &end, 10);
+    }
+    for (; (first <= last) && (first < TOPO_CPU_MAX); first++) CPU_SET(first, set);
+    list = (*end == ',') ? end + 1 : end;
+  }
+}
+
+/// @brief compare CPUs: node, package, core, sibling
+static int compare_compact(const void *a, const void *b)
+{
+  const Cpu *ca = (const Cpu *)a, *cb = (const Cpu *)b;
+
+  if (ca->node != cb->node) return ca->node - cb->node;
+  if (ca->package != cb->package) return ca->package - cb->package;
+  if (ca->core != cb->core) return ca->core - cb->core;
+  if (ca->rank != cb->rank) return ca->rank - cb->rank;
+  return ca->id - cb->id;
+}
+
+/// @brief compare CPUs: sibling, position within node, node
+static int compare_spread(const void *a, const void *b)
+{
+  const Cpu *ca = (const Cpu *)a, *cb = (const Cpu *)b;
+
+  if (ca->rank != cb->rank) return ca->rank - cb->rank;
+  if (ca->slot != cb->slot) return ca->slot - cb->slot;
+  return ca->node - cb->node;
+}
+
+/// @brief compare integers
+static int compare_int(const void *a, const void *b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+/// @brief find the usable NUMA nodes
+/// @param allowed CPUs the process may run on
+static void read_nodes(cpu_set_t *allowed)
+{
+  char path[300], buf[4096];
+  int ids[TOPO_NODE_MAX], n = 0, i, id;
+  struct dirent *ent;
+  cpu_set_t cpus;
+  DIR *dir;
+
+  dir = opendir("/sys/devices/system/node");
+  if (dir != NULL) {
+    while (((ent = readdir(dir)) != NULL) && (n < TOPO_NODE_MAX)) {
+      if (sscanf(ent->d_name, "node%d", &id) == 1) ids[n++] = id;
+    }
+    closedir(dir);
+  }
+  qsort(ids, n, sizeof(int), compare_int);
+
+  for (i = 0; i < n; i++) {
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+    if (read_line(path, buf, sizeof(buf)) < 0) continue;
+
+    parse_cpulist(buf, &cpus);
+    CPU_AND(&cpus, &cpus, allowed);
+    if (CPU_COUNT(&cpus) == 0) continue;
+
+    topo.node_id[topo.nnodes] = ids[i];
+    topo.node_cpus[topo.nnodes++] = cpus;
+  }
+
+  // No NUMA information: a single node
+  if (topo.nnodes == 0) {
+    topo.node_id[0] = 0;
+    topo.node_cpus[0] = *allowed;
+    topo.nnodes = 1;
+  }
+}
+
+void topo_init(void)
+{
+  static Cpu spread[TOPO_CPU_MAX];
+  char path[300];
+  cpu_set_t allowed;
+  Cpu *c;
+  int i, j, n;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) < 0) {
+    CPU_ZERO(&allowed);
+    for (i = 0; (i < sysconf(_SC_NPROCESSORS_ONLN)) && (i < TOPO_CPU_MAX); i++) CPU_SET(i, &allowed);
+  }
+
+  read_nodes(&allowed);
+
+  for (i = 0; i < TOPO_CPU_MAX; i++) {
+    topo.node_of[i] = 0;
+    for (j = 0; j < topo.nnodes; j++) {
+      if (CPU_ISSET(i, &topo.node_cpus[j])) topo.node_of[i] = j;
+    }
+    if (!CPU_ISSET(i, &allowed)) continue;
+
+    c = &topo.cpu[topo.ncpus++];
+    c->id = i;
+    c->node = topo.node_of[i];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", i);
+    c->package = read_int(path, 0);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", i);
+    c->core = read_int(path, i);
+
+    // SMT siblings share package and core; number them in order of their CPU numbers
+    c->rank = 0;
+    for (j = 0; j < topo.ncpus - 1; j++) {
+      if ((topo.cpu[j].package == c->package) && (topo.cpu[j].core == c->core)) c->rank++;
+    }
+  }
+
+  // Compact: all CPUs of a node, core by core, siblings next to each other
+  qsort(topo.cpu, topo.ncpus, sizeof(Cpu), compare_compact);
+
+  // Spread: one CPU of every core of every node first, alternating between nodes
+  for (i = 0; i < topo.ncpus; i++) {
+    for (n = 0, j = 0; j < i; j++) {
+      if ((topo.cpu[j].node == topo.cpu[i].node) && (topo.cpu[j].rank == topo.cpu[i].rank)) n++;
+    }
+    topo.cpu[i].slot = n;
+  }
+  memcpy(spread, topo.cpu, topo.ncpus * sizeof(Cpu));
+  qsort(spread, topo.ncpus, sizeof(Cpu), compare_spread);
+  for (i = 0; i < topo.ncpus; i++) topo.spread[i] = spread[i].id;
+}
+
+int topo_nodes(void)
+{
+  return (topo.nnodes > 0) ? topo.nnodes : 1;
+}
+
+int topo_cpus(void)
+{
+  return (topo.ncpus > 0) ? topo.ncpus : 1;
+}
+
+int topo_current_node(void)
+{
+  int cpu = sched_getcpu();
+
+  if ((cpu < 0) || (cpu >= TOPO_CPU_MAX)) return 0;
+  return topo.node_of[cpu];
+}
+
+int topo_parse_placement(const char *name)
+{
+  int i;
+
+  for (i = 0; i < PLACE_MAX; i++) {
+    if (strcasecmp(name, placement_names[i]) == 0) return i;
+  }
+
+  return -1;
+}
+
+int topo_place(pthread_attr_t *attr, enum placement policy, unsigned int index)
+{
+  cpu_set_t set;
+  int node = 0;
+
+  if ((policy == PLACE_NONE) || (topo.ncpus == 0)) return 0;
+
+  CPU_ZERO(&set);
+  switch (policy) {
+    case PLACE_COMPACT:
+      CPU_SET(topo.cpu[index % topo.ncpus].id, &set);
+      break;
+    case PLACE_SPREAD:
+      CPU_SET(topo.spread[index % topo.ncpus], &set);
+      break;
+    default:
+      node = index % topo.nnodes;
+      set = topo.node_cpus[node];
+      break;
+  }
+  pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+
+  return node;
+}
+
+void* topo_alloc_node(size_t size, int node)
+{
+  cpu_set_t saved;
+  bool pinned = false;
+  void *ptr;
+
+  // Run on the node while touching the pages
+  if ((topo.nnodes > 1) && (node < topo.nnodes) &&
+      (pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0)) {
+    pinned = (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &topo.node_cpus[node]) == 0);
+  }
+
+  ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ptr == MAP_FAILED) ptr = NULL;
+  else memset(ptr, 0, size);
+
+  if (pinned) pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+
+  return ptr;
+}
+
+void topo_free(void *ptr, size_t size)
+{
+  if (ptr != NULL) munmap(ptr, size);
+}
+
+/// @brief format a CPU set as a CPU list ("0-3,8")
+/// @param set CPU set
+/// @param buf output buffer
+/// @param len size of @a buf
+/// @retval length of the CPU list
+static size_t format_cpulist(cpu_set_t *set, char *buf, size_t len)
+{
+  size_t pos = 0;
+  int i, first;
+
+  buf[0] = '\0';
+  for (i = 0; (i < TOPO_CPU_MAX) && (pos < len); i++) {
+    if (!CPU_ISSET(i, set)) continue;
+    first = i;
+    while ((i + 1 < TOPO_CPU_MAX) && CPU_ISSET(i + 1, set)) i++;
+    if (first == i) pos += snprintf(buf + pos, len - pos, "%s%d", pos ? "," : "", i);
+    else pos += snprintf(buf + pos, len - pos, "%s%d-%d", pos ? "," : "", first, i);
+  }
+
+  return (pos < len) ? pos : len - 1;
+}
+
+void topo_describe(char *buf, size_t len)
+{
+  size_t pos;
+  int i;
+
+  pos = snprintf(buf, len, "%d CPU(s), %d node(s):", topo_cpus(), topo_nodes());
+  for (i = 0; (i < topo.nnodes) && (pos + 1 < len); i++) {
+    pos += snprintf(buf + pos, len - pos, " node%d=", topo.node_id[i]);
+    if (pos + 1 < len) pos += format_cpulist(&topo.node_cpus[i], buf + pos, len - pos);
+  }
+}
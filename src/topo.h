@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  topo.h
+/// @brief CPU/NUMA topology and thread placement
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __TOPO_H__
+#define __TOPO_H__
+
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+
+/// @name Macro definitions
+/// @{
+
+#define TOPO_CPU_MAX 1024                                 ///< max. number of CPUs
+#define TOPO_NODE_MAX 64                                  ///< max. number of NUMA nodes
+
+/// @}
+
+/// @brief thread placement policies
+enum placement {
+  PLACE_NONE,                                               ///< leave placement to the OS
+  PLACE_COMPACT,                                            ///< fill node by node, core by core
+  PLACE_SPREAD,                                             ///< alternate nodes, then cores
+  PLACE_NODE,                                               ///< per-node pools of threads
+  PLACE_MAX
+};
+
+extern const char *placement_names[];                     ///< placement policies as strings
+
+/// @brief read the CPU and NUMA layout from sysfs. CPUs outside of the affinity of the process
+///        are ignored. Without NUMA information, all CPUs form a single node.
+void topo_init(void);
+
+/// @brief number of NUMA nodes with usable CPUs
+/// @retval number of nodes; at least 1
+int topo_nodes(void);
+
+/// @brief number of usable CPUs
+/// @retval number of CPUs; at least 1
+int topo_cpus(void);
+
+/// @brief NUMA node of the CPU the calling thread runs on
+/// @retval node index in [0, topo_nodes())
+int topo_current_node(void);
+
+/// @brief map a placement policy name to its policy
+/// @param name policy name
+/// @retval placement policy or -1 if the name is unknown
+int topo_parse_placement(const char *name);
+
+/// @brief set the CPU affinity of the @a index-th thread of a group in a thread attribute
+/// @param attr thread attribute
+/// @param policy placement policy
+/// @param index index of the thread in its group
+/// @retval NUMA node of the thread for PLACE_NODE, 0 otherwise
+int topo_place(pthread_attr_t *attr, enum placement policy, unsigned int index);
+
+/// @brief allocate zeroed memory on a NUMA node. The pages are touched from a CPU of the node,
+///        so that first-touch allocation places them there.
+/// @param size size in bytes
+/// @param node NUMA node
+/// @retval pointer to the memory; release with topo_free()
+void* topo_alloc_node(size_t size, int node);
+
+/// @brief release memory allocated with topo_alloc_node()
+/// @param ptr pointer to the memory
+/// @param size size in bytes
+void topo_free(void *ptr, size_t size);
+
+/// @brief describe the topology in a string
+/// @param buf output buffer
+/// @param len size of @a buf
+void topo_describe(char *buf, size_t len);
+
+#endif // __TOPO_H__
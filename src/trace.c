@@ -0,0 +1,282 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  trace.c
+/// @brief Workload traces: record the requests of a server and load them for a replay
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+/// 2026/10/19 ARC lab lock contention profiler (LOCKPROF)
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "menu.h"
+#include "trace.h"
+#include "lockprof.h"
+
+/// @name Structures
+/// @{
+
+/// @brief state of the recording
+struct trace {
+  int fd;                                                   ///< trace file (-1: not recording)
+  uint64_t start_ns;                                        ///< start of the recording (monotonic)
+  char *buf;                                                ///< records not yet written
+  size_t len;                                               ///< bytes in buf
+  pthread_mutex_t lock;                                     ///< lock variable for buf and fd
+};
+
+/// @}
+
+const char *trace_outcome_names[TRACE_OUTCOME_MAX] = {
+  "served", "rejected", "invalid", "timeout", "left"
+};
+
+static struct trace tr = {
+  .fd = -1,
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/// @brief write all of a buffer
+/// @param fd file
+/// @param buf data
+/// @param len length of @a buf
+/// @retval 0 on success
+/// @retval -1 on error
+static int write_all(int fd, const char *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0) {
+    if ((n = write(fd, buf, len)) < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    buf += n;
+    len -= n;
+  }
+  return 0;
+}
+
+/// @brief write the buffered records. The lock must be held. A failed write stops the recording.
+static void flush_trace(void)
+{
+  if ((tr.len > 0) && (write_all(tr.fd, tr.buf, tr.len) < 0)) {
+    perror("trace");
+    close(tr.fd);
+    tr.fd = -1;
+  }
+  tr.len = 0;
+}
+
+int trace_open(const char *path)
+{
+  TraceHeader h;
+  struct timespec now;
+  char name[TRACE_NAME_SIZE];
+  unsigned int i;
+  int fd, err;
+
+  if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0) return -1;
+
+  memset(&h, 0, sizeof(h));
+  h.magic = TRACE_MAGIC;
+  h.version = TRACE_VERSION;
+  h.items = menu->items;
+  clock_gettime(CLOCK_REALTIME, &now);
+  h.start_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+  if (write_all(fd, (const char *)&h, sizeof(h)) < 0) goto error;
+
+  // The names make the trace independent of the menu file of the replaying client
+  for (i = 0; i < menu->items; i++) {
+    memset(name, 0, sizeof(name));
+    memcpy(name, menu->item[i].name, menu->item[i].len);
+    if (write_all(fd, name, sizeof(name)) < 0) goto error;
+  }
+
+  if ((tr.buf = (char *)malloc(TRACE_BUFFER)) == NULL) goto error;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  tr.start_ns = now.tv_sec * 1000000000ULL + now.tv_nsec;
+  tr.len = 0;
+  tr.fd = fd;
+  return 0;
+
+error:
+  err = errno;
+  close(fd);
+  errno = err;
+  return -1;
+}
+
+bool trace_enabled(void)
+{
+  return tr.fd >= 0;
+}
+
+void trace_request(TraceRecord *r, uint64_t arrived_ns, const unsigned int *mix)
+{
+  TraceMix m[MENU_MAX];
+  size_t len;
+  unsigned int i;
+
+  if (tr.fd < 0) return;
+
+  r->arrival_us = (arrived_ns > tr.start_ns) ? (arrived_ns - tr.start_ns) / 1000 : 0;
+  r->ntypes = 0;
+  for (i = 0; i < menu->items; i++) {
+    if (mix[i] == 0) continue;
+    m[r->ntypes].type = i;
+    m[r->ntypes++].count = mix[i];
+  }
+  len = sizeof(TraceRecord) + r->ntypes * sizeof(TraceMix);
+
+  // Records go out in large writes; a request costs a copy under the lock
+  pthread_mutex_lock(&tr.lock);
+  if (tr.fd >= 0) {
+    if (tr.len + len > TRACE_BUFFER) flush_trace();
+    memcpy(tr.buf + tr.len, r, sizeof(TraceRecord));
+    memcpy(tr.buf + tr.len + sizeof(TraceRecord), m, r->ntypes * sizeof(TraceMix));
+    tr.len += len;
+  }
+  pthread_mutex_unlock(&tr.lock);
+}
+
+void trace_close(void)
+{
+  pthread_mutex_lock(&tr.lock);
+  if (tr.fd >= 0) {
+    flush_trace();
+    if (tr.fd >= 0) close(tr.fd);
+    tr.fd = -1;
+  }
+  free(tr.buf);
+  tr.buf = NULL;
+  pthread_mutex_unlock(&tr.lock);
+}
+
+const TraceMix* trace_mix(const TraceRecord *r)
+{
+  return (const TraceMix *)(r + 1);
+}
+
+/// @brief compare two records by arrival, for qsort()
+static int compare_arrival(const void *a, const void *b)
+{
+  const TraceRecord *ra = *(const TraceRecord **)a, *rb = *(const TraceRecord **)b;
+
+  return (ra->arrival_us > rb->arrival_us) - (ra->arrival_us < rb->arrival_us);
+}
+
+int trace_load(const char *path, Trace *t)
+{
+  const TraceHeader *h;
+  const TraceRecord *r;
+  struct stat sb;
+  size_t off, cap = 0, i;
+  const TraceRecord **recs;
+  int fd, err;
+
+  memset(t, 0, sizeof(*t));
+  if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) return -1;
+  if (fstat(fd, &sb) < 0) {
+    err = errno;
+    close(fd);
+    errno = err;
+    return -1;
+  }
+  if ((size_t)sb.st_size < sizeof(TraceHeader)) {
+    close(fd);
+    errno = EINVAL;
+    return -1;
+  }
+  t->size = sb.st_size;
+  t->map = mmap(NULL, t->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (t->map == MAP_FAILED) {
+    t->map = NULL;
+    return -1;
+  }
+
+  h = (const TraceHeader *)t->map;
+  off = sizeof(TraceHeader) + (size_t)h->items * TRACE_NAME_SIZE;
+  if ((h->magic != TRACE_MAGIC) || (h->version != TRACE_VERSION) || (h->items > MENU_MAX) ||
+      (off > t->size)) {
+    goto invalid;
+  }
+  t->items = h->items;
+  t->names = (const char *)t->map + sizeof(TraceHeader);
+  for (i = 0; i < t->items; i++) {
+    if (memchr(t->names + i * TRACE_NAME_SIZE, '\0', TRACE_NAME_SIZE) == NULL) goto invalid;
+  }
+
+  // Index the records; a record cut off by a crash ends the trace
+  while (off + sizeof(TraceRecord) <= t->size) {
+    r = (const TraceRecord *)((const char *)t->map + off);
+    if (off + sizeof(TraceRecord) + r->ntypes * sizeof(TraceMix) > t->size) break;
+    for (i = 0; i < r->ntypes; i++) {
+      if (trace_mix(r)[i].type >= t->items) goto invalid;
+    }
+    if (r->outcome >= TRACE_OUTCOME_MAX) goto invalid;
+
+    if (t->count == cap) {
+      cap = cap ? cap * 2 : 1024;
+      if ((recs = (const TraceRecord **)realloc(t->records, cap * sizeof(*recs))) == NULL) {
+        trace_free(t);
+        errno = ENOMEM;
+        return -1;
+      }
+      t->records = recs;
+    }
+    t->records[t->count++] = r;
+    off += sizeof(TraceRecord) + r->ntypes * sizeof(TraceMix);
+  }
+
+  qsort(t->records, t->count, sizeof(*t->records), compare_arrival);
+  return 0;
+
+invalid:
+  trace_free(t);
+  errno = EINVAL;
+  return -1;
+}
+
+void trace_free(Trace *t)
+{
+  if (t->map) munmap(t->map, t->size);
+  free(t->records);
+  memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,159 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  trace.h
+/// @brief Workload traces: record the requests of a server and load them for a replay
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "burger.h"
+
+/// @name Macro definitions
+/// @{
+
+#define TRACE_MAGIC 0x5254434dU                           ///< "MCTR"
+#define TRACE_VERSION 1                                   ///< version of the file format
+#define TRACE_NAME_SIZE 40                                ///< bytes per burger name in the header
+#define TRACE_BUFFER (64 * 1024)                          ///< records buffered before a write
+
+/// @}
+
+/// @name Structures
+/// @{
+
+/// @brief outcome of a recorded request
+enum trace_outcome {
+  TRACE_SERVED,                                             ///< got its burgers
+  TRACE_REJECTED,                                           ///< deadline could not be met
+  TRACE_INVALID,                                            ///< unknown burger or invalid option
+  TRACE_TIMEOUT,                                            ///< ran into a deadline of the server
+  TRACE_LEFT,                                               ///< customer hung up
+  TRACE_OUTCOME_MAX
+};
+
+extern const char *trace_outcome_names[TRACE_OUTCOME_MAX];  ///< names of the outcomes
+
+/// @brief flags of a recorded request
+enum trace_flags {
+  TRACE_STREAM = 1,                                         ///< asked for a streamed response
+  TRACE_UNIX = 2,                                           ///< came in on the Unix domain socket
+};
+
+/// @brief header of a trace file. It is followed by the names of the burgers on the menu of the
+///        server (items * TRACE_NAME_SIZE bytes, NUL-padded), and then by the records. All fields
+///        are in host byte order.
+typedef struct __trace_header {
+  uint32_t magic;                                           ///< TRACE_MAGIC
+  uint16_t version;                                         ///< TRACE_VERSION
+  uint16_t items;                                           ///< burgers on the menu
+  uint64_t start_ns;                                        ///< start of the recording (realtime)
+} TraceHeader;
+
+/// @brief a recorded request, followed by @a ntypes TraceMix entries. Records are written when
+///        the request is over, so they are ordered by completion, not by arrival.
+typedef struct __trace_record {
+  uint64_t arrival_us;                                      ///< arrival since start of the trace
+  uint32_t customerID;                                      ///< customer ID on the server
+  uint32_t latency_us;                                      ///< arrival until the response was sent
+  uint32_t deadline_ms;                                     ///< deadline option (0: none)
+  uint8_t outcome;                                          ///< enum trace_outcome
+  uint8_t flags;                                            ///< enum trace_flags
+  uint16_t ntypes;                                          ///< number of TraceMix entries
+} TraceRecord;
+
+/// @brief burgers of one type in a recorded request
+typedef struct __trace_mix {
+  uint32_t type;                                            ///< burger type (index on the menu)
+  uint32_t count;                                           ///< number of burgers
+} TraceMix;
+
+/// @brief a loaded trace
+typedef struct __trace {
+  void *map;                                                ///< mapped trace file
+  size_t size;                                              ///< size of the mapping
+  unsigned int items;                                       ///< burgers on the recorded menu
+  const char *names;                                        ///< their names, TRACE_NAME_SIZE apart
+  const TraceRecord **records;                              ///< records by arrival
+  size_t count;                                             ///< number of records
+} Trace;
+
+/// @}
+
+/// @name Recording
+/// @{
+
+/// @brief start recording the requests of the server into the file @a path. The header names the
+///        burgers of the menu.
+/// @param path trace file; an existing file is replaced
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code
+int trace_open(const char *path);
+
+/// @brief true if requests are recorded
+bool trace_enabled(void);
+
+/// @brief record a request. No-op if the trace is not open.
+/// @param r record; arrival_us and ntypes are set here
+/// @param arrived_ns arrival of the request (CLOCK_MONOTONIC)
+/// @param mix burgers ordered, per burger type (MENU_MAX entries)
+void trace_request(TraceRecord *r, uint64_t arrived_ns, const unsigned int *mix);
+
+/// @brief write the buffered records and close the trace
+void trace_close(void);
+
+/// @}
+
+/// @name Replay
+/// @{
+
+/// @brief load and check a trace file
+/// @param path trace file
+/// @param t trace. Out parameter.
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code (EINVAL for an invalid file)
+int trace_load(const char *path, Trace *t);
+
+/// @brief burgers of a loaded record
+/// @param r record
+/// @retval TraceMix* its r->ntypes entries
+const TraceMix* trace_mix(const TraceRecord *r);
+
+/// @brief release a loaded trace
+/// @param t trace
+void trace_free(Trace *t);
+
+/// @}
+
+#endif // __TRACE_H__
@@ -0,0 +1,252 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  uring.c
+/// @brief Minimal io_uring interface on top of the raw system calls
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+
+/// @brief io_uring_setup() system call
+static int sys_setup(unsigned int entries, struct io_uring_params *p)
+{
+  return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+/// @brief io_uring_enter() system call
+static int sys_enter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+int uring_init(Uring *r, unsigned int entries)
+{
+  struct io_uring_params p;
+  void *sq, *cq, *sqes;
+
+  memset(r, 0, sizeof(*r));
+  memset(&p, 0, sizeof(p));
+
+  r->fd = sys_setup(entries, &p);
+  if (r->fd < 0) return -1;
+  r->features = p.features;
+
+  r->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+  r->cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (r->cq_ring_len > r->sq_ring_len) r->sq_ring_len = r->cq_ring_len;
+    r->cq_ring_len = 0;
+  }
+
+  sq = mmap(NULL, r->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+            IORING_OFF_SQ_RING);
+  if (sq == MAP_FAILED) goto fail;
+  r->sq_ring = sq;
+
+  if (r->cq_ring_len > 0) {
+    cq = mmap(NULL, r->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+              IORING_OFF_CQ_RING);
+    if (cq == MAP_FAILED) goto fail;
+    r->cq_ring = cq;
+  } else {
+    cq = sq;
+  }
+
+  r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd,
+              IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) goto fail;
+  r->sqes = (struct io_uring_sqe *)sqes;
+
+  r->sq_head = (unsigned int *)((char *)sq + p.sq_off.head);
+  r->sq_tail = (unsigned int *)((char *)sq + p.sq_off.tail);
+  r->sq_mask = (unsigned int *)((char *)sq + p.sq_off.ring_mask);
+  r->sq_array = (unsigned int *)((char *)sq + p.sq_off.array);
+  r->sq_entries = p.sq_entries;
+  r->sqe_tail = *r->sq_tail;
+
+  r->cq_head = (unsigned int *)((char *)cq + p.cq_off.head);
+  r->cq_tail = (unsigned int *)((char *)cq + p.cq_off.tail);
+  r->cq_mask = (unsigned int *)((char *)cq + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe *)((char *)cq + p.cq_off.cqes);
+
+  return 0;
+
+fail:
+  uring_exit(r);
+  return -1;
+}
+
+void uring_exit(Uring *r)
+{
+  if (r->sqes) munmap(r->sqes, r->sqes_len);
+  if (r->cq_ring) munmap(r->cq_ring, r->cq_ring_len);
+  if (r->sq_ring) munmap(r->sq_ring, r->sq_ring_len);
+  if (r->fd >= 0) close(r->fd);
+  memset(r, 0, sizeof(*r));
+  r->fd = -1;
+}
+
+struct io_uring_sqe* uring_get_sqe(Uring *r)
+{
+  unsigned int head = __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+  struct io_uring_sqe *sqe;
+  unsigned int index;
+
+  if (r->sqe_tail - head >= r->sq_entries) return NULL;
+
+  index = r->sqe_tail & *r->sq_mask;
+  sqe = &r->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  r->sq_array[index] = index;
+  r->sqe_tail++;
+
+  return sqe;
+}
+
+int uring_submit_and_wait(Uring *r, unsigned int wait_nr)
+{
+  unsigned int to_submit, ready;
+  int ret;
+
+  // Publish the prepared SQEs
+  __atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+
+  while (1) {
+    to_submit = r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+    ready = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE) - *r->cq_head;
+    if ((to_submit == 0) && (ready >= wait_nr)) return 0;
+
+    ret = sys_enter(r->fd, to_submit, wait_nr, (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0);
+    if (ret >= 0) {
+      if (wait_nr == 0) return 0;
+      continue;
+    }
+    // Interrupted by a signal: submit what is left and wait again
+    if ((errno != EINTR) && (errno != EAGAIN) && (errno != EBUSY)) return -1;
+  }
+}
+
+struct io_uring_cqe* uring_peek_cqe(Uring *r)
+{
+  unsigned int head = *r->cq_head;
+
+  if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+  return &r->cqes[head & *r->cq_mask];
+}
+
+void uring_cqe_seen(Uring *r)
+{
+  __atomic_store_n(r->cq_head, *r->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+int uring_register_buffers(Uring *r, const struct iovec *iov, unsigned int n)
+{
+  return (int)syscall(__NR_io_uring_register, r->fd, IORING_REGISTER_BUFFERS, iov, n);
+}
+
+void uring_prep_recv(struct io_uring_sqe *sqe, int fd, void *buf, size_t len, int flags)
+{
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = fd;
+  sqe->addr = (uintptr_t)buf;
+  sqe->len = len;
+  sqe->msg_flags = flags;
+}
+
+void uring_prep_send(struct io_uring_sqe *sqe, int fd, const void *buf, size_t len, int flags)
+{
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = fd;
+  sqe->addr = (uintptr_t)buf;
+  sqe->len = len;
+  sqe->msg_flags = flags;
+}
+
+void uring_prep_sendmsg(struct io_uring_sqe *sqe, int fd, const struct msghdr *msg, int flags)
+{
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = (uintptr_t)msg;
+  sqe->len = 1;
+  sqe->msg_flags = flags;
+}
+
+void uring_prep_read_fixed(struct io_uring_sqe *sqe, int fd, void *buf, size_t len, int index)
+{
+  sqe->opcode = IORING_OP_READ_FIXED;
+  sqe->fd = fd;
+  sqe->addr = (uintptr_t)buf;
+  sqe->len = len;
+  sqe->off = (uint64_t)-1;
+  sqe->buf_index = index;
+}
+
+void uring_prep_write_fixed(struct io_uring_sqe *sqe, int fd, const void *buf, size_t len,
+                            int index)
+{
+  sqe->opcode = IORING_OP_WRITE_FIXED;
+  sqe->fd = fd;
+  sqe->addr = (uintptr_t)buf;
+  sqe->len = len;
+  sqe->off = (uint64_t)-1;
+  sqe->buf_index = index;
+}
+
+void uring_prep_accept(struct io_uring_sqe *sqe, int fd, int flags, int multishot)
+{
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = fd;
+  sqe->accept_flags = flags;
+  if (multishot) sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+}
+
+void uring_prep_poll(struct io_uring_sqe *sqe, int fd, unsigned int events)
+{
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+}
+
+void uring_prep_cancel(struct io_uring_sqe *sqe, uint64_t user_data)
+{
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = user_data;
+}
@@ -0,0 +1,143 @@
+//--------------------------------------------------------------------------------------------------
+// Network Lab                             Spring 2024                           System Programming
+//
+/// @file  uring.h
+/// @brief Minimal io_uring interface on top of the raw system calls
+///
+/// @section changelog Change Log
+/// 2026/10/19 ARC lab created
+///
+/// @section license_section License
+/// Copyright (c) 2024-2026, Architecture and Code Optimization Laboratory, SNU
+/// All rights reserved.
+///
+/// Redistribution and use in source and binary forms, with or without modification, are permitted
+/// provided that the following conditions are met:
+///
+/// - Redistributions of source code must retain the above copyright notice, this list of condi-
+///   tions and the following disclaimer.
+/// - Redistributions in binary form must reproduce the above copyright notice, this list of condi-
+///   tions and the following disclaimer in the documentation and/or other materials provided with
+///   the distribution.
+///
+/// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+/// IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+/// CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,  INDIRECT, INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSE-
+/// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+/// LOSS OF USE, DATA,  OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED AND ON ANY THEORY OF
+/// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+/// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+/// DAMAGE.
+//--------------------------------------------------------------------------------------------------
+
+#ifndef __URING_H__
+#define __URING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+/// @name Structures
+/// @{
+
+/// @brief an io_uring instance with its mapped submission and completion queues
+typedef struct __uring {
+  int fd;                                                   ///< io_uring file descriptor
+  unsigned int features;                                    ///< IORING_FEAT_* of the kernel
+  unsigned int *sq_head;                                    ///< SQ head (kernel)
+  unsigned int *sq_tail;                                    ///< SQ tail (user)
+  unsigned int *sq_mask;                                    ///< SQ index mask
+  unsigned int *sq_array;                                   ///< SQ index array
+  unsigned int sq_entries;                                  ///< SQ size
+  unsigned int sqe_tail;                                    ///< next SQE to hand out
+  struct io_uring_sqe *sqes;                                ///< submission queue entries
+  unsigned int *cq_head;                                    ///< CQ head (user)
+  unsigned int *cq_tail;                                    ///< CQ tail (kernel)
+  unsigned int *cq_mask;                                    ///< CQ index mask
+  struct io_uring_cqe *cqes;                                ///< completion queue entries
+  void *sq_ring;                                            ///< mapping of the SQ ring
+  size_t sq_ring_len;                                       ///< length of sq_ring
+  void *cq_ring;                                            ///< mapping of the CQ ring
+  size_t cq_ring_len;                                       ///< length of cq_ring
+  size_t sqes_len;                                          ///< length of the SQE mapping
+} Uring;
+
+/// @}
+
+/// @brief set up an io_uring instance
+/// @param r io_uring. Out parameter.
+/// @param entries number of submission queue entries
+/// @retval 0 on success
+/// @retval -1 if io_uring is not available, errno contains error code
+int uring_init(Uring *r, unsigned int entries);
+
+/// @brief tear down an io_uring instance. Pending operations are cancelled.
+/// @param r io_uring
+void uring_exit(Uring *r);
+
+/// @brief get a zeroed submission queue entry
+/// @param r io_uring
+/// @retval SQE to fill in
+/// @retval NULL if the submission queue is full
+struct io_uring_sqe* uring_get_sqe(Uring *r);
+
+/// @brief submit all prepared SQEs and wait until at least @a wait_nr completions are available.
+///        Survives interrupts caused by signals.
+/// @param r io_uring
+/// @param wait_nr number of completions to wait for
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code
+int uring_submit_and_wait(Uring *r, unsigned int wait_nr);
+
+/// @brief get the next completion queue entry without waiting
+/// @param r io_uring
+/// @retval CQE; release it with uring_cqe_seen()
+/// @retval NULL if no completion is available
+struct io_uring_cqe* uring_peek_cqe(Uring *r);
+
+/// @brief release the completion queue entry returned by uring_peek_cqe()
+/// @param r io_uring
+void uring_cqe_seen(Uring *r);
+
+/// @brief register fixed buffers for IORING_OP_READ_FIXED/WRITE_FIXED
+/// @param r io_uring
+/// @param iov buffers
+/// @param n number of buffers
+/// @retval 0 on success
+/// @retval -1 on error, errno contains error code
+int uring_register_buffers(Uring *r, const struct iovec *iov, unsigned int n);
+
+/// @name Preparation of SQEs
+/// @{
+
+/// @brief receive from a socket (recv())
+void uring_prep_recv(struct io_uring_sqe *sqe, int fd, void *buf, size_t len, int flags);
+
+/// @brief send to a socket (send())
+void uring_prep_send(struct io_uring_sqe *sqe, int fd, const void *buf, size_t len, int flags);
+
+/// @brief send a message (sendmsg())
+void uring_prep_sendmsg(struct io_uring_sqe *sqe, int fd, const struct msghdr *msg, int flags);
+
+/// @brief read into a registered buffer
+void uring_prep_read_fixed(struct io_uring_sqe *sqe, int fd, void *buf, size_t len, int index);
+
+/// @brief write from a registered buffer
+void uring_prep_write_fixed(struct io_uring_sqe *sqe, int fd, const void *buf, size_t len,
+                            int index);
+
+/// @brief accept connections; a multishot accept keeps accepting until it is cancelled
+void uring_prep_accept(struct io_uring_sqe *sqe, int fd, int flags, int multishot);
+
+/// @brief wait for events on a file descriptor (poll(), one shot)
+void uring_prep_poll(struct io_uring_sqe *sqe, int fd, unsigned int events);
+
+/// @brief cancel the operation with user data @a user_data
+void uring_prep_cancel(struct io_uring_sqe *sqe, uint64_t user_data);
+
+/// @}
+
+#endif // __URING_H__